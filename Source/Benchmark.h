@@ -0,0 +1,377 @@
+/*
+  ==============================================================================
+
+    Benchmark.h
+    Created: 21 Oct 2026 6:20:45pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef BENCHMARK_H_INCLUDED
+#define BENCHMARK_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "BenchmarkFixtures.h"
+#include "Directory.h"
+#include "DownloadCache.h"
+#include "ZipExtractor.h"
+#include "DirectoryCopier.h"
+#include "JucerFile.h"
+#include "ModuleGenerator.h"
+#include "Settings.h"
+#include <algorithm>
+#include <functional>
+
+/**
+ * Times jpm's subsystems on synthetic fixtures - `jpm bench`.
+ *
+ *   directory.parse.cold   loading a directory with no index built
+ *   directory.parse.warm   loading it again with the index in place
+ *   directory.lookup       name and wildcard lookups in a loaded directory
+ *   cache.lookup           download cache hits
+ *   extract.zip            unpacking archives of different shapes
+ *   install.copy           copying an unpacked module into place
+ *   jucer.rebuild          loading a jucer, rewriting its modules and saving
+ *   genmodule.find         scanning a source tree for genmodule
+ *
+ * Fixtures are generated under the work folder, which also holds a download
+ * cache of its own so the real one isn't touched.  Each benchmark runs a
+ * number of times and the results, with min, median, mean and max, are
+ * printed and written as JSON for tracking regressions between builds.
+ */
+class Benchmark
+{
+public:
+    struct Options
+    {
+        File workFolder;
+        int iterations { 5 };
+        bool quick { false };
+        String filter { "*" };
+    };
+
+    struct Result
+    {
+        String name;
+        String fixture;
+        int64 items { 0 };
+        int64 bytes { 0 };
+        Array<double> samplesMs;
+
+        double getMin() const
+        {
+            return samplesMs.isEmpty() ? 0.0 : *std::min_element (samplesMs.begin(), samplesMs.end());
+        }
+
+        double getMax() const
+        {
+            return samplesMs.isEmpty() ? 0.0 : *std::max_element (samplesMs.begin(), samplesMs.end());
+        }
+
+        double getMean() const
+        {
+            double total = 0.0;
+
+            for (auto s : samplesMs)
+                total += s;
+
+            return samplesMs.isEmpty() ? 0.0 : total / samplesMs.size();
+        }
+
+        double getMedian() const
+        {
+            if (samplesMs.isEmpty())
+                return 0.0;
+
+            auto sorted = samplesMs;
+            std::sort (sorted.begin(), sorted.end());
+            const int n = sorted.size();
+            return (n % 2 == 1) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+        }
+    };
+
+    Benchmark (const Options& options_)
+        :
+        options (options_)
+    {}
+
+    void run()
+    {
+        options.workFolder.createDirectory();
+
+        benchmarkDirectory();
+        benchmarkCache();
+        benchmarkExtractAndCopy();
+        benchmarkJucer();
+        benchmarkGenmodule();
+    }
+
+    const Array<Result>& getResults() const
+    {
+        return results;
+    }
+
+    void printTable() const
+    {
+        std::cout << String ("benchmark").paddedRight (' ', 24)
+                  << String ("fixture").paddedRight (' ', 26)
+                  << String ("min ms").paddedLeft (' ', 10)
+                  << String ("median ms").paddedLeft (' ', 11)
+                  << String ("max ms").paddedLeft (' ', 10) << std::endl;
+
+        for (auto& r : results)
+        {
+            std::cout << r.name.paddedRight (' ', 24)
+                      << r.fixture.paddedRight (' ', 26)
+                      << String (r.getMin(), 2).paddedLeft (' ', 10)
+                      << String (r.getMedian(), 2).paddedLeft (' ', 11)
+                      << String (r.getMax(), 2).paddedLeft (' ', 10) << std::endl;
+        }
+    }
+
+    String toJson() const
+    {
+        auto* root = new DynamicObject();
+        root->setProperty ("schema", "jpm-bench");
+        root->setProperty ("schema_version", 1);
+        root->setProperty ("timestamp_ms", Time::currentTimeMillis());
+        root->setProperty ("os", SystemStats::getOperatingSystemName());
+        root->setProperty ("cpus", SystemStats::getNumCpus());
+        root->setProperty ("quick", options.quick);
+        root->setProperty ("iterations", options.iterations);
+
+        Array<var> list;
+
+        for (auto& r : results)
+        {
+            auto* o = new DynamicObject();
+            o->setProperty ("name", r.name);
+            o->setProperty ("fixture", r.fixture);
+            o->setProperty ("items", r.items);
+            o->setProperty ("bytes", r.bytes);
+            o->setProperty ("min_ms", r.getMin());
+            o->setProperty ("median_ms", r.getMedian());
+            o->setProperty ("mean_ms", r.getMean());
+            o->setProperty ("max_ms", r.getMax());
+
+            Array<var> samples;
+
+            for (auto s : r.samplesMs)
+                samples.add (s);
+
+            o->setProperty ("samples_ms", samples);
+            list.add (var (o));
+        }
+
+        root->setProperty ("results", list);
+        return JSON::toString (var (root));
+    }
+
+private:
+    typedef std::function<void()> Step;
+
+    bool isSelected (const String& name) const
+    {
+        return name.matchesWildcard (options.filter, true);
+    }
+
+    /** Runs body the configured number of times, running setup untimed before each. */
+    void measure (const String& name, const String& fixture, int64 items, int64 bytes, Step setup, Step body)
+    {
+        printInfo ("running " + name + " on " + fixture);
+
+        Result r;
+        r.name = name;
+        r.fixture = fixture;
+        r.items = items;
+        r.bytes = bytes;
+
+        for (int i = 0; i < options.iterations; ++i)
+        {
+            if (setup != nullptr)
+                setup();
+
+            const double start = Time::getMillisecondCounterHiRes();
+            body();
+            r.samplesMs.add (Time::getMillisecondCounterHiRes() - start);
+        }
+
+        results.add (r);
+    }
+
+    void benchmarkDirectory()
+    {
+        if (! isSelected ("directory.parse.cold") && ! isSelected ("directory.parse.warm")
+            && ! isSelected ("directory.lookup"))
+            return;
+
+        Array<int> sizes;
+        sizes.add (10);
+        sizes.add (1000);
+        sizes.add (options.quick ? 10000 : 100000);
+
+        auto cacheFolder = Settings::getInstance().getCacheFolder();
+
+        for (auto numModules : sizes)
+        {
+            auto file = BenchmarkFixtures::createDirectory (options.workFolder.getChildFile ("directory_" + String (numModules) + ".xml"),
+                                                            numModules);
+            auto fixture = String (numModules) + " modules";
+            StringArray locations (file.getFullPathName());
+
+            auto deleteIndex = [cacheFolder]()
+            {
+                Array<File> index;
+                cacheFolder.findChildFiles (index, File::findFiles, false, "directory.index*");
+
+                for (auto& f : index)
+                    f.deleteFile();
+            };
+
+            if (isSelected ("directory.parse.cold"))
+                measure ("directory.parse.cold", fixture, numModules, file.getSize(), deleteIndex,
+                         [&locations]() { Directory d (locations); });
+
+            if (isSelected ("directory.parse.warm"))
+            {
+                Directory prime (locations);
+                measure ("directory.parse.warm", fixture, numModules, file.getSize(), nullptr,
+                         [&locations]() { Directory d (locations); });
+            }
+
+            if (isSelected ("directory.lookup"))
+            {
+                Directory directory (locations);
+                Random random (numModules);
+                StringArray names;
+
+                for (int i = 0; i < numLookups; ++i)
+                    names.add (BenchmarkFixtures::getModuleName (random.nextInt (numModules)));
+
+                measure ("directory.lookup", fixture, numLookups + 10, 0, nullptr, [&]()
+                {
+                    for (auto& n : names)
+                        directory.getModulesByName (n);
+
+                    for (int i = 0; i < 10; ++i)
+                        directory.getModulesByName ("bm_mod_" + String (i) + "*");
+                });
+            }
+        }
+    }
+
+    void benchmarkCache()
+    {
+        if (! isSelected ("cache.lookup"))
+            return;
+
+        DownloadCache cache;
+        Array<URL> urls;
+
+        for (int i = 0; i < numCacheEntries; ++i)
+        {
+            URL url ("https://bench.invalid/repo_" + String (i) + "/archive/master.zip");
+            cache.getCachedFileLocation (url).getChildFile ("repo-master").createDirectory();
+            urls.add (url);
+        }
+
+        measure ("cache.lookup", String (numCacheEntries) + " entries", numCacheEntries, 0, nullptr, [&]()
+        {
+            for (auto& url : urls)
+                cache.downloadUrlAndUncompress (url);
+        });
+    }
+
+    void benchmarkExtractAndCopy()
+    {
+        if (! isSelected ("extract.zip") && ! isSelected ("install.copy"))
+            return;
+
+        for (auto& shape : BenchmarkFixtures::getArchiveShapes (options.quick))
+        {
+            auto zip = BenchmarkFixtures::createZip (options.workFolder.getChildFile ("archive_" + shape.name + ".zip"), shape);
+            auto extracted = options.workFolder.getChildFile ("extracted_" + shape.name);
+            auto installed = options.workFolder.getChildFile ("installed_" + shape.name);
+            auto fixture = shape.name + " " + String (shape.numFiles) + " files";
+            const int64 bytes = (int64) shape.numFiles * shape.fileSize;
+
+            if (isSelected ("extract.zip"))
+                measure ("extract.zip", fixture, shape.numFiles, bytes,
+                         [extracted]() { extracted.deleteRecursively(); },
+                         [zip, extracted]() { ZipExtractor().extract (zip, extracted); });
+
+            if (isSelected ("install.copy"))
+            {
+                if (! extracted.isDirectory())
+                    ZipExtractor().extract (zip, extracted);
+
+                auto module = extracted.getChildFile ("repo-master/modules/bm_mod_0");
+
+                measure ("install.copy", fixture, shape.numFiles, bytes,
+                         [installed]() { installed.deleteRecursively(); },
+                         [module, installed]() { DirectoryCopier().copy (module, installed); });
+            }
+        }
+    }
+
+    void benchmarkJucer()
+    {
+        if (! isSelected ("jucer.rebuild"))
+            return;
+
+        Array<int> sizes;
+        sizes.add (1000);
+
+        if (! options.quick)
+            sizes.add (10000);
+
+        for (auto numFiles : sizes)
+        {
+            auto fixtureFile = BenchmarkFixtures::createJucer (options.workFolder.getChildFile ("fixture_" + String (numFiles) + ".jucer"),
+                                                               numFiles, numExporters);
+            auto target = options.workFolder.getChildFile ("bench.jucer");
+
+            measure ("jucer.rebuild", String (numFiles) + " files " + String (numExporters) + " exporters",
+                     numFiles, fixtureFile.getSize(),
+                     [fixtureFile, target]() { fixtureFile.copyFileTo (target); },
+                     [target]()
+            {
+                JucerFile jucer;
+                jucer.setFile (target);
+                jucer.clearModules();
+
+                for (int m = 0; m < 40; ++m)
+                    jucer.addModule (BenchmarkFixtures::getModuleName (m));
+
+                jucer.save();
+            });
+        }
+    }
+
+    void benchmarkGenmodule()
+    {
+        if (! isSelected ("genmodule.find"))
+            return;
+
+        const int numFiles = options.quick ? 2000 : 20000;
+        auto tree = BenchmarkFixtures::createSourceTree (options.workFolder.getChildFile ("source_tree"), numFiles, 5);
+
+        measure ("genmodule.find", String (numFiles) + " files", numFiles, 0, nullptr, [tree]()
+        {
+            ModuleGenerator generator;
+            File folder (tree);
+            generator.findSourceFiles (folder);
+        });
+    }
+
+    static const int numLookups = 1000;
+    static const int numCacheEntries = 500;
+    static const int numExporters = 12;
+
+    Options options;
+    Array<Result> results;
+};
+
+#endif  // BENCHMARK_H_INCLUDED
@@ -0,0 +1,331 @@
+/*
+  ==============================================================================
+
+    BenchmarkFixtures.h
+    Created: 21 Oct 2026 5:47:03pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef BENCHMARKFIXTURES_H_INCLUDED
+#define BENCHMARKFIXTURES_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+
+/**
+ * Generates the synthetic inputs the benchmarks run on.  Everything is made
+ * from a fixed seed, so the same arguments always produce the same bytes
+ * and results from different runs can be compared.
+ */
+class BenchmarkFixtures
+{
+public:
+    /** The shape of a generated archive or source tree. */
+    struct TreeShape
+    {
+        String name;
+        int numFiles;
+        int fileSize;
+        int depth;
+    };
+
+    /**
+     * A directory in the jpm_directory.xml format with numModules modules
+     * called bm_mod_0, bm_mod_1 ... spread over repos bm_repo_0, bm_repo_1 ...
+     * at /bench/repo_0/ and so on.
+     */
+    static File createDirectory (const File& file, int numModules, int modulesPerRepo = 50)
+    {
+        String xml;
+        xml.preallocateBytes ((size_t) numModules * 160);
+        xml << "<jpm_directory version=\"1\">\n";
+
+        for (int m = 0; m < numModules; ++m)
+        {
+            const int repo = m / modulesPerRepo;
+
+            if (m % modulesPerRepo == 0)
+            {
+                if (m > 0)
+                    xml << "  </repo>\n";
+
+                xml << "  <repo shortname=\"bm_repo_" << repo << "\" path=\"/bench/repo_" << repo
+                    << "/\" source=\"GitHub\">\n";
+            }
+
+            xml << "    <module name=\"" << getModuleName (m) << "\" description=\"Synthetic module " << m
+                << " for benchmarking\" subpath=\"modules/" << getModuleName (m) << "\"/>\n";
+        }
+
+        if (numModules > 0)
+            xml << "  </repo>\n";
+
+        xml << "</jpm_directory>\n";
+
+        file.getParentDirectory().createDirectory();
+        file.replaceWithText (xml);
+        return file;
+    }
+
+    static String getModuleName (int index)
+    {
+        return "bm_mod_" + String (index);
+    }
+
+    /**
+     * A jucer file with numFiles FILE entries spread over groups of 100, and
+     * numExporters exporters, each with a MODULEPATHS section.
+     */
+    static File createJucer (const File& file, int numFiles, int numExporters)
+    {
+        static const char* exporterTypes[] = { "XCODE_MAC", "XCODE_IPHONE", "VS2015", "VS2013", "LINUX_MAKE", "ANDROIDSTUDIO" };
+
+        String xml;
+        xml.preallocateBytes ((size_t) numFiles * 140 + (size_t) numExporters * 600);
+        xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n\n"
+            << "<JUCERPROJECT id=\"bEnCh1\" name=\"Bench\" projectType=\"guiapp\" version=\"1.0.0\">\n"
+            << "  <MAINGROUP id=\"bEnChG\" name=\"Bench\">\n";
+
+        for (int f = 0; f < numFiles; ++f)
+        {
+            if (f % 100 == 0)
+            {
+                if (f > 0)
+                    xml << "    </GROUP>\n";
+
+                xml << "    <GROUP id=\"g" << f / 100 << "\" name=\"Group" << f / 100 << "\">\n";
+            }
+
+            xml << "      <FILE id=\"f" << f << "\" name=\"File" << f << ".cpp\" compile=\"1\" resource=\"0\" file=\"Source/Group"
+                << f / 100 << "/File" << f << ".cpp\"/>\n";
+        }
+
+        if (numFiles > 0)
+            xml << "    </GROUP>\n";
+
+        xml << "  </MAINGROUP>\n  <EXPORTFORMATS>\n";
+
+        for (int e = 0; e < numExporters; ++e)
+        {
+            auto type = String (exporterTypes[e % numElementsInArray (exporterTypes)]);
+
+            xml << "    <" << type << " targetFolder=\"Builds/Target" << e << "\">\n"
+                << "      <CONFIGURATIONS>\n"
+                << "        <CONFIGURATION name=\"Debug\" isDebug=\"1\" optimisation=\"1\" targetName=\"Bench\"/>\n"
+                << "        <CONFIGURATION name=\"Release\" isDebug=\"0\" optimisation=\"3\" targetName=\"Bench\"/>\n"
+                << "      </CONFIGURATIONS>\n"
+                << "      <MODULEPATHS>\n";
+
+            for (int m = 0; m < 20; ++m)
+                xml << "        <MODULEPATH id=\"" << getModuleName (m) << "\" path=\"./jpm_modules\"/>\n";
+
+            xml << "      </MODULEPATHS>\n    </" << type << ">\n";
+        }
+
+        xml << "  </EXPORTFORMATS>\n  <MODULES>\n";
+
+        for (int m = 0; m < 20; ++m)
+            xml << "    <MODULE id=\"" << getModuleName (m) << "\" showAllCode=\"1\" useLocalCopy=\"0\"/>\n";
+
+        xml << "  </MODULES>\n</JUCERPROJECT>\n";
+
+        file.getParentDirectory().createDirectory();
+        file.replaceWithText (xml);
+        return file;
+    }
+
+    /** The archive shapes benchmarked, smaller when quick is set. */
+    static Array<TreeShape> getArchiveShapes (bool quick)
+    {
+        Array<TreeShape> shapes;
+        shapes.add ({ "many-small", quick ? 1000 : 5000, 1024, 3 });
+        shapes.add ({ "few-large", quick ? 4 : 8, quick ? 2 * 1024 * 1024 : 8 * 1024 * 1024, 1 });
+        shapes.add ({ "deep", quick ? 300 : 1000, 4096, 16 });
+        return shapes;
+    }
+
+    /**
+     * A zip laid out like a GitHub archive: one top level folder holding
+     * modules/<module>/..., with the module's juce_module_info.
+     */
+    static File createZip (const File& file, const TreeShape& shape, const String& moduleName = "bm_mod_0")
+    {
+        ZipFile::Builder builder;
+        Random random (shape.numFiles * 31 + shape.fileSize);
+        auto root = "repo-master/modules/" + moduleName + "/";
+
+        auto info = createModuleInfo (moduleName);
+        builder.addEntry (new MemoryInputStream (info.toRawUTF8(), info.getNumBytesAsUTF8(), true),
+                          6, root + "juce_module_info", Time());
+
+        for (int i = 0; i < shape.numFiles; ++i)
+        {
+            auto contents = createFileContents (random, shape.fileSize);
+            builder.addEntry (new MemoryInputStream (contents, true), 6, root + getNestedPath (i, shape.depth, ".cpp"), Time());
+        }
+
+        file.getParentDirectory().createDirectory();
+        file.deleteFile();
+        FileOutputStream out (file);
+        double progress = 0.0;
+        builder.writeToStream (out, &progress);
+        return file;
+    }
+
+    /** The same layout and contents as createZip(), as a gzipped tarball. */
+    static File createTarGz (const File& file, const TreeShape& shape, const String& moduleName = "bm_mod_0")
+    {
+        Random random (shape.numFiles * 31 + shape.fileSize);
+        auto root = "repo-master/modules/" + moduleName + "/";
+
+        file.getParentDirectory().createDirectory();
+        file.deleteFile();
+
+        FileOutputStream out (file);
+        GZIPCompressorOutputStream gzip (&out, 6, false, gzipWindowBits);
+
+        auto info = createModuleInfo (moduleName);
+        writeTarEntry (gzip, root + "juce_module_info", info.toRawUTF8(), info.getNumBytesAsUTF8());
+
+        for (int i = 0; i < shape.numFiles; ++i)
+        {
+            auto contents = createFileContents (random, shape.fileSize);
+            writeTarEntry (gzip, root + getNestedPath (i, shape.depth, ".cpp"), contents.getData(), contents.getSize());
+        }
+
+        /* Two empty blocks end the archive. */
+        gzip.writeRepeatedByte (0, 1024);
+        gzip.flush();
+        return file;
+    }
+
+    /** Compresses data with gzip framing, the way tarballs are served. */
+    static MemoryBlock gzip (const MemoryBlock& data)
+    {
+        MemoryOutputStream out;
+
+        {
+            GZIPCompressorOutputStream compressor (&out, 6, false, gzipWindowBits);
+            compressor.write (data.getData(), data.getSize());
+        }
+
+        return out.getMemoryBlock();
+    }
+
+    /** A windowBits of 31 has zlib write gzip framing instead of its own. */
+    static const int gzipWindowBits = 31;
+
+    static String createModuleInfo (const String& moduleName)
+    {
+        auto* o = new DynamicObject();
+        o->setProperty ("id", moduleName);
+        o->setProperty ("name", moduleName);
+        o->setProperty ("version", "1.0.0");
+        o->setProperty ("description", "Synthetic module for benchmarking");
+        o->setProperty ("dependencies", Array<var>());
+        return JSON::toString (var (o));
+    }
+
+    /**
+     * A source tree of .h and .cpp pairs nested up to depth folders deep, with
+     * some files genmodule ignores mixed in.
+     */
+    static File createSourceTree (const File& folder, int numFiles, int depth)
+    {
+        folder.deleteRecursively();
+        folder.createDirectory();
+
+        for (int i = 0; i < numFiles; ++i)
+        {
+            const char* extension = (i % 10 == 9) ? ".txt" : (i % 2 == 0 ? ".h" : ".cpp");
+            auto f = folder.getChildFile (getNestedPath (i / 2, depth, extension));
+            f.getParentDirectory().createDirectory();
+            f.replaceWithText ("// synthetic " + String (i) + "\n");
+        }
+
+        return folder;
+    }
+
+    /** Spreads files over folders so no folder gets too big: a/b/c/file123.cpp */
+    static String getNestedPath (int index, int depth, const String& extension)
+    {
+        String path;
+
+        for (int d = 1; d < depth; ++d)
+            path << "dir" << ((index >> (d * 2)) % 4 + d * 4) << "/";
+
+        return path + "file" + String (index) + extension;
+    }
+
+    /**
+     * A ustar header, then the data padded to a whole block.  type is the
+     * header's type flag: '0' for a regular file, 'L' for a GNU long name.
+     */
+    static void writeTarEntry (OutputStream& out, const String& path, const void* data, size_t size, char type = '0')
+    {
+        char header[512] = { 0 };
+
+        jassert (path.getNumBytesAsUTF8() < 100);
+        path.copyToUTF8 (header, 100);
+        writeOctal (header + 100, 8, 0644);
+        writeOctal (header + 108, 8, 0);
+        writeOctal (header + 116, 8, 0);
+        writeOctal (header + 124, 12, (int64) size);
+        writeOctal (header + 136, 12, 1700000000);
+        header[156] = type;
+        memcpy (header + 257, "ustar", 6);
+        memcpy (header + 263, "00", 2);
+
+        /* The checksum is taken with its own field full of spaces. */
+        memset (header + 148, ' ', 8);
+        int64 checksum = 0;
+
+        for (auto c : header)
+            checksum += (unsigned char) c;
+
+        writeOctal (header + 148, 7, checksum);
+
+        out.write (header, sizeof (header));
+        out.write (data, size);
+        out.writeRepeatedByte (0, (512 - size % 512) % 512);
+    }
+
+private:
+    /** Zero padded octal filling all but the last byte of the field, which is left as a NUL. */
+    static void writeOctal (char* field, int width, int64 value)
+    {
+        field[width - 1] = 0;
+
+        for (int i = width - 2; i >= 0; --i)
+        {
+            field[i] = (char) ('0' + (value & 7));
+            value >>= 3;
+        }
+    }
+
+    /** Source-like text, so it compresses about as well as real modules do. */
+    static MemoryBlock createFileContents (Random& random, int size)
+    {
+        static const char* words[] = { "void", "int", "auto", "return", "const", "String", "juce", "for", "if",
+                                       "class", "struct", "float", "buffer", "sample", "(", ")", "{", "}", ";", "\n" };
+
+        MemoryOutputStream out ((size_t) size + 16);
+
+        while ((int) out.getDataSize() < size)
+        {
+            out << words[random.nextInt (numElementsInArray (words))];
+
+            if (random.nextInt (4) == 0)
+                out << random.nextInt (1000);
+
+            out << " ";
+        }
+
+        MemoryBlock block (out.getData(), (size_t) size);
+        return block;
+    }
+};
+
+#endif  // BENCHMARKFIXTURES_H_INCLUDED
@@ -0,0 +1,413 @@
+/*
+  ==============================================================================
+
+    CacheStats.h
+    Created: 21 Oct 2026 4:21:37pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef CACHESTATS_H_INCLUDED
+#define CACHESTATS_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "Settings.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+/**
+ * Counts how well the download cache is doing - `jpm cache stats`.
+ *
+ * Every lookup in the cache is recorded against its entry as one of:
+ *
+ *   hit           served from a fresh entry
+ *   miss          nothing cached, downloaded
+ *   revalidation  the entry was stale and was downloaded again
+ *   fallback      the download failed and a stale entry was used instead
+ *
+ * along with the bytes that came over the network and the bytes the cache
+ * served, which for an extracted archive is its size on disk.  The counts
+ * are kept in a file beside the cache folder rather than in it, so they
+ * survive between runs, and `jpm erasecache`, until reset.
+ *
+ * Lookups only touch memory.  The file is written once, at exit, by adding
+ * this process's counts to what's on disk then, so jpm processes running at
+ * the same time don't overwrite each other's.
+ */
+class CacheStats
+{
+public:
+    enum Outcome
+    {
+        hit,
+        miss,
+        revalidation,
+        fallback
+    };
+
+    struct Entry
+    {
+        String url;
+        int hits { 0 };
+        int misses { 0 };
+        int revalidations { 0 };
+        int fallbacks { 0 };
+        int64 bytesDownloaded { 0 };
+        int64 bytesServed { 0 };
+        int64 extractedSize { 0 };
+        int64 lastAccess { 0 };
+
+        int getLookups() const
+        {
+            return hits + misses + revalidations + fallbacks;
+        }
+
+        /**
+         * Lookups served from a fresh entry, as a fraction.  Fallbacks didn't
+         * download anything either, but only because the download failed, so
+         * they're reported on their own rather than counted here.
+         */
+        double getHitRate() const
+        {
+            return getLookups() > 0 ? hits / (double) getLookups() : 0.0;
+        }
+    };
+
+    CacheStats (const File& statsFile_)
+        :
+        statsFile (statsFile_)
+    {
+        load (entries);
+    }
+
+    ~CacheStats()
+    {
+        save();
+    }
+
+    static CacheStats& getInstance()
+    {
+        static CacheStats instance (getStatsFile());
+        return instance;
+    }
+
+    /** Beside the cache folder, e.g. jpm.modulecache.stats.xml, so erasing the cache keeps it. */
+    static File getStatsFile()
+    {
+        auto cacheFolder = Settings::getInstance().getCacheFolder();
+        auto statsFile = cacheFolder.getSiblingFile (cacheFolder.getFileName() + ".stats.xml");
+
+        /* Where earlier versions kept it. */
+        auto oldFile = cacheFolder.getChildFile ("cachestats.xml");
+
+        if (oldFile.existsAsFile() && ! statsFile.exists())
+            oldFile.moveFileTo (statsFile);
+
+        return statsFile;
+    }
+
+    /**
+     * Records a lookup of the cache entry stored at entryFile.  On a hit or
+     * fallback nothing is downloaded, and bytesServed can be left at -1 to
+     * use the size recorded with setExtractedSize().
+     */
+    void record (const File& entryFile, const String& url, Outcome outcome,
+                 int64 bytesDownloaded = 0, int64 bytesServed = -1)
+    {
+        std::lock_guard<std::mutex> lock (entriesLock);
+        const auto key = entryFile.getFileName();
+        auto& e = entries[key];
+
+        if (outcome != hit && outcome != fallback)
+            bytesServed = 0;
+        else if (bytesServed < 0)
+            bytesServed = e.extractedSize;
+
+        count (e, url, outcome, bytesDownloaded, bytesServed);
+        count (getChange (key), url, outcome, bytesDownloaded, bytesServed);
+    }
+
+    /** The size on disk of what's cached for the entry, once extracted. */
+    void setExtractedSize (const File& entryFile, int64 size)
+    {
+        std::lock_guard<std::mutex> lock (entriesLock);
+        const auto key = entryFile.getFileName();
+        entries[key].extractedSize = size;
+        getChange (key).extractedSize = size;
+    }
+
+    /**
+     * Adds the lookups recorded since the last save to the file.  It's read
+     * again first, under a lock shared with other jpm processes, in case one
+     * of them has saved since.  Happens at exit, and after each command in
+     * the daemon.
+     */
+    void save()
+    {
+        std::lock_guard<std::mutex> lock (entriesLock);
+
+        if (changes.empty())
+            return;
+
+        InterProcessLock fileLock ("jpm-cachestats-" + String::toHexString (statsFile.getFullPathName().hashCode64()));
+        const InterProcessLock::ScopedLockType processLock (fileLock);
+
+        if (! processLock.isLocked())
+            return;
+
+        std::map<String, Entry> merged;
+        load (merged);
+
+        for (auto& c : changes)
+            merge (merged[c.first], c.second);
+
+        write (merged);
+        entries = merged;
+        changes.clear();
+    }
+
+    /** Size of every file below folder. */
+    static int64 getSizeOnDisk (const File& folder)
+    {
+        int64 total = 0;
+        DirectoryIterator iter (folder, true, "*", File::findFiles);
+        bool isDirectory = false;
+        int64 size = 0;
+
+        while (iter.next (&isDirectory, nullptr, &size, nullptr, nullptr, nullptr))
+            total += size;
+
+        return total;
+    }
+
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock (entriesLock);
+        entries.clear();
+        changes.clear();
+        statsFile.deleteFile();
+    }
+
+    /** All the entries, keyed by the name of their file in the cache. */
+    std::map<String, Entry> getEntries()
+    {
+        std::lock_guard<std::mutex> lock (entriesLock);
+        return entries;
+    }
+
+    Entry getTotals()
+    {
+        std::lock_guard<std::mutex> lock (entriesLock);
+        Entry totals;
+
+        for (auto& i : entries)
+        {
+            auto& e = i.second;
+            totals.hits += e.hits;
+            totals.misses += e.misses;
+            totals.revalidations += e.revalidations;
+            totals.fallbacks += e.fallbacks;
+            totals.bytesDownloaded += e.bytesDownloaded;
+            totals.bytesServed += e.bytesServed;
+            totals.extractedSize += e.extractedSize;
+            totals.lastAccess = jmax (totals.lastAccess, e.lastAccess);
+        }
+
+        return totals;
+    }
+
+    /** Most used first. */
+    void printTable()
+    {
+        auto all = getEntries();
+        Array<const Entry*> sorted;
+
+        for (auto& i : all)
+            sorted.add (&i.second);
+
+        std::sort (sorted.begin(), sorted.end(), [] (const Entry* a, const Entry* b)
+        {
+            return a->getLookups() > b->getLookups();
+        });
+
+        std::cout << String ("hits").paddedRight (' ', 7)
+                  << String ("miss").paddedRight (' ', 7)
+                  << String ("reval").paddedRight (' ', 7)
+                  << String ("fback").paddedRight (' ', 7)
+                  << String ("downloaded").paddedRight (' ', 12)
+                  << String ("served").paddedRight (' ', 12)
+                  << String ("on disk").paddedRight (' ', 12)
+                  << String ("last used").paddedRight (' ', 18)
+                  << "url" << std::endl;
+
+        for (auto* e : sorted)
+            printRow (*e, e->url);
+
+        std::cout << std::endl;
+        auto totals = getTotals();
+        printRow (totals, "total (" + String ((int) all.size()) + " entries)");
+
+        String summary ("hit rate " + String (totals.getHitRate() * 100.0, 1) + "%, ");
+
+        if (totals.fallbacks > 0)
+            summary << totals.fallbacks << " stale entries used after failed downloads, ";
+
+        printInfo (summary + formatBytes (totals.bytesServed) + " served from the cache, "
+                   + formatBytes (totals.bytesDownloaded) + " downloaded");
+    }
+
+    String toJson()
+    {
+        auto toVar = [] (const Entry& e)
+        {
+            auto* o = new DynamicObject();
+            o->setProperty ("hits", e.hits);
+            o->setProperty ("misses", e.misses);
+            o->setProperty ("revalidations", e.revalidations);
+            o->setProperty ("fallbacks", e.fallbacks);
+            o->setProperty ("hit_rate", e.getHitRate());
+            o->setProperty ("bytes_downloaded", e.bytesDownloaded);
+            o->setProperty ("bytes_served", e.bytesServed);
+            o->setProperty ("extracted_size", e.extractedSize);
+            o->setProperty ("last_access_ms", e.lastAccess);
+            return o;
+        };
+
+        Array<var> list;
+
+        for (auto& i : getEntries())
+        {
+            auto* o = toVar (i.second);
+            o->setProperty ("entry", i.first);
+            o->setProperty ("url", i.second.url);
+            list.add (var (o));
+        }
+
+        auto* root = new DynamicObject();
+        root->setProperty ("totals", var (toVar (getTotals())));
+        root->setProperty ("entries", list);
+        return JSON::toString (var (root));
+    }
+
+private:
+    static void printRow (const Entry& e, const String& label)
+    {
+        auto lastUsed = e.lastAccess > 0 ? Time (e.lastAccess).formatted ("%Y-%m-%d %H:%M") : String ("-");
+
+        std::cout << String (e.hits).paddedRight (' ', 7)
+                  << String (e.misses).paddedRight (' ', 7)
+                  << String (e.revalidations).paddedRight (' ', 7)
+                  << String (e.fallbacks).paddedRight (' ', 7)
+                  << formatBytes (e.bytesDownloaded).paddedRight (' ', 12)
+                  << formatBytes (e.bytesServed).paddedRight (' ', 12)
+                  << formatBytes (e.extractedSize).paddedRight (' ', 12)
+                  << lastUsed.paddedRight (' ', 18)
+                  << label << std::endl;
+    }
+
+    static void count (Entry& e, const String& url, Outcome outcome, int64 bytesDownloaded, int64 bytesServed)
+    {
+        e.url = url;
+        e.lastAccess = Time::currentTimeMillis();
+        e.bytesDownloaded += bytesDownloaded;
+        e.bytesServed += bytesServed;
+
+        switch (outcome)
+        {
+            case hit:           ++e.hits; break;
+            case miss:          ++e.misses; break;
+            case revalidation:  ++e.revalidations; break;
+            case fallback:      ++e.fallbacks; break;
+        }
+    }
+
+    /** What this process has added to an entry.  An extractedSize of -1 means it hasn't set one. */
+    Entry& getChange (const String& key)
+    {
+        auto it = changes.find (key);
+
+        if (it == changes.end())
+        {
+            Entry e;
+            e.extractedSize = -1;
+            it = changes.insert (std::make_pair (key, e)).first;
+        }
+
+        return it->second;
+    }
+
+    static void merge (Entry& e, const Entry& change)
+    {
+        if (change.url.isNotEmpty())
+            e.url = change.url;
+
+        e.hits += change.hits;
+        e.misses += change.misses;
+        e.revalidations += change.revalidations;
+        e.fallbacks += change.fallbacks;
+        e.bytesDownloaded += change.bytesDownloaded;
+        e.bytesServed += change.bytesServed;
+        e.lastAccess = jmax (e.lastAccess, change.lastAccess);
+
+        if (change.extractedSize >= 0)
+            e.extractedSize = change.extractedSize;
+    }
+
+    void load (std::map<String, Entry>& into) const
+    {
+        ScopedPointer<XmlElement> xml = XmlDocument (statsFile).getDocumentElement();
+
+        if (xml == nullptr)
+            return;
+
+        forEachXmlChildElementWithTagName (*xml, x, "entry")
+        {
+            Entry e;
+            e.url = x->getStringAttribute ("url");
+            e.hits = x->getIntAttribute ("hits");
+            e.misses = x->getIntAttribute ("misses");
+            e.revalidations = x->getIntAttribute ("revalidations");
+            e.fallbacks = x->getIntAttribute ("fallbacks");
+            e.bytesDownloaded = x->getStringAttribute ("bytesDownloaded").getLargeIntValue();
+            e.bytesServed = x->getStringAttribute ("bytesServed").getLargeIntValue();
+            e.extractedSize = x->getStringAttribute ("extractedSize").getLargeIntValue();
+            e.lastAccess = x->getStringAttribute ("lastAccess").getLargeIntValue();
+            into[x->getStringAttribute ("key")] = e;
+        }
+    }
+
+    void write (const std::map<String, Entry>& all) const
+    {
+        XmlElement xml ("cache_stats");
+
+        for (auto& i : all)
+        {
+            auto& e = i.second;
+            auto* x = xml.createNewChildElement ("entry");
+            x->setAttribute ("key", i.first);
+            x->setAttribute ("url", e.url);
+            x->setAttribute ("hits", e.hits);
+            x->setAttribute ("misses", e.misses);
+            x->setAttribute ("revalidations", e.revalidations);
+            x->setAttribute ("fallbacks", e.fallbacks);
+            x->setAttribute ("bytesDownloaded", String (e.bytesDownloaded));
+            x->setAttribute ("bytesServed", String (e.bytesServed));
+            x->setAttribute ("extractedSize", String (e.extractedSize));
+            x->setAttribute ("lastAccess", String (e.lastAccess));
+        }
+
+        statsFile.getParentDirectory().createDirectory();
+        xml.writeToFile (statsFile, String());
+    }
+
+    File statsFile;
+    std::mutex entriesLock;
+    std::map<String, Entry> entries;
+    std::map<String, Entry> changes;
+};
+
+#endif  // CACHESTATS_H_INCLUDED
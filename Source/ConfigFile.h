@@ -13,6 +13,8 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "Module.h"
+#include "Trace.h"
+#include "RunReport.h"
 
 /** Holds the saved JPM project configuration.  Contains module sources, version numbers and so on. */
 class ConfigFile
@@ -34,7 +36,12 @@ public:
     ~ConfigFile()
     {
         /* This operation always feels risky ... should we do some backup and validation? */
-        file.replaceWithText (config.toXmlString());
+        TraceSpan span ("save config", "project");
+        RunReport::Phase phase ("save");
+        auto text = config.toXmlString();
+        span.setArg ("bytes", (int64) text.getNumBytesAsUTF8());
+        file.replaceWithText (text);
+        RunReport::getInstance().addFileWritten();
     }
 
     /** Returns the array of Module objects from the configuration. */
@@ -0,0 +1,514 @@
+/*
+  ==============================================================================
+
+    Daemon.h
+    Created: 21 Oct 2026 2:12:09pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef DAEMON_H_INCLUDED
+#define DAEMON_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "Settings.h"
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+
+#if JUCE_MAC || JUCE_LINUX
+ #define JPM_DAEMON 1
+ #include <sys/socket.h>
+ #include <sys/stat.h>
+ #include <sys/un.h>
+ #include <unistd.h>
+#else
+ #define JPM_DAEMON 0
+#endif
+
+/**
+ * A resident jpm - `jpm daemon`.
+ *
+ * The daemon listens on a Unix domain socket and runs the commands other jpm
+ * processes pass it, keeping the parsed directory, the transfer engine's
+ * connections, mirror statistics and ref lookups in memory between them.  A
+ * jpm process that finds a daemon sends it its working directory and
+ * arguments, relays what comes back to its own stdout and stderr and exits
+ * with the command's exit code; with no daemon it just runs the command
+ * itself.  Set JPM_NO_DAEMON to always run in process.
+ *
+ * Commands are run one at a time because they use the working directory.
+ * Settings are read when the daemon starts, so restart it after changing
+ * them.  There's one daemon per cache folder.  Its socket lives in
+ * XDG_RUNTIME_DIR, or the temporary folder, rather than in the cache, where
+ * `jpm erasecache` would delete it.
+ *
+ * Replies are packets of a type byte and a 4 byte little endian length:
+ * 'o' and 'e' carry stdout and stderr data, 'x' ends the reply with the
+ * exit code in place of the length.
+ */
+class Daemon
+{
+public:
+    typedef std::function<int (const StringArray& commandLine)> CommandRunner;
+
+    static File getSocketFile()
+    {
+        auto path = SystemStats::getEnvironmentVariable ("JPM_DAEMON_SOCKET", String());
+
+        if (path.isNotEmpty())
+            return File::getCurrentWorkingDirectory().getChildFile (path);
+
+        auto runtime = SystemStats::getEnvironmentVariable ("XDG_RUNTIME_DIR", String());
+        auto folder = runtime.isNotEmpty() ? File (runtime) : File::getSpecialLocation (File::tempDirectory);
+        auto cache = Settings::getInstance().getCacheFolder().getFullPathName();
+
+        return folder.getChildFile ("jpm-" + SystemStats::getLogonName() + "-"
+                                    + String::toHexString (cache.hashCode64()) + ".sock");
+    }
+
+    /**
+     * Runs a command in a daemon if one is listening.  Returns false, having
+     * done nothing, if there isn't one.
+     */
+    static bool runInDaemon (const StringArray& commandLine, int& exitCode)
+    {
+#if JPM_DAEMON
+        if (SystemStats::getEnvironmentVariable ("JPM_NO_DAEMON", String()).isNotEmpty())
+            return false;
+
+        const int fd = connectTo (getSocketFile());
+
+        if (fd < 0)
+            return false;
+
+        String request;
+        request << "cwd " << File::getCurrentWorkingDirectory().getFullPathName() << "\n";
+
+        for (int i = 1; i < commandLine.size(); ++i)
+            request << "arg " << commandLine[i] << "\n";
+
+        request << "run\n";
+
+        if (! writeAll (fd, request.toRawUTF8(), request.getNumBytesAsUTF8()))
+        {
+            close (fd);
+            return false;
+        }
+
+        bool receivedAnything = false;
+        HeapBlock<char> buffer (65536);
+
+        for (;;)
+        {
+            char header[5];
+
+            if (! readAll (fd, header, 5))
+                break;
+
+            receivedAnything = true;
+            const uint32 length = ByteOrder::littleEndianInt (header + 1);
+
+            if (header[0] == 'x')
+            {
+                close (fd);
+                exitCode = (int) length;
+                return true;
+            }
+
+            auto& out = header[0] == 'e' ? std::cerr : std::cout;
+
+            for (uint32 remaining = length; remaining > 0;)
+            {
+                const int n = (int) jmin (remaining, (uint32) 65536);
+
+                if (! readAll (fd, buffer, (size_t) n))
+                    break;
+
+                out.write (buffer, n);
+                remaining -= (uint32) n;
+            }
+
+            out.flush();
+        }
+
+        close (fd);
+
+        /* A daemon that went away before answering: run it here instead. */
+        if (! receivedAnything)
+            return false;
+
+        std::cerr << "jpm error: lost connection to the jpm daemon" << std::endl;
+        exitCode = 1;
+        return true;
+#else
+        ignoreUnused (commandLine, exitCode);
+        return false;
+#endif
+    }
+
+    /** Asks a running daemon to exit once it has finished the command it's running. */
+    static bool stop()
+    {
+#if JPM_DAEMON
+        const int fd = connectTo (getSocketFile());
+
+        if (fd < 0)
+            return false;
+
+        char header[5];
+        const bool stopped = writeAll (fd, "stop\n", 5) && readAll (fd, header, 5);
+        close (fd);
+        return stopped;
+#else
+        return false;
+#endif
+    }
+
+    Daemon (CommandRunner runner_)
+        :
+        runner (runner_)
+    {}
+
+    /** Serves commands until killed.  Returns false if it couldn't start. */
+    bool run()
+    {
+#if JPM_DAEMON
+        auto socketFile = getSocketFile();
+
+        int existing = connectTo (socketFile);
+
+        if (existing >= 0)
+        {
+            close (existing);
+            printError ("a daemon is already listening on " + socketFile.getFullPathName());
+            return false;
+        }
+
+        /* Left behind by a daemon that didn't exit cleanly. */
+        socketFile.getParentDirectory().createDirectory();
+        unlink (socketFile.getFullPathName().toRawUTF8());
+
+        const int listener = socket (AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address;
+
+        /* Only this user may ask it to do things.  bind() creates the socket
+         * file with the umask applied, so it's never open to anyone else, even
+         * briefly; nothing else is creating files this early. */
+        const mode_t previousMask = umask (0077);
+
+        const bool bound = listener >= 0 && makeAddress (socketFile, address)
+                           && bind (listener, (const sockaddr*) &address, sizeof (address)) == 0;
+
+        umask (previousMask);
+
+        if (! bound || listen (listener, 64) != 0)
+        {
+            printError ("could not listen on " + socketFile.getFullPathName());
+
+            if (listener >= 0)
+                close (listener);
+
+            return false;
+        }
+
+        printInfo ("daemon listening on " + socketFile.getFullPathName());
+
+        /* Installed for good: threads a command leaves behind, like the
+         * progress line, can still be writing after it has finished.  The
+         * daemon only ever exits through std::exit, which doesn't unwind this
+         * frame, so they stay valid to the end. */
+        Relay out ('o', std::cout.rdbuf());
+        Relay err ('e', std::cerr.rdbuf());
+        std::cout.rdbuf (&out);
+        std::cerr.rdbuf (&err);
+        relays[0] = &out;
+        relays[1] = &err;
+
+        for (;;)
+        {
+            const int client = accept (listener, nullptr, nullptr);
+
+            if (client < 0)
+                continue;
+
+           #ifdef SO_NOSIGPIPE
+            int one = 1;
+            setsockopt (client, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof (one));
+           #endif
+
+            std::thread ([this, client]() { serve (client); }).detach();
+        }
+#else
+        printError ("the daemon needs Unix domain sockets, which this platform doesn't have");
+        return false;
+#endif
+    }
+
+private:
+#if JPM_DAEMON
+    /**
+     * Stands in for stdout or stderr.  While a command runs, whatever is
+     * written goes to its client as packets of one type; the rest of the time
+     * it goes to the daemon's own output.
+     */
+    class Relay
+        :
+        public std::streambuf
+    {
+    public:
+        Relay (char type_, std::streambuf* fallback_)
+            :
+            type (type_),
+            fallback (fallback_)
+        {}
+
+        void attach (int fd_, std::mutex& writeLock_)
+        {
+            std::lock_guard<std::mutex> lock (bufferLock);
+            fd = fd_;
+            writeLock = &writeLock_;
+        }
+
+        /** Sends anything buffered; later output stays in the daemon. */
+        void detach()
+        {
+            std::lock_guard<std::mutex> lock (bufferLock);
+            send();
+            fd = -1;
+            writeLock = nullptr;
+        }
+
+    protected:
+        int_type overflow (int_type c) override
+        {
+            if (c != traits_type::eof())
+            {
+                std::lock_guard<std::mutex> lock (bufferLock);
+
+                if (fd < 0)
+                    return fallback->sputc ((char) c);
+
+                pending.push_back ((char) c);
+
+                if (pending.size() >= flushSize)
+                    send();
+            }
+
+            return traits_type::not_eof (c);
+        }
+
+        std::streamsize xsputn (const char* s, std::streamsize n) override
+        {
+            std::lock_guard<std::mutex> lock (bufferLock);
+
+            if (fd < 0)
+                return fallback->sputn (s, n);
+
+            pending.append (s, (size_t) n);
+
+            if (pending.size() >= flushSize)
+                send();
+
+            return n;
+        }
+
+        int sync() override
+        {
+            std::lock_guard<std::mutex> lock (bufferLock);
+
+            if (fd < 0)
+                return fallback->pubsync();
+
+            send();
+            return 0;
+        }
+
+    private:
+        void send()
+        {
+            if (pending.empty() || fd < 0)
+                return;
+
+            sendPacket (fd, type, (uint32) pending.size(), pending.data(), *writeLock);
+            pending.clear();
+        }
+
+        static const size_t flushSize = 4096;
+
+        char type;
+        std::streambuf* fallback;
+        int fd { -1 };
+        std::mutex* writeLock { nullptr };
+        std::mutex bufferLock;
+        std::string pending;
+    };
+
+    void serve (int client)
+    {
+        StringArray commandLine ("jpm");
+        String cwd;
+        std::string line;
+        char c = 0;
+
+        while (readAll (client, &c, 1))
+        {
+            if (c != '\n')
+            {
+                line.push_back (c);
+                continue;
+            }
+
+            auto text = String::fromUTF8 (line.data(), (int) line.size());
+            line.clear();
+
+            if (text.startsWith ("cwd "))
+                cwd = text.substring (4);
+            else if (text.startsWith ("arg "))
+                commandLine.add (text.substring (4));
+            else if (text == "run")
+                break;
+            else if (text == "stop")
+            {
+                std::mutex writeLock;
+                std::lock_guard<std::mutex> lock (commandLock);
+                unlink (getSocketFile().getFullPathName().toRawUTF8());
+                sendPacket (client, 'x', 0, nullptr, writeLock);
+                close (client);
+                std::exit (0);
+            }
+        }
+
+        if (c == '\n' && cwd.isNotEmpty())
+        {
+            std::mutex writeLock;
+            int exitCode = 1;
+
+            {
+                std::lock_guard<std::mutex> lock (commandLock);
+                File (cwd).setAsCurrentWorkingDirectory();
+                messageStream() = &std::cout;
+
+                for (auto* r : relays)
+                    r->attach (client, writeLock);
+
+                exitCode = runner (commandLine);
+
+                std::cout.flush();
+                std::cerr.flush();
+
+                for (auto* r : relays)
+                    r->detach();
+            }
+
+            sendPacket (client, 'x', (uint32) exitCode, nullptr, writeLock);
+        }
+
+        close (client);
+    }
+
+    static void sendPacket (int fd, char type, uint32 length, const char* data, std::mutex& writeLock)
+    {
+        char header[5] = { type };
+        header[1] = (char) (length & 0xff);
+        header[2] = (char) ((length >> 8) & 0xff);
+        header[3] = (char) ((length >> 16) & 0xff);
+        header[4] = (char) ((length >> 24) & 0xff);
+
+        std::lock_guard<std::mutex> lock (writeLock);
+
+        /* A client that has gone away just stops getting output. */
+        if (writeAll (fd, header, 5) && data != nullptr)
+            writeAll (fd, data, length);
+    }
+
+    static bool makeAddress (const File& socketFile, sockaddr_un& address)
+    {
+        auto path = socketFile.getFullPathName();
+
+        if ((size_t) path.getNumBytesAsUTF8() >= sizeof (address.sun_path))
+            return false;
+
+        zerostruct (address);
+        address.sun_family = AF_UNIX;
+        strcpy (address.sun_path, path.toRawUTF8());
+        return true;
+    }
+
+    static int connectTo (const File& socketFile)
+    {
+        sockaddr_un address;
+
+        if (! socketFile.exists() || ! makeAddress (socketFile, address))
+            return -1;
+
+        const int fd = socket (AF_UNIX, SOCK_STREAM, 0);
+
+        if (fd < 0)
+            return -1;
+
+       #ifdef SO_NOSIGPIPE
+        int one = 1;
+        setsockopt (fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof (one));
+       #endif
+
+        if (connect (fd, (const sockaddr*) &address, sizeof (address)) != 0)
+        {
+            close (fd);
+            return -1;
+        }
+
+        return fd;
+    }
+
+    static bool writeAll (int fd, const char* data, size_t size)
+    {
+       #ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+       #else
+        const int flags = 0;
+       #endif
+
+        while (size > 0)
+        {
+            auto n = ::send (fd, data, size, flags);
+
+            if (n <= 0)
+                return false;
+
+            data += n;
+            size -= (size_t) n;
+        }
+
+        return true;
+    }
+
+    static bool readAll (int fd, char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            auto n = ::read (fd, data, size);
+
+            if (n <= 0)
+                return false;
+
+            data += n;
+            size -= (size_t) n;
+        }
+
+        return true;
+    }
+
+    std::mutex commandLock;
+    Relay* relays[2] { nullptr, nullptr };
+#endif
+
+    CommandRunner runner;
+};
+
+#endif  // DAEMON_H_INCLUDED
@@ -0,0 +1,563 @@
+/*
+  ==============================================================================
+
+    DependencyResolver.h
+    Created: 20 Oct 2026 7:31:05pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef DEPENDENCYRESOLVER_H_INCLUDED
+#define DEPENDENCYRESOLVER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "Module.h"
+#include "ModuleStore.h"
+#include "Trace.h"
+#include "RunReport.h"
+#include <functional>
+#include <map>
+#include <mutex>
+
+/**
+ * A version requirement from the dependencies section of juce_module_info.
+ *
+ * Understands exact versions, comparisons (>=1.2 <2), caret and tilde ranges
+ * (^1.2.0, ~1.2.0), "*" and JUCE's "matching", which means the dependency
+ * should come from the same release as the module that needs it.
+ */
+class VersionConstraint
+{
+public:
+    VersionConstraint (const String& text_)
+        :
+        text (text_.trim())
+    {
+        StringArray tokens;
+        tokens.addTokens (text, " ,", String());
+        tokens.removeEmptyStrings();
+
+        for (auto& t : tokens)
+            addTerm (t);
+    }
+
+    bool isMatching() const
+    {
+        return text.equalsIgnoreCase ("matching");
+    }
+
+    bool allows (const String& version) const
+    {
+        if (isMatching())
+            return true;
+
+        for (auto& term : terms)
+        {
+            const int c = compare (version, term.version);
+
+            if ((term.op == "=" && c != 0) || (term.op == ">=" && c < 0) || (term.op == ">" && c <= 0)
+                || (term.op == "<=" && c > 0) || (term.op == "<" && c >= 0))
+                return false;
+        }
+
+        return true;
+    }
+
+    String toString() const
+    {
+        return text.isEmpty() ? "*" : text;
+    }
+
+    /** Compares dotted numeric versions; a leading 'v' is ignored and missing parts count as 0. */
+    static int compare (const String& a, const String& b)
+    {
+        auto x = split (a), y = split (b);
+
+        for (int i = 0; i < jmax (x.size(), y.size()); ++i)
+        {
+            const int p = x[i], q = y[i];
+
+            if (p != q)
+                return p < q ? -1 : 1;
+        }
+
+        return 0;
+    }
+
+private:
+    struct Term
+    {
+        String op;
+        String version;
+    };
+
+    void addTerm (const String& token)
+    {
+        if (token == "*" || token.equalsIgnoreCase ("matching"))
+            return;
+
+        for (auto* op : { ">=", "<=", ">", "<", "=" })
+        {
+            if (token.startsWith (op))
+            {
+                terms.add ({ op, token.substring ((int) strlen (op)) });
+                return;
+            }
+        }
+
+        auto version = token.substring (1);
+        auto parts = split (version);
+
+        if (token.startsWithChar ('^'))
+        {
+            /* Anything that doesn't change the leftmost non-zero part. */
+            int i = 0;
+
+            while (i < parts.size() - 1 && parts[i] == 0)
+                ++i;
+
+            terms.add ({ ">=", version });
+            terms.add ({ "<", bump (parts, i) });
+        }
+        else if (token.startsWithChar ('~'))
+        {
+            terms.add ({ ">=", version });
+            terms.add ({ "<", bump (parts, jmin (1, parts.size() - 1)) });
+        }
+        else
+        {
+            terms.add ({ "=", token });
+        }
+    }
+
+    static Array<int> split (String version)
+    {
+        if (version.startsWithIgnoreCase ("v"))
+            version = version.substring (1);
+
+        StringArray parts;
+        parts.addTokens (version, ".", String());
+
+        Array<int> numbers;
+
+        for (auto& p : parts)
+            numbers.add (p.getIntValue());
+
+        if (numbers.isEmpty())
+            numbers.add (0);
+
+        return numbers;
+    }
+
+    static String bump (Array<int> parts, int index)
+    {
+        parts.set (index, parts[index] + 1);
+
+        StringArray result;
+
+        for (int i = 0; i < parts.size(); ++i)
+            result.add (String (i > index ? 0 : parts[i]));
+
+        return result.joinIntoString (".");
+    }
+
+    String text;
+    Array<Term> terms;
+};
+
+/**
+ * Works out everything a set of modules needs, following the dependencies
+ * listed in each module's juce_module_info.
+ *
+ * Modules are loaded a wave at a time - first the ones asked for, then
+ * everything they need that isn't known yet, and so on - with each wave
+ * fetched in parallel.  Versions already in the ModuleStore are read where
+ * they are.  Installation then goes a level at a time, so nothing is
+ * installed before the things it depends on, with the modules in a level
+ * copied into the store and switched to in parallel.
+ */
+class DependencyResolver
+{
+public:
+    struct Node
+    {
+        Module module;
+        String requestedVersion;
+
+        /** The version from its juce_module_info. */
+        String infoVersion;
+
+        StringArray dependencies;
+        StringArray constraints;
+
+        /** True if it was asked for, rather than needed by something else. */
+        bool direct { false };
+
+        /** 0 for modules with no dependencies, otherwise one more than the deepest. */
+        int level { 0 };
+
+        /** Where this run fetched it to, if it did. */
+        File source;
+
+        /** Kept so the copy's tally of what was left out can be totalled. */
+        InstallFilter filter;
+    };
+
+    /** Finds candidates for a module that's needed but wasn't asked for. */
+    typedef std::function<Array<Module> (const String& name)> Lookup;
+
+    DependencyResolver (const File& modulesFolder_, Lookup lookup_)
+        :
+        projectRoot (modulesFolder_.getParentDirectory()),
+        store (modulesFolder_),
+        lookup (lookup_)
+    {}
+
+    Result resolve (const Array<Module>& roots)
+    {
+        TraceSpan span ("resolve", "project");
+        RunReport::Phase phase ("resolve");
+        nodes.clear();
+        Array<int> wave;
+
+        for (auto m : roots)
+        {
+            wave.add (nodes.size());
+            nodes.add (createNode (m, true));
+        }
+
+        while (wave.size() > 0)
+        {
+            printInfo ("resolving " + String (wave.size()) + " module(s)");
+
+            StringArray failures;
+            std::mutex failuresLock;
+
+            parallelFor (wave.size(), maxParallelFetches, [&] (int i)
+            {
+                auto& node = *nodes[wave[i]];
+
+                if (! load (node))
+                {
+                    std::lock_guard<std::mutex> lock (failuresLock);
+                    failures.add (node.module.getName());
+                }
+            });
+
+            if (failures.size() > 0)
+                return Result::fail ("could not fetch " + failures.joinIntoString (", "));
+
+            Array<int> next;
+
+            for (auto index : wave)
+            {
+                auto& node = *nodes[index];
+
+                for (int d = 0; d < node.dependencies.size(); ++d)
+                {
+                    if (findNode (node.dependencies[d]) != nullptr)
+                        continue;
+
+                    Module m;
+
+                    if (! chooseDependency (node, node.dependencies[d], node.constraints[d], m))
+                        return Result::fail (node.module.getName() + " needs " + node.dependencies[d]
+                                             + " which isn't in any directory");
+
+                    next.add (nodes.size());
+                    nodes.add (createNode (m, false));
+                }
+            }
+
+            wave = next;
+        }
+
+        auto result = checkConstraints();
+
+        return result.failed() ? result : assignLevels();
+    }
+
+    /** Uses a graph resolved earlier, e.g. from the lockfile. */
+    Result setNodes (const Array<Node>& resolved)
+    {
+        nodes.clear();
+
+        for (auto& n : resolved)
+        {
+            auto* node = new Node (n);
+            node->filter = node->module.getInstallFilter();
+            nodes.add (node);
+        }
+
+        return assignLevels();
+    }
+
+    /** Switches every module to its resolved version, deepest dependencies first. */
+    Result install()
+    {
+        TraceSpan span ("install", "project");
+        RunReport::Phase phase ("install");
+        int maxLevel = 0;
+
+        for (auto* n : nodes)
+            maxLevel = jmax (maxLevel, n->level);
+
+        StringArray failures;
+        std::mutex failuresLock;
+
+        for (int level = 0; level <= maxLevel; ++level)
+        {
+            Array<Node*> pending;
+
+            for (auto* n : nodes)
+                if (n->level == level && needsInstalling (*n))
+                    pending.add (n);
+
+            if (pending.isEmpty())
+                continue;
+
+            printInfo ("switching " + String (pending.size()) + " module(s) at dependency level " + String (level));
+
+            parallelFor (pending.size(), maxParallelFetches, [&] (int i)
+            {
+                auto& node = *pending[i];
+                auto name = node.module.getName();
+                TraceSpan moduleSpan ("install module", "install");
+
+                if (moduleSpan.isActive())
+                    moduleSpan.setArg ("module", name);
+
+                if (! store.contains (name, ModuleStore::getStoredVersion (node.module)))
+                {
+                    printInfo ("installing: " + name);
+
+                    if (! node.source.exists())
+                        node.source = node.module.fetch();
+
+                    auto added = store.add (node.module, node.source, node.filter);
+
+                    /* Activating would point the module at an entry that isn't there. */
+                    if (added.failed())
+                    {
+                        printError (added.getErrorMessage());
+                        std::lock_guard<std::mutex> lock (failuresLock);
+                        failures.add (name);
+                        return;
+                    }
+                }
+
+                /* Fetching may have turned a branch into a commit. */
+                if (! store.activate (name, ModuleStore::getStoredVersion (node.module)))
+                {
+                    std::lock_guard<std::mutex> lock (failuresLock);
+                    failures.add (node.module.getName());
+                }
+            });
+
+            /* Dependents of something that failed would be broken anyway. */
+            if (failures.size() > 0)
+                return Result::fail ("could not install " + failures.joinIntoString (", "));
+        }
+
+        InstallFilter total;
+
+        for (auto* n : nodes)
+            total.recordSkipped (n->filter.getNumFilesSkipped(), n->filter.getNumBytesSkipped(), n->filter.getSecondsSaved());
+
+        if (total.getNumFilesSkipped() > 0)
+            printInfo ("in total, " + total.getSavingsString());
+
+        return Result::ok();
+    }
+
+    const OwnedArray<Node>& getNodes() const
+    {
+        return nodes;
+    }
+
+    /** Nodes whose version isn't in the store yet, so must be fetched before install(). */
+    Array<Node*> getNodesToFetch() const
+    {
+        Array<Node*> result;
+
+        for (auto* n : nodes)
+            if (needsInstalling (*n) && ! n->source.exists()
+                && ! store.contains (n->module.getName(), ModuleStore::getStoredVersion (n->module)))
+                result.add (n);
+
+        return result;
+    }
+
+    static const int maxParallelFetches = 8;
+
+private:
+    Node* createNode (const Module& m, bool direct)
+    {
+        auto* node = new Node();
+
+        /* A private copy, so resolution doesn't change what the caller holds
+         * unless it's asked for. */
+        auto state = m.getStateAsValueTree();
+
+        if (! direct)
+            state = state.createCopy();
+
+        node->module = Module (state);
+        node->requestedVersion = m.getVersion();
+        node->direct = direct;
+        node->filter = node->module.getInstallFilter();
+        return node;
+    }
+
+    Node* findNode (const String& name) const
+    {
+        for (auto* n : nodes)
+            if (n->module.getName() == name)
+                return n;
+
+        return nullptr;
+    }
+
+    bool needsInstalling (const Node& node) const
+    {
+        return node.module.getSource() != "LocalPath"
+               && ! store.isActive (node.module.getName(), ModuleStore::getStoredVersion (node.module));
+    }
+
+    /** Reads juce_module_info from the stored copy, fetching it first if there isn't one. */
+    bool load (Node& node)
+    {
+        File folder;
+        auto& m = node.module;
+
+        if (m.getSource() != "LocalPath" && store.contains (m.getName(), ModuleStore::getStoredVersion (m)))
+            folder = store.getEntry (m.getName(), ModuleStore::getStoredVersion (m));
+        else if (m.getSource() == "LocalPath")
+            folder = projectRoot.getChildFile (m.getPath()).getChildFile (m.getName());
+        else
+            folder = node.source = m.fetch();
+
+        if (! folder.exists())
+            return false;
+
+        auto info = JSON::parse (folder.getChildFile ("juce_module_info"));
+        node.infoVersion = info.getProperty ("version", String()).toString();
+
+        if (auto* deps = info.getProperty ("dependencies", var()).getArray())
+        {
+            for (auto& d : *deps)
+            {
+                auto id = d.getProperty ("id", String()).toString();
+
+                if (id.isNotEmpty())
+                {
+                    node.dependencies.add (id);
+                    node.constraints.add (d.getProperty ("version", String()).toString());
+                }
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Picks a module for a dependency, preferring one from the same repo as
+     * the module that needs it.  "matching" pins it to the same commit.
+     */
+    bool chooseDependency (const Node& dependent, const String& name, const String& constraint, Module& chosen)
+    {
+        auto candidates = lookup (name);
+
+        if (candidates.isEmpty())
+            return false;
+
+        chosen = candidates[0];
+
+        for (auto& c : candidates)
+        {
+            if (c.getRepo() == dependent.module.getRepo())
+            {
+                chosen = c;
+                break;
+            }
+        }
+
+        if (VersionConstraint (constraint).isMatching() && chosen.getPath() == dependent.module.getPath())
+            chosen.setVersion (dependent.module.getVersion());
+
+        return true;
+    }
+
+    Result checkConstraints() const
+    {
+        StringArray problems;
+
+        for (auto* n : nodes)
+        {
+            for (int d = 0; d < n->dependencies.size(); ++d)
+            {
+                auto* dependency = findNode (n->dependencies[d]);
+                VersionConstraint constraint (n->constraints[d]);
+
+                if (dependency != nullptr && ! constraint.allows (dependency->infoVersion))
+                    problems.add (n->module.getName() + " needs " + dependency->module.getName() + " "
+                                  + constraint.toString() + " but got " + dependency->infoVersion);
+            }
+        }
+
+        if (problems.isEmpty())
+            return Result::ok();
+
+        return Result::fail (problems.joinIntoString ("; ")
+                             + " - pin a suitable version with jpm install <repo>/<name>@<version>");
+    }
+
+    /** Depth-first, so a cycle shows up as a module met again while still being visited. */
+    Result assignLevels()
+    {
+        std::map<String, int> state; /* 1 = visiting, 2 = done */
+        String cycle;
+
+        std::function<int (Node&)> visit = [&] (Node& node) -> int
+        {
+            auto& s = state[node.module.getName()];
+
+            if (s == 2)
+                return node.level;
+
+            if (s == 1)
+            {
+                cycle = node.module.getName();
+                return 0;
+            }
+
+            s = 1;
+            int level = 0;
+
+            for (auto& name : node.dependencies)
+                if (auto* dependency = findNode (name))
+                    level = jmax (level, visit (*dependency) + 1);
+
+            state[node.module.getName()] = 2;
+            node.level = level;
+            return level;
+        };
+
+        for (auto* n : nodes)
+            visit (*n);
+
+        if (cycle.isNotEmpty())
+            return Result::fail ("circular dependency involving " + cycle);
+
+        return Result::ok();
+    }
+
+    File projectRoot;
+    ModuleStore store;
+    Lookup lookup;
+    OwnedArray<Node> nodes;
+};
+
+#endif  // DEPENDENCYRESOLVER_H_INCLUDED
@@ -6,7 +6,20 @@
 #include "Module.h"
 #include "Utilities.h"
 #include "DownloadCache.h"
+#include "DirectoryDelta.h"
+#include "DirectoryIndex.h"
+#include "DirectoryModel.h"
+#include "Settings.h"
+#include "Trace.h"
+#include "CacheStats.h"
+#include "RunReport.h"
+#include "Mirrors.h"
+#include "TransferEngine.h"
+#include <atomic>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 
 /** Decodes module names in the format repo/name@version */
@@ -36,6 +49,86 @@ private:
     String name;
 };
 
+/**
+ * Work that carries on while a command runs, such as fetching a newer
+ * directory for next time.  main() gives it a moment to finish and then
+ * stops it, so nothing is left running while the statics are destroyed.
+ */
+class BackgroundRefresh
+{
+public:
+    static BackgroundRefresh& getInstance()
+    {
+        static BackgroundRefresh instance;
+        return instance;
+    }
+
+    /* The jobs use these, so they're made first and destroyed after us. */
+    BackgroundRefresh()
+    {
+        TransferEngine::getInstance();
+        Mirrors::getInstance();
+        CacheStats::getInstance();
+        Trace::getInstance();
+    }
+
+    ~BackgroundRefresh()
+    {
+        stop (0);
+    }
+
+    void start (std::function<void()> job)
+    {
+        std::lock_guard<std::mutex> lock (threadsLock);
+        ++pending;
+
+        threads.push_back (std::thread ([this, job]
+        {
+            job();
+
+            if (--pending == 0)
+                finished.signal();
+        }));
+    }
+
+    /**
+     * Gives anything still running up to timeoutMs, then cancels its
+     * transfers and waits for it to wind up.  Afterwards no more transfers
+     * can be started, so this is for the end of the process.
+     */
+    void stop (int timeoutMs)
+    {
+        if (pending > 0 && ! finished.wait (timeoutMs))
+        {
+            cancelled = true;
+            TransferEngine::getInstance().cancelAll();
+        }
+
+        std::vector<std::thread> running;
+
+        {
+            std::lock_guard<std::mutex> lock (threadsLock);
+            running.swap (threads);
+        }
+
+        for (auto& t : running)
+            t.join();
+    }
+
+    /** True if stop() cut the jobs short, so their failures don't count. */
+    bool wasCancelled() const
+    {
+        return cancelled;
+    }
+
+private:
+    std::atomic<int> pending { 0 };
+    std::atomic<bool> cancelled { false };
+    WaitableEvent finished;
+    std::mutex threadsLock;
+    std::vector<std::thread> threads;
+};
+
 /** Holds an index of where to find specific modules.  We may want more than
  * one of these in the end. */
 class Directory
@@ -55,27 +148,48 @@ public:
      */
 
     /**
-     * Opens a directory with the given URL, downloading the latest version of
-     * the contents. 
+     * Opens the directories at the given locations, downloading the latest
+     * version of each, and merges them.  Earlier ones shadow later ones.
+     * A location may be a URL or a local file.
      */
-    Directory (URL location)
+    Directory (const StringArray& locations)
     {
+        TraceSpan span ("load directory", "directory");
+        RunReport::Phase phase ("directory");
         DownloadCache cache;
-        String file = cache.downloadTextFile (location);
-        ScopedPointer<XmlElement> xml = XmlDocument (file).getDocumentElement();
+        Array<DirectoryIndex::Layer> layers;
 
-        if (xml)
+        for (auto& location : locations)
         {
-            directory = ValueTree::fromXml (*xml);
+            DirectoryIndex::Layer layer;
+            layer.source = location;
+
+            if (isLocalFile (location))
+                layer.file = getLocalFile (location);
+            else if (shouldUseBakedSnapshot (cache, location))
+                layer.file = useBakedSnapshot (cache, location);
+            else
+                layer.file = download (cache, URL (location));
+
+            if (! layer.file.existsAsFile())
+                printWarning ("could not read the directory at " + location);
+
+            layers.add (layer);
         }
-        else
+
+        DirectoryIndex index (cache.location);
+        index.update (layers);
+
+        if (! directory.loadFile (index.getFile()) || directory.getNumModules() == 0)
         {
             throw JpmFatalExcepton ("directory format error or network problem",
-                                    "Check " 
-                                    + cache.getCachedFileLocation (location).getFullPathName() 
-                                    + " for debugging which should contain the contents of " 
-                                    + location.toString (true));
+                                    "Check "
+                                    + index.getFile().getFullPathName()
+                                    + " which should contain the merged contents of "
+                                    + locations.joinIntoString (", "));
         }
+
+        span.setArg ("modules", directory.getNumModules());
     }
 
 
@@ -90,10 +204,26 @@ public:
         Array<Module> results;
         ModuleName module (moduleNameString);
 
-        for (auto repoEntry : ValueTreeChildrenConnector (directory))
+        /* Comparing string ids is enough, as each string is only stored once. */
+        int64 repo = -1;
+
+        if (module.getRepo().isNotEmpty() && (repo = directory.findString (module.getRepo())) < 0)
+            return results;
+
+        auto matchesRepo = [&] (int m) { return repo < 0 || directory.isInRepo (m, repo); };
+
+        if (module.getName().containsAnyOf ("*?"))
         {
-            if (module.getRepo().isEmpty() || repoEntry["shortname"] == module.getRepo())
-                results.addArray (getMatchingModulesFromRepo (repoEntry, module.getName()));
+            for (int m = 0; m < directory.getNumModules(); ++m)
+                if (matchesRepo (m) && directory.getModuleName (m).matchesWildcard (module.getName(), false))
+                    results.add (createModule (m));
+        }
+        else
+        {
+            /* Plain names go straight to the index. */
+            for (auto m : directory.findModules (module.getName()))
+                if (matchesRepo (m))
+                    results.add (createModule (m));
         }
 
         /* If a version was provided then set it.  We won't know until download time whether it definitely exists. */
@@ -105,42 +235,171 @@ public:
     }
 
 private:
-    Array<Module> getMatchingModulesFromRepo (ValueTree repoEntry, const String& name)
+    /**
+     * Brings the cached copy of the directory up to date.  If the cached copy
+     * has a version only the changes since then are asked for; a server that
+     * doesn't do deltas sends everything, which is used as is.
+     */
+    static File download (DownloadCache& cache, const URL& location)
     {
-        Array<Module> result;
+        TraceSpan span ("fetch directory", "directory");
+        auto cachedFile = cache.getCachedFileLocation (location);
+        auto& stats = CacheStats::getInstance();
 
-        for (auto moduleEntry : ValueTreeChildrenConnector (repoEntry))
+        if (cachedFile.existsAsFile() && cache.isRecent (cachedFile))
         {
-            if (moduleEntry["name"].toString().matchesWildcard (name, false))
-            {
-                /* We use this short lambda for validating the mandatory fields
-                 * in the directory. */
-                auto test = [&repoEntry] (const String & text)
-                {
-                    if (text.isEmpty())
-                        printWarning("warning: error in directory for repo " + repoEntry["shortname"].toString());
+            span.setArg ("cache", "hit");
+            stats.record (cachedFile, location.toString (true), CacheStats::hit, 0, cachedFile.getSize());
+            return cachedFile;
+        }
+
+        span.setArg ("cache", "miss");
 
-                    return text;
-                };
+        auto cached = loadTree (cachedFile);
 
-                Module m;
+        auto url = location.toString (true);
+        const int version = DirectoryDelta::getVersion (cached);
 
-                m.setRepo (test (repoEntry["shortname"]));
-                m.setPath (test (repoEntry["path"]));
-                m.setSource (test (repoEntry["source"]));
-                m.setName (test (moduleEntry["name"]));
-                m.setSubPath (test (moduleEntry["subpath"]));
+        if (cached.isValid() && version > 0)
+            url << (url.containsChar ('?') ? "&" : "?") << "since=" << version;
 
-                /* Description is allowed to be empty. */
-                m.setDescription (moduleEntry["description"]);
+        auto text = Mirrors::getInstance().fetchText (url);
+        int64 bytesDownloaded = text.getNumBytesAsUTF8();
+        auto reply = parseTree (text);
 
-                result.add (m);
+        if (DirectoryDelta::isDelta (reply))
+        {
+            auto result = DirectoryDelta::apply (cached, reply);
+
+            if (result.failed())
+            {
+                printWarning (result.getErrorMessage() + ", fetching the whole directory");
+                text = Mirrors::getInstance().fetchText (location.toString (true));
+                bytesDownloaded += text.getNumBytesAsUTF8();
+                reply = parseTree (text);
             }
+            else
+            {
+                reply = cached;
+            }
+        }
+
+        /* Offline, or something went wrong: carry on with what we had. */
+        if (reply.isValid() && ! DirectoryDelta::isDelta (reply))
+        {
+            const bool hadCopy = cached.isValid();
+            cachedFile.replaceWithText (reply.toXmlString());
+            stats.record (cachedFile, location.toString (true), hadCopy ? CacheStats::revalidation : CacheStats::miss,
+                          bytesDownloaded);
+            stats.setExtractedSize (cachedFile, cachedFile.getSize());
+        }
+        else if (cached.isValid())
+        {
+            stats.record (cachedFile, location.toString (true), CacheStats::fallback, 0, cachedFile.getSize());
         }
 
-        return result;
+        return cachedFile;
+    }
+
+    /**
+     * jpm is built with a copy of the public directory, so the first run
+     * doesn't have to wait for the network, or have one at all.
+     */
+    static bool shouldUseBakedSnapshot (DownloadCache& cache, const String& location)
+    {
+        return location == Settings::getDefaultDirectoryUrl()
+               && ! cache.getCachedFileLocation (URL (location)).existsAsFile();
+    }
+
+    /**
+     * Answers from the built-in copy while the real one downloads in the
+     * background.  The download goes to the usual cache file, so the next
+     * command uses it; until then the snapshot is kept apart so this run
+     * sees one consistent version.  A failed download isn't tried again for
+     * an hour, so a machine without a network doesn't keep paying for it.
+     */
+    static File useBakedSnapshot (DownloadCache& cache, const String& location)
+    {
+        auto snapshot = cache.location.getChildFile ("directory.snapshot.xml");
+        auto failed = cache.location.getChildFile ("directory.fetch-failed");
+
+        snapshot.replaceWithData (BinaryData::jpm_directory_xml, (size_t) BinaryData::jpm_directory_xmlSize);
+
+        if (failed.existsAsFile() && Time::getCurrentTime() - failed.getLastModificationTime() < RelativeTime::hours (1))
+        {
+            printInfo ("using the built-in directory, the last attempt to fetch the latest failed");
+            return snapshot;
+        }
+
+        printInfo ("using the built-in directory, fetching the latest in the background");
+
+        auto& refresh = BackgroundRefresh::getInstance();
+
+        refresh.start ([location, failed, &refresh]
+        {
+            DownloadCache backgroundCache;
+
+            if (download (backgroundCache, URL (location)).existsAsFile())
+                failed.deleteFile();
+            else if (! refresh.wasCancelled())
+                failed.replaceWithText (location);
+        });
+
+        return snapshot;
+    }
+
+    static bool isLocalFile (const String& location)
+    {
+        return location.startsWith ("file:") || File::isAbsolutePath (location) || ! location.contains ("://");
+    }
+
+    static File getLocalFile (const String& location)
+    {
+        auto path = location.startsWith ("file://") ? URL::removeEscapeChars (location.substring (7)) : location;
+        return File::getCurrentWorkingDirectory().getChildFile (path);
     }
-    ValueTree directory;
+
+    static ValueTree loadTree (const File& file)
+    {
+        ScopedPointer<XmlElement> xml = XmlDocument (file).getDocumentElement();
+        return xml != nullptr ? ValueTree::fromXml (*xml) : ValueTree();
+    }
+
+    static ValueTree parseTree (const String& text)
+    {
+        ScopedPointer<XmlElement> xml = XmlDocument::parse (text);
+        return xml != nullptr ? ValueTree::fromXml (*xml) : ValueTree();
+    }
+
+    Module createModule (int m) const
+    {
+        const int repo = directory.getModuleRepo (m);
+
+        /* We use this short lambda for validating the mandatory fields
+         * in the directory. */
+        auto test = [this, repo] (const String & text)
+        {
+            if (text.isEmpty())
+                printWarning("warning: error in directory for repo " + directory.getRepoShortname (repo));
+
+            return text;
+        };
+
+        Module module;
+
+        module.setRepo (test (directory.getRepoShortname (repo)));
+        module.setPath (test (directory.getRepoPath (repo)));
+        module.setSource (test (directory.getRepoSource (repo)));
+        module.setName (test (directory.getModuleName (m)));
+        module.setSubPath (test (directory.getModuleSubpath (m)));
+
+        /* Description is allowed to be empty. */
+        module.setDescription (directory.getModuleDescription (m));
+
+        return module;
+    }
+
+    DirectoryModel directory;
 };
 
 #endif  // REPOSITORY_H_INCLUDED
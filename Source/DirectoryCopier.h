@@ -0,0 +1,364 @@
+/*
+  ==============================================================================
+
+    DirectoryCopier.h
+    Created: 19 Oct 2026 9:12:04am
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef DIRECTORYCOPIER_H_INCLUDED
+#define DIRECTORYCOPIER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "Trace.h"
+#include "RunReport.h"
+#include <algorithm>
+
+#if JUCE_MAC || JUCE_LINUX
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <sys/stat.h>
+#endif
+
+#if JUCE_MAC
+ #include <copyfile.h>
+#endif
+
+#if JUCE_LINUX
+ #include <sys/sendfile.h>
+ #include <sys/syscall.h>
+#endif
+
+/**
+ * A replacement for File::copyDirectoryTo() which walks the source tree once,
+ * creates the directory skeleton up front and then copies the files on a pool
+ * of threads.
+ *
+ * File data is moved by the kernel where the platform allows it
+ * (copy_file_range or sendfile on Linux, fcopyfile on the Mac) and the
+ * destination is preallocated to its final size before any data is written.
+ */
+class DirectoryCopier
+{
+public:
+    struct Stats
+    {
+        int numFiles { 0 };
+        int numDirectories { 0 };
+        int64 numBytes { 0 };
+        int numFilesSkipped { 0 };
+        int64 numBytesSkipped { 0 };
+        double seconds { 0.0 };
+
+        double getMegabytesPerSecond() const
+        {
+            return seconds > 0.0 ? (numBytes / (1024.0 * 1024.0)) / seconds : 0.0;
+        }
+
+        String getSummaryString() const
+        {
+            auto s = "copied " + String (numFiles) + " files, "
+                     + String (numBytes / (1024.0 * 1024.0), 1) + "MB in "
+                     + String (seconds, 2) + "s ("
+                     + String (getMegabytesPerSecond(), 1) + "MB/s)";
+
+            if (numFilesSkipped > 0)
+                s << ", filtered out " << numFilesSkipped << " files";
+
+            return s;
+        }
+    };
+
+    DirectoryCopier (int numThreads_ = SystemStats::getNumCpus())
+        :
+        numThreads (jmax (1, numThreads_))
+    {}
+
+    /** Given a path relative to the source, with forward slashes, returns false to leave it out. */
+    typedef std::function<bool (const String& relativePath, bool isDirectory)> Filter;
+
+    /**
+     * Copies the contents of source into destination, creating destination if
+     * needed.  Existing files in the destination are overwritten.  Anything
+     * the filter rejects, and everything inside a rejected folder, is skipped.
+     * On failure getError() says what went wrong first.
+     */
+    bool copy (const File& source, const File& destination, Filter filter = nullptr)
+    {
+        TraceSpan span ("copy", "install");
+        RunReport::Phase phase ("copy");
+        const double startTime = Time::getMillisecondCounterHiRes();
+        stats = Stats();
+        error = String();
+
+        if (! source.isDirectory())
+        {
+            error = "nothing to copy at " + source.getFullPathName();
+            return false;
+        }
+
+        if (! destination.createDirectory())
+        {
+            error = "could not create " + destination.getFullPathName();
+            return false;
+        }
+
+        Array<Entry> files;
+        bool ok = true;
+
+        {
+            DirectoryIterator iter (source, true, "*", File::findFilesAndDirectories);
+            bool isDirectory = false;
+            int64 size = 0;
+            StringArray skippedFolders;
+
+            while (iter.next (&isDirectory, nullptr, &size, nullptr, nullptr, nullptr))
+            {
+                auto relativePath = iter.getFile().getRelativePathFrom (source);
+
+                if (filter != nullptr)
+                {
+                    auto path = relativePath.replaceCharacter ('\\', '/');
+
+                    if (isInside (path, skippedFolders) || ! filter (path, isDirectory))
+                    {
+                        if (isDirectory)
+                        {
+                            skippedFolders.add (path);
+                        }
+                        else
+                        {
+                            ++stats.numFilesSkipped;
+                            stats.numBytesSkipped += size;
+                        }
+
+                        continue;
+                    }
+                }
+
+                /* The iterator returns a folder before descending into it so
+                 * parents are always created before their children. */
+                if (isDirectory)
+                {
+                    if (! destination.getChildFile (relativePath).createDirectory() && ok)
+                    {
+                        error = "could not create " + destination.getChildFile (relativePath).getFullPathName();
+                        ok = false;
+                    }
+
+                    ++stats.numDirectories;
+                }
+                else
+                {
+                    Entry e;
+                    e.relativePath = relativePath;
+                    e.size = size;
+                    files.add (e);
+                }
+            }
+        }
+
+        /* Largest first so one big file doesn't end up being the tail. */
+        std::sort (files.begin(), files.end(),
+                   [] (const Entry & a, const Entry & b) { return a.size > b.size; });
+
+        std::atomic<bool> allCopied (true);
+        std::atomic<int64> bytesCopied (0);
+        std::mutex errorLock;
+
+        parallelFor (files.size(), numThreads, [&] (int i)
+        {
+            auto& e = files.getReference (i);
+
+            if (copyFile (source.getChildFile (e.relativePath), destination.getChildFile (e.relativePath), e.size))
+            {
+                bytesCopied += e.size;
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock (errorLock);
+
+            if (error.isEmpty())
+                error = "could not copy " + e.relativePath;
+
+            allCopied = false;
+        });
+
+        stats.numFiles = files.size();
+        stats.numBytes = bytesCopied;
+        stats.seconds = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+        RunReport::getInstance().addCopied (stats.numFiles, stats.numBytes);
+
+        span.setArg ("files", stats.numFiles);
+        span.setArg ("bytes", stats.numBytes);
+        span.setArg ("skipped", stats.numFilesSkipped);
+        return ok && allCopied;
+    }
+
+    const Stats& getStats() const
+    {
+        return stats;
+    }
+
+    String getError() const
+    {
+        return error;
+    }
+
+    /** Copies a single file, preferring a kernel-side copy. */
+    static bool copyFile (const File& source, const File& destination, int64 size)
+    {
+#if JUCE_MAC || JUCE_LINUX
+        const int in = open (source.getFullPathName().toRawUTF8(), O_RDONLY | O_CLOEXEC);
+
+        if (in < 0)
+            return false;
+
+        struct stat info;
+
+        if (fstat (in, &info) != 0)
+        {
+            close (in);
+            return false;
+        }
+
+        const int out = open (destination.getFullPathName().toRawUTF8(),
+                              O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                              info.st_mode & 0777);
+
+        if (out < 0)
+        {
+            close (in);
+            return false;
+        }
+
+        preallocate (out, size);
+        bool ok = copyFileDescriptor (in, out, size);
+
+#if JUCE_LINUX
+        /* posix_fallocate extended the file to the size seen when the tree was
+         * listed, so a source that shrank since would leave zeros on the end.
+         * The write offset is what was actually copied. */
+        const off_t copied = lseek (out, 0, SEEK_CUR);
+        ok = ok && copied >= 0 && ftruncate (out, copied) == 0;
+#endif
+
+        close (in);
+        return (close (out) == 0) && ok;
+#else
+        ignoreUnused (size);
+        return source.copyFileTo (destination);
+#endif
+    }
+
+private:
+    static bool isInside (const String& path, const StringArray& folders)
+    {
+        for (auto& f : folders)
+            if (path.startsWith (f + "/"))
+                return true;
+
+        return false;
+    }
+
+    struct Entry
+    {
+        String relativePath;
+        int64 size;
+    };
+
+#if JUCE_MAC || JUCE_LINUX
+    static void preallocate (int fd, int64 size)
+    {
+        if (size <= 0)
+            return;
+
+        /* A failure here isn't fatal, the copy just loses the benefit. */
+#if JUCE_LINUX
+        posix_fallocate (fd, 0, (off_t) size);
+#else
+        fstore_t store = { F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, (off_t) size, 0 };
+
+        if (fcntl (fd, F_PREALLOCATE, &store) == -1)
+        {
+            store.fst_flags = F_ALLOCATEALL;
+            fcntl (fd, F_PREALLOCATE, &store);
+        }
+#endif
+    }
+
+    static bool copyFileDescriptor (int in, int out, int64 size)
+    {
+#if JUCE_MAC
+        ignoreUnused (size);
+        return fcopyfile (in, out, nullptr, COPYFILE_DATA) == 0;
+#else
+        int64 remaining = size;
+
+       #ifdef SYS_copy_file_range
+        while (remaining > 0)
+        {
+            auto n = syscall (SYS_copy_file_range, in, nullptr, out, nullptr, (size_t) remaining, 0u);
+
+            if (n <= 0)
+                break;
+
+            remaining -= n;
+        }
+       #endif
+
+        /* copy_file_range refuses some file system combinations, sendfile
+         * still keeps the data in the kernel. */
+        while (remaining > 0)
+        {
+            auto n = sendfile (out, in, nullptr, (size_t) jmin (remaining, (int64) 0x7ffff000));
+
+            if (n <= 0)
+                break;
+
+            remaining -= n;
+        }
+
+        /* Picks up anything the kernel copy didn't manage, including data
+         * appended since the tree was listed. */
+        return copyWithBuffer (in, out);
+#endif
+    }
+
+    static bool copyWithBuffer (int in, int out)
+    {
+        HeapBlock<char> buffer (65536);
+
+        for (;;)
+        {
+            auto n = read (in, buffer, 65536);
+
+            if (n == 0)
+                return true;
+
+            if (n < 0)
+                return false;
+
+            for (ssize_t written = 0; written < n;)
+            {
+                auto w = write (out, buffer + written, (size_t) (n - written));
+
+                if (w <= 0)
+                    return false;
+
+                written += w;
+            }
+        }
+    }
+#endif
+
+    int numThreads;
+    Stats stats;
+    String error;
+};
+
+#endif  // DIRECTORYCOPIER_H_INCLUDED
@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    DirectoryDelta.h
+    Created: 20 Oct 2026 2:15:38pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef DIRECTORYDELTA_H_INCLUDED
+#define DIRECTORYDELTA_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+
+/**
+ * The changes between two versions of a directory.
+ *
+ * A directory carries a version number on its root, <jpm_directory version="12">.
+ * A client holding version 10 asks for <url>?since=10 and a server that still
+ * knows version 10 replies with:
+ *
+ *   <jpm_directory_delta from="10" version="12">
+ *     <repo shortname="..." path="..." source="...">     added or changed repo
+ *       <module name="..." .../>                         added or changed module
+ *       <remove_module name="..."/>
+ *     </repo>
+ *     <remove_repo shortname="..." path="..."/>
+ *   </jpm_directory_delta>
+ *
+ * Anyone else - including a plain file server that ignores the query - just
+ * sends the whole directory, which the client takes as a fresh snapshot.
+ *
+ * Repos are identified by shortname and path together, since shortnames
+ * needn't be unique, and modules by name within their repo.
+ */
+class DirectoryDelta
+{
+public:
+    static int getVersion (const ValueTree& directory)
+    {
+        return directory.getProperty ("version", 0);
+    }
+
+    static bool isDelta (const ValueTree& tree)
+    {
+        return tree.hasType ("jpm_directory_delta");
+    }
+
+    /** Everything needed to turn from into to.  Empty apart from versions if they match. */
+    static ValueTree compute (const ValueTree& from, const ValueTree& to)
+    {
+        ValueTree delta ("jpm_directory_delta");
+        delta.setProperty ("from", getVersion (from), nullptr);
+        delta.setProperty ("version", getVersion (to), nullptr);
+
+        for (auto oldRepo : ValueTreeChildrenConnector (from))
+        {
+            if (! findRepo (to, getRepoKey (oldRepo)).isValid())
+            {
+                ValueTree removal ("remove_repo");
+                removal.setProperty ("shortname", oldRepo["shortname"], nullptr);
+                removal.setProperty ("path", oldRepo["path"], nullptr);
+                delta.addChild (removal, -1, nullptr);
+            }
+        }
+
+        for (auto newRepo : ValueTreeChildrenConnector (to))
+        {
+            auto oldRepo = findRepo (from, getRepoKey (newRepo));
+
+            if (! oldRepo.isValid())
+            {
+                delta.addChild (newRepo.createCopy(), -1, nullptr);
+                continue;
+            }
+
+            ValueTree change (newRepo.getType());
+            change.copyPropertiesFrom (newRepo, nullptr);
+
+            for (auto oldModule : ValueTreeChildrenConnector (oldRepo))
+            {
+                if (! newRepo.getChildWithProperty ("name", oldModule["name"]).isValid())
+                {
+                    ValueTree removal ("remove_module");
+                    removal.setProperty ("name", oldModule["name"], nullptr);
+                    change.addChild (removal, -1, nullptr);
+                }
+            }
+
+            for (auto newModule : ValueTreeChildrenConnector (newRepo))
+            {
+                auto oldModule = oldRepo.getChildWithProperty ("name", newModule["name"]);
+
+                if (! oldModule.isValid() || ! oldModule.isEquivalentTo (newModule))
+                    change.addChild (newModule.createCopy(), -1, nullptr);
+            }
+
+            if (change.getNumChildren() > 0 || ! haveSameProperties (oldRepo, newRepo))
+                delta.addChild (change, -1, nullptr);
+        }
+
+        return delta;
+    }
+
+    /**
+     * Applies a delta in place.  Fails, leaving the directory untouched, if
+     * the delta wasn't made against this version.
+     */
+    static Result apply (ValueTree& directory, const ValueTree& delta)
+    {
+        if ((int) delta.getProperty ("from", -1) != getVersion (directory))
+            return Result::fail ("directory delta is against version " + delta["from"].toString()
+                                 + " but the cached copy is version " + String (getVersion (directory)));
+
+        for (auto change : ValueTreeChildrenConnector (delta))
+        {
+            auto repo = findRepo (directory, getRepoKey (change));
+
+            if (change.hasType ("remove_repo"))
+            {
+                directory.removeChild (repo, nullptr);
+                continue;
+            }
+
+            if (! repo.isValid())
+            {
+                directory.addChild (change.createCopy(), -1, nullptr);
+                continue;
+            }
+
+            repo.copyPropertiesFrom (change, nullptr);
+
+            for (auto module : ValueTreeChildrenConnector (change))
+            {
+                auto existing = repo.getChildWithProperty ("name", module["name"]);
+
+                if (module.hasType ("remove_module"))
+                    repo.removeChild (existing, nullptr);
+                else if (existing.isValid())
+                    existing.copyPropertiesFrom (module, nullptr);
+                else
+                    repo.addChild (module.createCopy(), -1, nullptr);
+            }
+        }
+
+        directory.setProperty ("version", delta["version"], nullptr);
+        return Result::ok();
+    }
+
+    static String getRepoKey (const ValueTree& repo)
+    {
+        return repo["shortname"].toString() + " " + repo["path"].toString();
+    }
+
+private:
+    static ValueTree findRepo (const ValueTree& directory, const String& key)
+    {
+        for (auto repo : ValueTreeChildrenConnector (directory))
+            if (getRepoKey (repo) == key)
+                return repo;
+
+        return ValueTree::invalid;
+    }
+
+    static bool haveSameProperties (const ValueTree& a, const ValueTree& b)
+    {
+        ValueTree x (a.getType()), y (b.getType());
+        x.copyPropertiesFrom (a, nullptr);
+        y.copyPropertiesFrom (b, nullptr);
+        return x.isEquivalentTo (y);
+    }
+};
+
+#endif  // DIRECTORYDELTA_H_INCLUDED
@@ -0,0 +1,309 @@
+/*
+  ==============================================================================
+
+    DirectoryIndex.h
+    Created: 20 Oct 2026 3:40:21pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef DIRECTORYINDEX_H_INCLUDED
+#define DIRECTORYINDEX_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "DirectoryDelta.h"
+#include <map>
+#include <set>
+
+/**
+ * Merges several directories into one, with earlier layers shadowing later
+ * ones.  A module is shadowed when a higher layer has a module of the same
+ * name in a repo with the same shortname, so a company directory can point
+ * juce/juce_core at its own fork while still picking up the rest of the
+ * public directory.
+ *
+ * The merged result is written to directory.index.xml, in the same format as
+ * a single directory, for DirectoryModel to read.  A copy of each layer is
+ * kept beside it and a hash of each in a small state file.  When all the
+ * hashes match nothing else is read; when a layer changes only the modules in
+ * repos it added, changed or removed are resolved again.
+ */
+class DirectoryIndex
+{
+public:
+    struct Layer
+    {
+        String source;
+        File file;
+    };
+
+    DirectoryIndex (const File& folder)
+        :
+        mergedFile (folder.getChildFile ("directory.index.xml")),
+        layersFile (folder.getChildFile ("directory.index.layers.xml")),
+        stateFile (folder.getChildFile ("directory.index.state"))
+    {}
+
+    /** Layers in priority order, highest first. */
+    void update (const Array<Layer>& layers)
+    {
+        StringArray state;
+
+        for (auto& l : layers)
+            state.add ((l.file.existsAsFile() ? MD5 (l.file).toHexString() : String ("none")) + " " + l.source);
+
+        if (mergedFile.existsAsFile() && StringArray::fromLines (stateFile.loadFileAsString()) == state)
+            return;
+
+        loadIndex();
+
+        auto stored = getStoredLayers();
+        bool sameSources = stored.size() == layers.size();
+
+        for (int i = 0; sameSources && i < layers.size(); ++i)
+            sameSources = stored[i]["source"] == layers[i].source;
+
+        if (! sameSources)
+        {
+            rebuild (layers, state);
+            save (state);
+            return;
+        }
+
+        std::set<String> touched;
+
+        for (int i = 0; i < layers.size(); ++i)
+        {
+            auto hash = state[i].upToFirstOccurrenceOf (" ", false, false);
+
+            if (stored[i]["hash"].toString() == hash)
+                continue;
+
+            auto directory = loadDirectory (layers[i].file);
+            collectTouchedModules (stored[i], directory, touched);
+            replaceLayerContents (stored[i], directory, hash);
+        }
+
+        for (auto& key : touched)
+            resolve (key);
+
+        removeEmptyRepos();
+        save (state);
+    }
+
+    /** The merged directory. */
+    File getFile() const
+    {
+        return mergedFile;
+    }
+
+private:
+    static String getModuleKey (const ValueTree& repo, const ValueTree& module)
+    {
+        return repo["shortname"].toString() + "/" + module["name"].toString();
+    }
+
+    static ValueTree loadDirectory (const File& file)
+    {
+        ScopedPointer<XmlElement> xml = XmlDocument (file).getDocumentElement();
+        return xml != nullptr ? ValueTree::fromXml (*xml) : ValueTree ("jpm_directory");
+    }
+
+    ValueTree getMerged() const
+    {
+        return index.getChildWithName ("jpm_directory");
+    }
+
+    /** Reads the layer copies and the merged directory, which are only needed to change it. */
+    void loadIndex()
+    {
+        ScopedPointer<XmlElement> xml = XmlDocument (layersFile).getDocumentElement();
+        index = xml != nullptr ? ValueTree::fromXml (*xml) : ValueTree ("jpm_directory_index");
+        index.addChild (loadDirectory (mergedFile), -1, nullptr);
+        rebuildLookup();
+    }
+
+    Array<ValueTree> getStoredLayers() const
+    {
+        Array<ValueTree> layers;
+
+        for (auto child : ValueTreeChildrenConnector (index))
+            if (child.hasType ("layer"))
+                layers.add (child);
+
+        return layers;
+    }
+
+    void rebuild (const Array<Layer>& layers, const StringArray& state)
+    {
+        index = ValueTree ("jpm_directory_index");
+        Array<ValueTree> directories;
+
+        for (int i = 0; i < layers.size(); ++i)
+        {
+            directories.add (loadDirectory (layers[i].file));
+
+            ValueTree layer ("layer");
+            layer.setProperty ("source", layers[i].source, nullptr);
+            replaceLayerContents (layer, directories[i], state[i].upToFirstOccurrenceOf (" ", false, false));
+            index.addChild (layer, -1, nullptr);
+        }
+
+        ValueTree merged ("jpm_directory");
+        index.addChild (merged, -1, nullptr);
+        std::set<String> seen;
+
+        for (int i = 0; i < directories.size(); ++i)
+            for (auto repo : ValueTreeChildrenConnector (directories[i]))
+                for (auto module : ValueTreeChildrenConnector (repo))
+                    if (seen.insert (getModuleKey (repo, module)).second)
+                        addToMerged (i, repo, module);
+
+        rebuildLookup();
+    }
+
+    static void replaceLayerContents (ValueTree layer, const ValueTree& directory, const String& hash)
+    {
+        layer.removeAllChildren (nullptr);
+
+        for (auto repo : ValueTreeChildrenConnector (directory))
+            layer.addChild (repo.createCopy(), -1, nullptr);
+
+        layer.setProperty ("hash", hash, nullptr);
+    }
+
+    /** Every module in a repo that the layer's change added, altered or removed. */
+    static void collectTouchedModules (const ValueTree& oldLayer, const ValueTree& newDirectory, std::set<String>& touched)
+    {
+        ValueTree oldDirectory ("jpm_directory");
+
+        for (auto repo : ValueTreeChildrenConnector (oldLayer))
+            oldDirectory.addChild (repo.createCopy(), -1, nullptr);
+
+        auto delta = DirectoryDelta::compute (oldDirectory, newDirectory);
+
+        for (auto change : ValueTreeChildrenConnector (delta))
+        {
+            auto key = DirectoryDelta::getRepoKey (change);
+
+            const ValueTree* directories[] = { &oldDirectory, &newDirectory };
+
+            for (auto* directory : directories)
+                for (auto repo : ValueTreeChildrenConnector (*directory))
+                    if (DirectoryDelta::getRepoKey (repo) == key)
+                        for (auto module : ValueTreeChildrenConnector (repo))
+                            touched.insert (getModuleKey (repo, module));
+        }
+    }
+
+    /** Puts whichever layer now provides key into the merged directory. */
+    void resolve (const String& key)
+    {
+        auto current = modulesByKey.find (key);
+
+        if (current != modulesByKey.end())
+        {
+            auto module = current->second;
+            module.getParent().removeChild (module, nullptr);
+            modulesByKey.erase (current);
+        }
+
+        auto layers = getStoredLayers();
+
+        for (int i = 0; i < layers.size(); ++i)
+        {
+            for (auto repo : ValueTreeChildrenConnector (layers[i]))
+            {
+                if (key.upToFirstOccurrenceOf ("/", false, false) != repo["shortname"].toString())
+                    continue;
+
+                auto module = repo.getChildWithProperty ("name", key.fromFirstOccurrenceOf ("/", false, false));
+
+                if (module.isValid())
+                {
+                    modulesByKey[key] = addToMerged (i, repo, module);
+                    return;
+                }
+            }
+        }
+    }
+
+    ValueTree addToMerged (int layerIndex, const ValueTree& repo, const ValueTree& module)
+    {
+        auto merged = getMerged();
+        ValueTree target;
+
+        for (auto r : ValueTreeChildrenConnector (merged))
+        {
+            if ((int) r["layer"] == layerIndex && DirectoryDelta::getRepoKey (r) == DirectoryDelta::getRepoKey (repo))
+            {
+                target = r;
+                break;
+            }
+        }
+
+        if (! target.isValid())
+        {
+            target = ValueTree (repo.getType());
+            target.copyPropertiesFrom (repo, nullptr);
+            target.setProperty ("layer", layerIndex, nullptr);
+            merged.addChild (target, -1, nullptr);
+        }
+
+        /* The repo's attributes may have changed along with the module. */
+        auto layer = target["layer"];
+        target.copyPropertiesFrom (repo, nullptr);
+        target.setProperty ("layer", layer, nullptr);
+
+        auto copy = module.createCopy();
+        target.addChild (copy, -1, nullptr);
+        return copy;
+    }
+
+    void removeEmptyRepos()
+    {
+        auto merged = getMerged();
+
+        for (int i = merged.getNumChildren(); --i >= 0;)
+            if (merged.getChild (i).getNumChildren() == 0)
+                merged.removeChild (i, nullptr);
+    }
+
+    void rebuildLookup()
+    {
+        modulesByKey.clear();
+
+        for (auto repo : ValueTreeChildrenConnector (getMerged()))
+            for (auto module : ValueTreeChildrenConnector (repo))
+                modulesByKey[getModuleKey (repo, module)] = module;
+    }
+
+    void save (const StringArray& state)
+    {
+        ValueTree layers (index.createCopy());
+        layers.removeChild (layers.getChildWithName ("jpm_directory"), nullptr);
+
+        ScopedPointer<XmlElement> layersXml (layers.createXml());
+        ScopedPointer<XmlElement> mergedXml (getMerged().createXml());
+
+        if (layersXml == nullptr || mergedXml == nullptr
+            || ! layersXml->writeToFile (layersFile, String())
+            || ! mergedXml->writeToFile (mergedFile, String()))
+        {
+            stateFile.deleteFile();
+            return;
+        }
+
+        /* Written last, so an interrupted save is redone next time. */
+        stateFile.replaceWithText (state.joinIntoString ("\n"));
+    }
+
+    File mergedFile, layersFile, stateFile;
+    ValueTree index { "jpm_directory_index" };
+
+    std::map<String, ValueTree> modulesByKey;
+};
+
+#endif  // DIRECTORYINDEX_H_INCLUDED
@@ -0,0 +1,472 @@
+/*
+  ==============================================================================
+
+    DirectoryModel.h
+    Created: 20 Oct 2026 5:12:56pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef DIRECTORYMODEL_H_INCLUDED
+#define DIRECTORYMODEL_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Each distinct string stored once, end to end in a single block, and
+ * referred to by its offset.  Directories repeat the same repo names, paths
+ * and sources a great deal, so this is much smaller than a String per field.
+ */
+class StringArena
+{
+public:
+    typedef uint32 Id;
+
+    StringArena()
+    {
+        chars.push_back (0); /* Id 0 is the empty string. */
+        table.resize (1024, 0);
+    }
+
+    /** Returns the id of an existing copy, or stores a new one. */
+    Id intern (const char* text, size_t length)
+    {
+        if (length == 0)
+            return 0;
+
+        size_t slot = findSlot (text, length);
+
+        if (table[slot] != 0)
+            return table[slot];
+
+        const Id id = (Id) chars.size();
+        chars.insert (chars.end(), text, text + length);
+        chars.push_back (0);
+        table[slot] = id;
+
+        if (++count * 2 > table.size())
+            growTable();
+
+        return id;
+    }
+
+    /** Returns the id of text, or -1 if it isn't stored. */
+    int64 find (const String& text) const
+    {
+        auto* utf8 = text.toRawUTF8();
+        const size_t length = strlen (utf8);
+
+        if (length == 0)
+            return 0;
+
+        auto id = table[findSlot (utf8, length)];
+        return id != 0 ? (int64) id : -1;
+    }
+
+    const char* get (Id id) const
+    {
+        return chars.data() + id;
+    }
+
+    String toString (Id id) const
+    {
+        return String::fromUTF8 (get (id));
+    }
+
+    size_t getNumBytes() const
+    {
+        return chars.size() + table.size() * sizeof (Id);
+    }
+
+private:
+    static size_t hash (const char* text, size_t length)
+    {
+        /* FNV-1a */
+        uint64 h = 14695981039346656037ULL;
+
+        for (size_t i = 0; i < length; ++i)
+            h = (h ^ (uint8) text[i]) * 1099511628211ULL;
+
+        return (size_t) h;
+    }
+
+    size_t findSlot (const char* text, size_t length) const
+    {
+        const size_t mask = table.size() - 1;
+        size_t slot = hash (text, length) & mask;
+
+        while (table[slot] != 0)
+        {
+            auto* existing = get (table[slot]);
+
+            if (strncmp (existing, text, length) == 0 && existing[length] == 0)
+                break;
+
+            slot = (slot + 1) & mask;
+        }
+
+        return slot;
+    }
+
+    void growTable()
+    {
+        std::vector<Id> old;
+        old.swap (table);
+        table.resize (old.size() * 2, 0);
+
+        for (auto id : old)
+            if (id != 0)
+                table[findSlot (get (id), strlen (get (id)))] = id;
+    }
+
+    std::vector<char> chars;
+    std::vector<Id> table;
+    size_t count { 0 };
+};
+
+/**
+ * A directory held as columns: one array per field, repos and modules
+ * numbered from zero, and modules referring to their repo by number.  It's
+ * built in a single pass over the XML without an intermediate document, and
+ * nothing is allocated per entry beyond the column slots and any new strings.
+ * Module objects are only made by the caller, for the entries it returns.
+ */
+class DirectoryModel
+{
+public:
+    typedef StringArena::Id Id;
+
+    bool loadFile (const File& file)
+    {
+        MemoryBlock data;
+        return file.loadFileAsData (data) && parse (static_cast<const char*> (data.getData()), data.getSize());
+    }
+
+    bool parse (const String& text)
+    {
+        return parse (text.toRawUTF8(), text.getNumBytesAsUTF8());
+    }
+
+    /** Returns false if the text isn't a well formed directory. */
+    bool parse (const char* text, size_t size)
+    {
+        const char* p = text;
+        const char* end = text + size;
+        int currentRepo = -1;
+        bool sawRoot = false;
+
+        for (;;)
+        {
+            while (p < end && *p != '<')
+                ++p;
+
+            if (p >= end)
+                return sawRoot;
+
+            if (startsWith (p, end, "<!--"))
+            {
+                p = skipPast (p, end, "-->");
+                continue;
+            }
+
+            if (startsWith (p, end, "<?") || startsWith (p, end, "<!"))
+            {
+                p = skipPast (p, end, ">");
+                continue;
+            }
+
+            if (startsWith (p, end, "</"))
+            {
+                auto* name = p + 2;
+                p = skipPast (p, end, ">");
+
+                if (isTag (name, end, "repo"))
+                    currentRepo = -1;
+
+                continue;
+            }
+
+            ++p;
+            auto* nameStart = p;
+
+            while (p < end && isNameChar (*p))
+                ++p;
+
+            Attributes attributes;
+
+            if (! parseAttributes (p, end, attributes))
+                return false;
+
+            const bool selfClosing = p[-2] == '/';
+
+            if (isTag (nameStart, end, "jpm_directory"))
+            {
+                sawRoot = true;
+            }
+            else if (isTag (nameStart, end, "repo"))
+            {
+                repoShortname.push_back (attributes.shortname);
+                repoPath.push_back (attributes.path);
+                repoSource.push_back (attributes.source);
+                currentRepo = selfClosing ? -1 : (int) repoShortname.size() - 1;
+            }
+            else if (isTag (nameStart, end, "module") && currentRepo >= 0)
+            {
+                const int index = (int) moduleName.size();
+                moduleName.push_back (attributes.name);
+                moduleDescription.push_back (attributes.description);
+                moduleSubpath.push_back (attributes.subpath);
+                moduleRepo.push_back (currentRepo);
+                addToNameIndex (attributes.name, index);
+            }
+        }
+    }
+
+    int getNumRepos() const     { return (int) repoShortname.size(); }
+    int getNumModules() const   { return (int) moduleName.size(); }
+
+    String getRepoShortname (int repo) const        { return strings.toString (repoShortname[(size_t) repo]); }
+    String getRepoPath (int repo) const             { return strings.toString (repoPath[(size_t) repo]); }
+    String getRepoSource (int repo) const           { return strings.toString (repoSource[(size_t) repo]); }
+
+    String getModuleName (int module) const         { return strings.toString (moduleName[(size_t) module]); }
+    String getModuleDescription (int module) const  { return strings.toString (moduleDescription[(size_t) module]); }
+    String getModuleSubpath (int module) const      { return strings.toString (moduleSubpath[(size_t) module]); }
+    int getModuleRepo (int module) const            { return moduleRepo[(size_t) module]; }
+
+    /** True if the module's repo has this shortname; compares ids, not text. */
+    bool isInRepo (int module, int64 shortnameId) const
+    {
+        return (int64) repoShortname[(size_t) moduleRepo[(size_t) module]] == shortnameId;
+    }
+
+    /** Modules with exactly this name, in directory order. */
+    Array<int> findModules (const String& name) const
+    {
+        Array<int> result;
+        auto id = strings.find (name);
+
+        if (id < 0)
+            return result;
+
+        auto it = nameIndex.find ((Id) id);
+
+        if (it != nameIndex.end())
+            for (int m = it->second.first; m >= 0; m = nextWithSameName[(size_t) m])
+                result.add (m);
+
+        return result;
+    }
+
+    /** Returns the id of a string if any field uses it, or -1. */
+    int64 findString (const String& text) const
+    {
+        return strings.find (text);
+    }
+
+    size_t getMemoryUsage() const
+    {
+        return strings.getNumBytes()
+               + (repoShortname.capacity() * 3 + moduleName.capacity() * 3) * sizeof (Id)
+               + (moduleRepo.capacity() + nextWithSameName.capacity()) * sizeof (int)
+               + nameIndex.size() * (sizeof (Id) + 2 * sizeof (int));
+    }
+
+private:
+    struct Attributes
+    {
+        Id shortname { 0 }, path { 0 }, source { 0 };
+        Id name { 0 }, description { 0 }, subpath { 0 };
+    };
+
+    /** Reads attributes up to and including the closing '>'. */
+    bool parseAttributes (const char*& p, const char* end, Attributes& attributes)
+    {
+        for (;;)
+        {
+            while (p < end && isWhitespace (*p))
+                ++p;
+
+            if (p >= end)
+                return false;
+
+            if (*p == '>')
+            {
+                ++p;
+                return true;
+            }
+
+            if (*p == '/' && p + 1 < end && p[1] == '>')
+            {
+                p += 2;
+                return true;
+            }
+
+            auto* nameStart = p;
+
+            while (p < end && isNameChar (*p))
+                ++p;
+
+            const size_t nameLength = (size_t) (p - nameStart);
+
+            while (p < end && isWhitespace (*p))
+                ++p;
+
+            if (nameLength == 0 || p >= end || *p++ != '=')
+                return false;
+
+            while (p < end && isWhitespace (*p))
+                ++p;
+
+            if (p >= end || (*p != '"' && *p != '\''))
+                return false;
+
+            const char quote = *p++;
+            auto* valueStart = p;
+
+            while (p < end && *p != quote)
+                ++p;
+
+            if (p >= end)
+                return false;
+
+            Id* field = getField (attributes, nameStart, nameLength);
+
+            if (field != nullptr)
+                *field = internValue (valueStart, (size_t) (p - valueStart));
+
+            ++p;
+        }
+    }
+
+    static Id* getField (Attributes& a, const char* name, size_t length)
+    {
+        auto is = [name, length] (const char* s) { return strlen (s) == length && memcmp (s, name, length) == 0; };
+
+        if (is ("shortname"))   return &a.shortname;
+        if (is ("path"))        return &a.path;
+        if (is ("source"))      return &a.source;
+        if (is ("name"))        return &a.name;
+        if (is ("description")) return &a.description;
+        if (is ("subpath"))     return &a.subpath;
+
+        return nullptr;
+    }
+
+    /** Values without entities are interned straight from the source text. */
+    Id internValue (const char* text, size_t length)
+    {
+        if (memchr (text, '&', length) == nullptr)
+            return strings.intern (text, length);
+
+        scratch.clear();
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            if (text[i] != '&')
+            {
+                scratch.push_back (text[i]);
+                continue;
+            }
+
+            auto* semicolon = static_cast<const char*> (memchr (text + i, ';', length - i));
+
+            if (semicolon == nullptr)
+            {
+                scratch.push_back (text[i]);
+                continue;
+            }
+
+            const String entity (text + i + 1, (size_t) (semicolon - (text + i + 1)));
+            juce_wchar c = 0;
+
+            if (entity == "amp")        c = '&';
+            else if (entity == "lt")    c = '<';
+            else if (entity == "gt")    c = '>';
+            else if (entity == "quot")  c = '"';
+            else if (entity == "apos")  c = '\'';
+            else if (entity.startsWith ("#x"))  c = (juce_wchar) entity.substring (2).getHexValue32();
+            else if (entity.startsWith ("#"))   c = (juce_wchar) entity.substring (1).getIntValue();
+
+            if (c == 0)
+            {
+                scratch.push_back (text[i]);
+                continue;
+            }
+
+            char utf8[8];
+            auto n = CharPointer_UTF8::getBytesRequiredFor (c);
+            CharPointer_UTF8 (utf8).write (c);
+            scratch.insert (scratch.end(), utf8, utf8 + n);
+            i = (size_t) (semicolon - text);
+        }
+
+        return strings.intern (scratch.data(), scratch.size());
+    }
+
+    void addToNameIndex (Id name, int module)
+    {
+        nextWithSameName.push_back (-1);
+        auto it = nameIndex.find (name);
+
+        if (it == nameIndex.end())
+        {
+            nameIndex[name] = std::make_pair (module, module);
+            return;
+        }
+
+        nextWithSameName[(size_t) it->second.second] = module;
+        it->second.second = module;
+    }
+
+    static bool startsWith (const char* p, const char* end, const char* prefix)
+    {
+        const size_t length = strlen (prefix);
+        return (size_t) (end - p) >= length && memcmp (p, prefix, length) == 0;
+    }
+
+    static bool isTag (const char* name, const char* end, const char* tag)
+    {
+        const size_t length = strlen (tag);
+        return startsWith (name, end, tag) && (name + length >= end || ! isNameChar (name[length]));
+    }
+
+    static const char* skipPast (const char* p, const char* end, const char* terminator)
+    {
+        const size_t length = strlen (terminator);
+
+        for (; p + length <= end; ++p)
+            if (memcmp (p, terminator, length) == 0)
+                return p + length;
+
+        return end;
+    }
+
+    static bool isWhitespace (char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    static bool isNameChar (char c)
+    {
+        return CharacterFunctions::isLetterOrDigit (c) || c == '_' || c == '-' || c == ':' || c == '.';
+    }
+
+    StringArena strings;
+    std::vector<char> scratch;
+
+    std::vector<Id> repoShortname, repoPath, repoSource;
+    std::vector<Id> moduleName, moduleDescription, moduleSubpath;
+    std::vector<int> moduleRepo;
+
+    /* Modules with the same name are chained together; the index holds the
+     * first and last of each chain. */
+    std::unordered_map<Id, std::pair<int, int>> nameIndex;
+    std::vector<int> nextWithSameName;
+};
+
+#endif  // DIRECTORYMODEL_H_INCLUDED
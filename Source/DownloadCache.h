@@ -4,7 +4,18 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "Utilities.h"
+#include "ZipExtractor.h"
+#include "TarStream.h"
+#include "TransferEngine.h"
+#include "ResumableDownload.h"
+#include "Progress.h"
+#include "Mirrors.h"
+#include "Trace.h"
+#include "CacheStats.h"
+#include "RunReport.h"
 #include <iostream>
+#include <map>
+#include <mutex>
 
 /** 
  * Stores downloaded files in a temporary loction and reuses those temporary
@@ -17,7 +28,7 @@ public:
 
     DownloadCache()
     {
-        location = File::getSpecialLocation (File::userApplicationDataDirectory).getChildFile ("jpm.modulecache");
+        location = Settings::getInstance().getCacheFolder();
         location.createDirectory();
     }
 
@@ -29,16 +40,35 @@ public:
 
     String downloadTextFile (URL remoteFile)
     {
+        TraceSpan span ("fetch text", "cache");
         auto cachedFile = getCachedFileLocation (remoteFile);
+        auto& stats = CacheStats::getInstance();
+        auto urlString = remoteFile.toString (true);
 
         if (cachedFile.exists() && isRecent (cachedFile))
+        {
+            span.setArg ("cache", "hit");
+            stats.record (cachedFile, urlString, CacheStats::hit, 0, cachedFile.getSize());
             return cachedFile.loadFileAsString();
+        }
 
-        String result = remoteFile.readEntireTextStream();
+        String result = Mirrors::getInstance().fetchText (urlString);
 
         if (result.isEmpty())
+        {
+            span.setArg ("cache", "fallback");
+
+            if (cachedFile.exists())
+                stats.record (cachedFile, urlString, CacheStats::fallback, 0, cachedFile.getSize());
+
             return cachedFile.loadFileAsString(); /* fallback to cached version. */
-        
+        }
+
+        const int64 size = (int64) result.getNumBytesAsUTF8();
+        span.setArg ("cache", "miss");
+        span.setArg ("bytes", size);
+        stats.record (cachedFile, urlString, cachedFile.exists() ? CacheStats::revalidation : CacheStats::miss, size);
+        stats.setExtractedSize (cachedFile, size);
         cachedFile.replaceWithText (result);
         return result;
     }
@@ -64,19 +94,60 @@ public:
      * modes. */
     File downloadUrlAndUncompress (URL urlToGet)
     {
+        TraceSpan span ("download zip", "cache");
+
+        if (span.isActive())
+            span.setArg ("url", urlToGet.toString (true));
+
         auto target = getCachedFileLocation (urlToGet);
+        auto entryLock = getEntryLock (target);
+        std::lock_guard<std::mutex> lock (*entryLock);
+
+        auto& stats = CacheStats::getInstance();
+        auto canonicalUrl = urlToGet.toString (true);
 
         if (target.exists() && isRecent (target))
+        {
+            span.setArg ("cache", "hit");
+            stats.record (target, canonicalUrl, CacheStats::hit);
             return target;
+        }
 
-        MemoryBlock memoryBlock;
+        auto archive = getArchiveLocation (urlToGet);
+        bool downloaded = false;
+        int64 bytesDownloaded = 0;
 
-        if (! readEntireBinaryStreamWithProgressBar (urlToGet, memoryBlock))
+        /* The cache is keyed on the upstream URL whichever mirror serves it. */
+        for (auto& source : Mirrors::getInstance().rankArchiveSources (urlToGet.toString (true)))
+        {
+            ResumableDownload download ((URL (source)), archive);
+            const double start = Time::getMillisecondCounterHiRes();
+            downloaded = download.run();
+
+            TransferResult outcome;
+            outcome.statusCode = downloaded ? 200 : 0;
+            outcome.bytesReceived = download.getBytesDownloaded();
+            outcome.seconds = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+            Mirrors::getInstance().record (source, outcome);
+            bytesDownloaded += outcome.bytesReceived;
+
+            if (downloaded)
+            {
+                span.setArg ("bytes", outcome.bytesReceived);
+                break;
+            }
+
+            printWarning ("could not download " + source);
+        }
+
+        if (! downloaded)
         {
             auto urlString = urlToGet.toString (false);
 
             if (target.exists())
             {
+                span.setArg ("cache", "fallback");
+                stats.record (target, canonicalUrl, CacheStats::fallback, bytesDownloaded);
                 printWarning ("error downloading file - using cached version of " + urlString);
                 return target;
             }
@@ -87,62 +158,310 @@ public:
             }
         }
 
-        MemoryInputStream inputStream (memoryBlock, false);
-
+        span.setArg ("cache", "miss");
+        stats.record (target, canonicalUrl, target.exists() ? CacheStats::revalidation : CacheStats::miss, bytesDownloaded);
         printInfo("uncompressing to " + target.getFullPathName());
 
-        ZipFile zip (inputStream);
-        auto result = zip.uncompressTo (target, true);
+        /* Extracted alongside and swapped in, so a failure leaves the old copy intact. */
+        auto partial = target.getSiblingFile (target.getFileName() + ".partial");
+        partial.deleteRecursively();
+
+        ZipExtractor extractor;
+        auto result = extractor.extract (archive, partial);
 
         if (result.failed())
         {
+            partial.deleteRecursively();
             printError (result.getErrorMessage());
+
+            if (target.exists())
+            {
+                printWarning ("using cached version of " + urlToGet.toString (false));
+                return target;
+            }
+
             return File::nonexistent;
         }
 
+        target.deleteRecursively();
+        partial.moveFileTo (target);
+
+        /* The tree is what's used from now on; a fresh download replaces both. */
+        archive.deleteFile();
+
+        stats.setExtractedSize (target, CacheStats::getSizeOnDisk (target));
         return target;
     }
 
-    static bool progressBar (void* context, int bytesSent, int totalBytes)
+    /**
+     * Where the raw archive for a URL is kept.  Partial downloads sit next to
+     * it until they complete, so an interrupted download carries on from where
+     * it stopped next time.  Once extracted the archive is deleted.
+     */
+    File getArchiveLocation (const URL& urlToGet)
     {
-        std::cout << "Connecting..." << bytesSent << "/" << totalBytes << "\r";
-        return true; /* means continue the download. */
+        auto entry = getCachedFileLocation (urlToGet);
+        return entry.getSiblingFile (entry.getFileName() + ".archive");
     }
 
-    static bool readEntireBinaryStreamWithProgressBar (URL url, MemoryBlock& destData)
+    /**
+     * Downloads a .tar.gz and extracts it while it is still arriving, so the
+     * tree is complete shortly after the last byte comes in.  The engine's
+     * thread feeds the decompressor through a pipe which, as that thread
+     * mustn't block, grows rather than pushing back if extraction falls
+     * behind; at worst it holds the whole compressed archive.
+     *
+     * The compressed bytes are also kept next to the entry as they arrive.
+     * A stream that breaks off is continued from them with Range and
+     * If-Range, for as long as each attempt gets further; extraction starts
+     * again, reading what's on disk before the rest from the network.
+     *
+     * The whole tree is extracted and the entry is keyed on the URL alone, so
+     * every module in a repository shares one download.  That rules out
+     * filtering here, as modules sharing the download may filter differently;
+     * the subpath is found inside the tree afterwards and install filters are
+     * applied as a module is copied into the store, so the cost of what they
+     * leave out is paid once per repository rather than once per install.
+     * Returns File::nonexistent on failure, in which case nothing is cached.
+     */
+    File downloadUrlAndStreamExtract (URL urlToGet)
     {
-        const ScopedPointer<InputStream> in (url.createInputStream (false,
-                                             &DownloadCache::progressBar));
+        TraceSpan span ("download tarball", "cache");
+
+        if (span.isActive())
+            span.setArg ("url", urlToGet.toString (true));
 
-        if (in != nullptr)
+        auto target = getCachedFileLocation (urlToGet);
+        auto entryLock = getEntryLock (target);
+        std::lock_guard<std::mutex> lock (*entryLock);
+
+        auto& stats = CacheStats::getInstance();
+        auto canonicalUrl = urlToGet.toString (true);
+
+        if (target.exists() && isRecent (target))
         {
-            int64 total = 0;
-            int64 numBytesReceived = 0;
-            int64 totalAvailable = in->getTotalLength();
+            span.setArg ("cache", "hit");
+            stats.record (target, canonicalUrl, CacheStats::hit);
+            return target;
+        }
+
+        auto urlString = urlToGet.toString (false);
+        auto partial = target.getSiblingFile (target.getFileName() + ".partial");
+        auto archive = target.getSiblingFile (target.getFileName() + ".tar.gz.download");
+        Result result (Result::fail ("no sources for " + urlString));
+        int64 bytesDownloaded = 0;
 
-            do
+        printInfo ("streaming into " + target.getFullPathName());
+
+        for (auto& source : Mirrors::getInstance().rankArchiveSources (urlToGet.toString (true)))
+        {
+            for (int attempt = 1; attempt <= maxStreamAttempts; ++attempt)
             {
-                MemoryOutputStream mo (destData, true);
-                numBytesReceived = mo.writeFromInputStream (*in, 4096);
-                total += numBytesReceived;
-                std::cout
-                        << "download progress ... "
-                        << total / 1024
-                        << "k of "
-                        << totalAvailable / 1024
-                        << "k             \r";
+                partial.deleteRecursively();
+                partial.createDirectory();
+
+                const int64 before = archive.existsAsFile() ? archive.getSize() : 0;
+                result = streamExtract (URL (source), partial, archive, bytesDownloaded);
+
+                /* Retrying without progress won't help. */
+                if (result.wasOk() || ! archive.existsAsFile() || archive.getSize() <= before)
+                    break;
+
+                printWarning (result.getErrorMessage() + ", resuming");
             }
-            while (numBytesReceived == 4096);
 
-            std::cout << std::endl;
+            if (result.wasOk())
+                break;
+
+            printWarning (result.getErrorMessage());
+        }
+
+        if (result.failed())
+        {
+            partial.deleteRecursively();
+
+            if (target.exists())
+            {
+                span.setArg ("cache", "fallback");
+                stats.record (target, canonicalUrl, CacheStats::fallback, bytesDownloaded);
+                printWarning ("error downloading file - using cached version of " + urlString);
+                return target;
+            }
 
-            return true;
+            return File::nonexistent;
         }
 
-        return false;
+        span.setArg ("cache", "miss");
+        stats.record (target, canonicalUrl, target.exists() ? CacheStats::revalidation : CacheStats::miss, bytesDownloaded);
+        target.deleteRecursively();
+        partial.moveFileTo (target);
+        stats.setExtractedSize (target, CacheStats::getSizeOnDisk (target));
+        return target;
+    }
+
+    /**
+     * Modules are installed in parallel and several can come from the same
+     * archive, so work on a cache entry is done by one thread at a time; the
+     * others then find it fresh in the cache.
+     */
+    static std::shared_ptr<std::mutex> getEntryLock (const File& entry)
+    {
+        static std::mutex locksLock;
+        static std::map<String, std::shared_ptr<std::mutex>> locks;
+
+        std::lock_guard<std::mutex> lock (locksLock);
+        auto& m = locks[entry.getFullPathName()];
+
+        if (m == nullptr)
+            m = std::make_shared<std::mutex>();
+
+        return m;
     }
 
     File location;
+
+private:
+    static const int maxStreamAttempts = 5;
+
+    /**
+     * bytesDownloaded is increased by what came over the network, whether or
+     * not it worked.  archive keeps the compressed bytes, with the source and
+     * validator in archive.xml, until the download has completed.
+     */
+    Result streamExtract (const URL& source, const File& destination, const File& archive, int64& bytesDownloaded)
+    {
+        TraceSpan span ("stream extract", "download");
+        RunReport::Phase phase ("extract");
+        auto sourceString = source.toString (false);
+        auto stateFile = archive.getSiblingFile (archive.getFileName() + ".xml");
+        String validator;
+
+        {
+            ScopedPointer<XmlElement> state = XmlDocument (stateFile).getDocumentElement();
+
+            /* Bytes from another mirror may not be the same bytes. */
+            if (state != nullptr && state->getStringAttribute ("url") == source.toString (true))
+                validator = state->getStringAttribute ("validator");
+        }
+
+        if (validator.isEmpty())
+        {
+            archive.deleteFile();
+            stateFile.deleteFile();
+        }
+
+        const int64 have = archive.existsAsFile() ? archive.getSize() : 0;
+
+        /* The engine's thread mustn't block, so the pipe grows rather than
+         * stalling it if extraction falls behind the network. */
+        PipeInputStream pipe;
+        TransferRequest request (source);
+
+        if (have > 0)
+            request.extraHeaders = "Range: bytes=" + String (have) + "-\nIf-Range: " + validator;
+
+        /* Set on the engine's thread before responded is signalled. */
+        WaitableEvent responded;
+        bool resumed = false;
+        ScopedPointer<FileOutputStream> saved;
+
+        request.onResponse = [&] (int statusCode, const StringPairArray& headers) -> int64
+        {
+            if (statusCode == 200 || statusCode == 206)
+            {
+                resumed = have > 0 && statusCode == 206;
+
+                if (! resumed)
+                    archive.deleteFile();
+
+                saved = new FileOutputStream (archive);
+
+                if (saved->failedToOpen())
+                    saved = nullptr;
+
+                XmlElement state ("download");
+                state.setAttribute ("url", source.toString (true));
+                state.setAttribute ("validator", ResumableDownload::getValidator (headers));
+                state.writeToFile (stateFile, String());
+            }
+
+            responded.signal();
+            return -1;
+        };
+
+        request.onData = [&] (const void* data, size_t size)
+        {
+            if (saved != nullptr)
+                saved->write (data, size);
+
+            return pipe.write (data, size, true);
+        };
+
+        request.onComplete = [&] (const TransferResult& r)
+        {
+            saved = nullptr;
+            pipe.finish (r.succeeded());
+            responded.signal();
+        };
+
+        auto transfer = TransferEngine::getInstance().start (request);
+        Progress::getInstance().track (transfer, have);
+        responded.wait();
+
+        /* A resumed download is extracted from the start: what's on disk, then the rest. */
+        ScopedPointer<InputStream> resumedStream;
+
+        if (resumed)
+            resumedStream = new ConcatenatedInputStream (new SubregionStream (new FileInputStream (archive), 0, have, true), pipe);
+
+        Result result (Result::ok());
+
+        {
+            InputStream& compressed = resumedStream != nullptr ? *resumedStream : static_cast<InputStream&> (pipe);
+            ScopedPointer<GzipInputStream> tar (TarExtractor::createGzipDecompressor (compressed));
+
+            if (tar == nullptr)
+            {
+                result = Result::fail ("not a gzip stream: " + sourceString);
+            }
+            else
+            {
+                TarExtractor extractor;
+                result = extractor.extract (*tar, destination, [] (const String& path) { return path; });
+
+                /* The tar layer can parse cleanly from a corrupt stream, so the gzip trailer decides. */
+                if (result.wasOk())
+                    result = tar->finish();
+
+                RunReport::getInstance().addExtracted (extractor.getNumFilesWritten(), extractor.getNumBytesWritten());
+            }
+        }
+
+        pipe.close();
+
+        if (! transfer->isFinished())
+            transfer->cancel();
+
+        auto download = transfer->wait();
+
+        if (! download.succeeded() && ! download.cancelled)
+            result = Result::fail ("could not download " + sourceString + " (" + download.getFailureReason() + ")");
+
+        /* Only a download that broke off is worth continuing, not one that
+         * completed or that extraction gave up on. */
+        if (download.succeeded() || download.cancelled)
+        {
+            archive.deleteFile();
+            stateFile.deleteFile();
+        }
+
+        Mirrors::getInstance().record (sourceString, download);
+        bytesDownloaded += download.bytesReceived;
+
+        span.setArg ("bytes", download.bytesReceived);
+        span.setArg ("status", download.statusCode);
+        return result;
+    }
 };
 
 
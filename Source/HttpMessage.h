@@ -0,0 +1,354 @@
+/*
+  ==============================================================================
+
+    HttpMessage.h
+    Created: 19 Oct 2026 1:41:09pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef HTTPMESSAGE_H_INCLUDED
+#define HTTPMESSAGE_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+
+/** The parts of an http:// or https:// URL we need to open a connection. */
+class HttpUrl
+{
+public:
+    HttpUrl (const String& url)
+    {
+        scheme = url.upToFirstOccurrenceOf ("://", false, false).toLowerCase();
+        auto rest = url.fromFirstOccurrenceOf ("://", false, false);
+        auto authority = rest.upToFirstOccurrenceOf ("/", false, false);
+
+        path = rest.substring (authority.length());
+
+        if (path.isEmpty())
+            path = "/";
+
+        if (authority.containsChar (':'))
+        {
+            host = authority.upToLastOccurrenceOf (":", false, false);
+            port = authority.fromLastOccurrenceOf (":", false, false).getIntValue();
+        }
+        else
+        {
+            host = authority;
+            port = scheme == "https" ? 443 : 80;
+        }
+    }
+
+    bool isValid() const
+    {
+        return (scheme == "http" || scheme == "https") && host.isNotEmpty() && port > 0;
+    }
+
+    /** The host as it should appear in a Host header. */
+    String getHostHeader() const
+    {
+        return (port == 80 || port == 443) ? host : host + ":" + String (port);
+    }
+
+    /** Identifies which connections can be shared. */
+    String getConnectionKey() const
+    {
+        return scheme + "://" + host + ":" + String (port);
+    }
+
+    /** Resolves a Location header against this URL. */
+    String resolve (const String& location) const
+    {
+        if (location.contains ("://"))
+            return location;
+
+        if (location.startsWithChar ('/'))
+            return scheme + "://" + getHostHeader() + location;
+
+        return scheme + "://" + getHostHeader() + path.upToLastOccurrenceOf ("/", true, false) + location;
+    }
+
+    String scheme;
+    String host;
+    int port { 0 };
+    String path;
+};
+
+/**
+ * Builds a request head.  extraHeaders are "Name: value" lines, the same
+ * form URL::createInputStream takes.
+ */
+inline String formatHttpRequest (const String& method, const HttpUrl& url, const String& extraHeaders, bool keepAlive)
+{
+    String request;
+    request << method << " " << url.path << " HTTP/1.1\r\n"
+            << "Host: " << url.getHostHeader() << "\r\n"
+            << "User-Agent: jpm\r\n"
+            << "Accept-Encoding: identity\r\n"
+            << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n";
+
+    StringArray lines;
+    lines.addLines (extraHeaders);
+    lines.removeEmptyStrings();
+
+    for (auto& l : lines)
+        request << l.trim() << "\r\n";
+
+    request << "\r\n";
+    return request;
+}
+
+/**
+ * Incremental HTTP/1.1 response parser.  Bytes are fed in as they arrive;
+ * the body is handed to a callback and the parser stops at the end of the
+ * message so that any following response on the same connection is left
+ * for the next parse.
+ */
+class HttpResponseParser
+{
+public:
+    typedef std::function<void (const char*, int)> BodyCallback;
+
+    void reset (bool expectNoBody = false)
+    {
+        state = statusLineState;
+        line.clear();
+        statusCode = 0;
+        headers.clear();
+        remaining = -1;
+        readUntilClose = false;
+        noBody = expectNoBody;
+        http10 = false;
+    }
+
+    /** Returns the number of bytes consumed, which can be less than size once the message is complete. */
+    int feed (const char* data, int size, const BodyCallback& onBody)
+    {
+        int pos = 0;
+
+        while (pos < size && state != completeState && state != errorState)
+        {
+            switch (state)
+            {
+                case statusLineState:
+                case headerState:
+                case chunkSizeState:
+                case chunkEndState:
+                case trailerState:
+                {
+                    const char c = data[pos++];
+
+                    if (c != '\n')
+                    {
+                        if (c != '\r')
+                            line.append (c);
+
+                        if (line.size() > 65536)
+                            state = errorState;
+
+                        break;
+                    }
+
+                    handleLine (line.toString());
+                    line.clear();
+                    break;
+                }
+
+                case bodyState:
+                {
+                    int n = size - pos;
+
+                    if (! readUntilClose)
+                        n = (int) jmin ((int64) n, remaining);
+
+                    onBody (data + pos, n);
+                    pos += n;
+
+                    if (! readUntilClose)
+                    {
+                        remaining -= n;
+
+                        if (remaining == 0)
+                            state = completeState;
+                    }
+
+                    break;
+                }
+
+                case chunkDataState:
+                {
+                    const int n = (int) jmin ((int64) (size - pos), remaining);
+                    onBody (data + pos, n);
+                    pos += n;
+                    remaining -= n;
+
+                    if (remaining == 0)
+                        state = chunkEndState;
+
+                    break;
+                }
+
+                default:
+                    break;
+            }
+        }
+
+        return pos;
+    }
+
+    /** Call when the peer closes the connection. */
+    void connectionClosed()
+    {
+        if (state == bodyState && readUntilClose)
+            state = completeState;
+        else if (state != completeState)
+            state = errorState;
+    }
+
+    bool isComplete() const             { return state == completeState; }
+    bool hasError() const               { return state == errorState; }
+    bool hasHeaders() const             { return state > headerState; }
+    int getStatusCode() const           { return statusCode; }
+    const StringPairArray& getHeaders() const { return headers; }
+
+    /** The body length if the server told us, otherwise -1. */
+    int64 getContentLength() const
+    {
+        return hasHeader ("Content-Length") ? headers["Content-Length"].getLargeIntValue() : -1;
+    }
+
+    bool hasHeader (const String& name) const
+    {
+        return headers.getAllKeys().contains (name, true);
+    }
+
+    /** True if the connection can carry another request once this one is complete. */
+    bool canReuseConnection() const
+    {
+        auto connection = headers["Connection"].toLowerCase();
+
+        if (readUntilClose || connection.contains ("close"))
+            return false;
+
+        return ! http10 || connection.contains ("keep-alive");
+    }
+
+private:
+    enum State
+    {
+        statusLineState,
+        headerState,
+        bodyState,
+        chunkSizeState,
+        chunkDataState,
+        chunkEndState,
+        trailerState,
+        completeState,
+        errorState
+    };
+
+    /** Collects a line as raw bytes so headers can't be mangled mid-character. */
+    struct LineBuffer
+    {
+        void append (char c)            { data.append (&c, 1); }
+        void clear()                    { data.setSize (0); }
+        size_t size() const             { return data.getSize(); }
+        String toString() const         { return String::fromUTF8 ((const char*) data.getData(), (int) data.getSize()); }
+
+        MemoryBlock data;
+    };
+
+    void handleLine (const String& text)
+    {
+        switch (state)
+        {
+            case statusLineState:
+                if (! text.startsWith ("HTTP/"))
+                {
+                    state = errorState;
+                    return;
+                }
+
+                http10 = text.startsWith ("HTTP/1.0");
+                statusCode = text.fromFirstOccurrenceOf (" ", false, false).getIntValue();
+                state = headerState;
+                break;
+
+            case headerState:
+                if (text.isNotEmpty())
+                {
+                    /* StringPairArray is case insensitive by default, which is what HTTP wants. */
+                    auto name = text.upToFirstOccurrenceOf (":", false, false).trim();
+                    auto value = text.fromFirstOccurrenceOf (":", false, false).trim();
+                    headers.set (name, hasHeader (name) ? headers[name] + "," + value : value);
+                    break;
+                }
+
+                startBody();
+                break;
+
+            case chunkSizeState:
+                remaining = text.upToFirstOccurrenceOf (";", false, false).trim().getHexValue64();
+                state = remaining > 0 ? chunkDataState : trailerState;
+                break;
+
+            case chunkEndState:
+                state = chunkSizeState;
+                break;
+
+            case trailerState:
+                if (text.isEmpty())
+                    state = completeState;
+
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    void startBody()
+    {
+        if (statusCode / 100 == 1)
+        {
+            /* Informational - the real status line follows. */
+            reset (noBody);
+            return;
+        }
+
+        if (noBody || statusCode == 204 || statusCode == 304)
+        {
+            state = completeState;
+            return;
+        }
+
+        if (headers["Transfer-Encoding"].containsIgnoreCase ("chunked"))
+        {
+            state = chunkSizeState;
+            return;
+        }
+
+        remaining = getContentLength();
+
+        if (remaining == 0)
+            state = completeState;
+        else
+        {
+            readUntilClose = remaining < 0;
+            state = bodyState;
+        }
+    }
+
+    State state { statusLineState };
+    LineBuffer line;
+    int statusCode { 0 };
+    StringPairArray headers;
+    int64 remaining { -1 };
+    bool readUntilClose { false };
+    bool noBody { false };
+    bool http10 { false };
+};
+
+#endif  // HTTPMESSAGE_H_INCLUDED
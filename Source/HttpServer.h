@@ -0,0 +1,559 @@
+/*
+  ==============================================================================
+
+    HttpServer.h
+    Created: 20 Oct 2026 11:02:44am
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef HTTPSERVER_H_INCLUDED
+#define HTTPSERVER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include <atomic>
+#include <ctime>
+#include <mutex>
+#include <set>
+#include <thread>
+
+/**
+ * A small HTTP/1.1 server: a thread per connection, keep-alive and pipelined
+ * requests, GET and HEAD only.  Entities served with serveFile() get ETag and
+ * Last-Modified validators and honour conditional and single range requests,
+ * which is what jpm's own client needs to resume and revalidate downloads.
+ *
+ * A response can also be paced or cut short, so the server can stand in
+ * for a slow or unreliable link in benchmarks.
+ */
+class HttpServer
+{
+public:
+    struct Request
+    {
+        String method;
+        String path;
+        String query;
+        String version;
+        StringPairArray headers;
+
+        bool wantsKeepAlive() const
+        {
+            auto connection = headers["Connection"].toLowerCase();
+
+            if (version == "HTTP/1.0")
+                return connection.contains ("keep-alive");
+
+            return ! connection.contains ("close");
+        }
+    };
+
+    struct Response
+    {
+        int statusCode { 200 };
+        StringPairArray headers;
+        MemoryBlock body;
+
+        /** When set the body comes from this file instead. */
+        File file;
+        int64 rangeStart { 0 };
+        int64 rangeLength { -1 };
+
+        /** Paces the body to this rate; 0 sends it as fast as the socket allows. */
+        int64 bytesPerSecond { 0 };
+
+        /** Closes the connection after this many body bytes, or -1 to send it all. */
+        int64 dropAfter { -1 };
+    };
+
+    class Handler
+    {
+    public:
+        virtual ~Handler() {}
+        virtual Response handle (const Request& request) = 0;
+
+        /** Called on a new connection's thread before its first request is read. */
+        virtual void connectionOpened() {}
+    };
+
+    HttpServer (Handler& handler_)
+        :
+        handler (handler_)
+    {}
+
+    ~HttpServer()
+    {
+        stop();
+    }
+
+    /** Every request is printed unless this is turned off. */
+    void setLogRequests (bool shouldLog)
+    {
+        logRequests = shouldLog;
+    }
+
+    bool start (int port)
+    {
+        if (! listener.createListener (port))
+            return false;
+
+        running = true;
+        listenerThread = std::thread ([this] { acceptConnections(); });
+        return true;
+    }
+
+    void stop()
+    {
+        if (! running.exchange (false))
+            return;
+
+        listener.close();
+
+        if (listenerThread.joinable())
+            listenerThread.join();
+
+        {
+            std::lock_guard<std::mutex> lock (connectionsLock);
+
+            for (auto* s : connections)
+                s->close();
+        }
+
+        while (numConnections > 0)
+            Thread::sleep (10);
+    }
+
+    static Response makeError (int statusCode, const String& message)
+    {
+        Response r;
+        r.statusCode = statusCode;
+        r.headers.set ("Content-Type", "text/plain");
+        auto text = message + "\n";
+        r.body.append (text.toRawUTF8(), text.getNumBytesAsUTF8());
+        return r;
+    }
+
+    /** Serves a file, applying the request's conditional and Range headers. */
+    static Response serveFile (const Request& request, const File& file, const String& contentType)
+    {
+        Response r;
+        r.file = file;
+
+        const int64 length = file.getSize();
+        auto modified = file.getLastModificationTime();
+        auto etag = "\"" + String::toHexString (length) + "-" + String::toHexString (modified.toMilliseconds()) + "\"";
+        auto lastModified = formatHttpDate (modified);
+
+        r.headers.set ("Content-Type", contentType);
+        r.headers.set ("ETag", etag);
+        r.headers.set ("Last-Modified", lastModified);
+        r.headers.set ("Accept-Ranges", "bytes");
+
+        if (isNotModified (request, etag, lastModified))
+        {
+            r.statusCode = 304;
+            r.file = File::nonexistent;
+            return r;
+        }
+
+        r.rangeLength = length;
+        auto range = request.headers["Range"];
+        auto ifRange = request.headers["If-Range"];
+
+        /* If-Range means "only if it's still the same file, otherwise send all of it". */
+        if (range.isEmpty() || (ifRange.isNotEmpty() && ifRange != etag && ifRange != lastModified))
+            return r;
+
+        int64 start, end;
+
+        if (! parseRange (range, length, start, end))
+            return r;
+
+        if (start >= length)
+        {
+            r = makeError (416, "range not satisfiable");
+            r.headers.set ("Content-Range", "bytes */" + String (length));
+            return r;
+        }
+
+        r.statusCode = 206;
+        r.rangeStart = start;
+        r.rangeLength = end - start + 1;
+        r.headers.set ("Content-Range", "bytes " + String (start) + "-" + String (end) + "/" + String (length));
+        return r;
+    }
+
+    static String formatHttpDate (Time t)
+    {
+        time_t seconds = (time_t) (t.toMilliseconds() / 1000);
+        struct tm utc;
+
+       #if JUCE_WINDOWS
+        gmtime_s (&utc, &seconds);
+       #else
+        gmtime_r (&seconds, &utc);
+       #endif
+
+        char text[64];
+        strftime (text, sizeof (text), "%a, %d %b %Y %H:%M:%S GMT", &utc);
+        return text;
+    }
+
+private:
+    static bool isNotModified (const Request& request, const String& etag, const String& lastModified)
+    {
+        auto ifNoneMatch = request.headers["If-None-Match"];
+
+        if (ifNoneMatch.isNotEmpty())
+        {
+            if (ifNoneMatch.trim() == "*")
+                return true;
+
+            StringArray tags;
+            tags.addTokens (ifNoneMatch, ",", "\"");
+            tags.trim();
+
+            for (auto& t : tags)
+                if (t.fromFirstOccurrenceOf ("W/", false, false) == etag || t == etag)
+                    return true;
+
+            return false;
+        }
+
+        /* Clients send back the date we gave them, so an exact match is enough
+         * and saves parsing dates. */
+        return request.headers["If-Modified-Since"] == lastModified;
+    }
+
+    /** Handles "bytes=a-b", "bytes=a-" and "bytes=-n".  Multiple ranges aren't supported. */
+    static bool parseRange (const String& header, int64 length, int64& start, int64& end)
+    {
+        if (! header.startsWith ("bytes=") || header.containsChar (','))
+            return false;
+
+        auto spec = header.substring (6).trim();
+        auto first = spec.upToFirstOccurrenceOf ("-", false, false).trim();
+        auto last = spec.fromFirstOccurrenceOf ("-", false, false).trim();
+
+        if (! spec.containsChar ('-') || (first.isEmpty() && last.isEmpty()))
+            return false;
+
+        if (first.isEmpty())
+        {
+            start = jmax ((int64) 0, length - last.getLargeIntValue());
+            end = length - 1;
+            return length > 0;
+        }
+
+        start = first.getLargeIntValue();
+        end = last.isEmpty() ? length - 1 : jmin (length - 1, last.getLargeIntValue());
+        return end >= start || start >= length;
+    }
+
+    void acceptConnections()
+    {
+        while (running)
+        {
+            ScopedPointer<StreamingSocket> socket (listener.waitForNextConnection());
+
+            if (socket == nullptr)
+                continue;
+
+            if (numConnections >= maxConnections)
+                continue;
+
+            auto* s = socket.release();
+
+            {
+                std::lock_guard<std::mutex> lock (connectionsLock);
+                connections.insert (s);
+            }
+
+            ++numConnections;
+
+            std::thread ([this, s]
+            {
+                serveConnection (*s);
+
+                {
+                    std::lock_guard<std::mutex> lock (connectionsLock);
+                    connections.erase (s);
+                }
+
+                delete s;
+                --numConnections;
+            }).detach();
+        }
+    }
+
+    void serveConnection (StreamingSocket& socket)
+    {
+        MemoryBlock pending;
+        handler.connectionOpened();
+
+        while (running)
+        {
+            Request request;
+
+            if (! readRequest (socket, pending, request))
+                return;
+
+            Response response;
+
+            if (request.method != "GET" && request.method != "HEAD")
+                response = makeError (405, "method not allowed");
+            else
+                response = handler.handle (request);
+
+            const bool keepAlive = request.wantsKeepAlive();
+
+            if (! sendResponse (socket, request, response, keepAlive) || ! keepAlive)
+                return;
+        }
+    }
+
+    /**
+     * Reads one request head.  Anything after it is left in pending, as a
+     * client may have pipelined several requests.
+     */
+    bool readRequest (StreamingSocket& socket, MemoryBlock& pending, Request& request)
+    {
+        for (;;)
+        {
+            auto* data = static_cast<const char*> (pending.getData());
+            int headEnd = -1;
+
+            for (size_t i = 3; i < pending.getSize(); ++i)
+            {
+                if (data[i - 3] == '\r' && data[i - 2] == '\n' && data[i - 1] == '\r' && data[i] == '\n')
+                {
+                    headEnd = (int) i + 1;
+                    break;
+                }
+            }
+
+            if (headEnd > 0)
+            {
+                auto head = String::fromUTF8 (data, headEnd);
+                pending.removeSection (0, (size_t) headEnd);
+                return parseRequest (head, request) && discardBody (socket, pending, request);
+            }
+
+            if (pending.getSize() > maxHeadSize || ! readMore (socket, pending))
+                return false;
+        }
+    }
+
+    bool readMore (StreamingSocket& socket, MemoryBlock& pending)
+    {
+        if (socket.waitUntilReady (true, idleTimeoutMs) != 1)
+            return false;
+
+        char buffer[8192];
+        auto n = socket.read (buffer, sizeof (buffer), false);
+
+        if (n <= 0)
+            return false;
+
+        pending.append (buffer, (size_t) n);
+        return true;
+    }
+
+    /** GET requests shouldn't carry a body, but skip one if it's there. */
+    bool discardBody (StreamingSocket& socket, MemoryBlock& pending, const Request& request)
+    {
+        int64 remaining = request.headers["Content-Length"].getLargeIntValue();
+
+        while (remaining > 0)
+        {
+            if (pending.getSize() == 0 && ! readMore (socket, pending))
+                return false;
+
+            auto n = jmin ((int64) pending.getSize(), remaining);
+            pending.removeSection (0, (size_t) n);
+            remaining -= n;
+        }
+
+        return true;
+    }
+
+    static bool parseRequest (const String& head, Request& request)
+    {
+        StringArray lines;
+        lines.addLines (head);
+
+        StringArray requestLine;
+        requestLine.addTokens (lines[0], " ", String());
+
+        if (requestLine.size() != 3)
+            return false;
+
+        request.method = requestLine[0];
+        request.version = requestLine[2];
+        request.path = URL::removeEscapeChars (requestLine[1].upToFirstOccurrenceOf ("?", false, false));
+        request.query = requestLine[1].fromFirstOccurrenceOf ("?", false, false);
+
+        for (int i = 1; i < lines.size(); ++i)
+        {
+            auto name = lines[i].upToFirstOccurrenceOf (":", false, false).trim();
+
+            if (name.isNotEmpty())
+                request.headers.set (name, lines[i].fromFirstOccurrenceOf (":", false, false).trim());
+        }
+
+        return true;
+    }
+
+    bool sendResponse (StreamingSocket& socket, const Request& request, const Response& response, bool keepAlive)
+    {
+        const bool fromFile = response.file != File::nonexistent;
+        const int64 length = fromFile ? response.rangeLength : (int64) response.body.getSize();
+
+        String head;
+        head << "HTTP/1.1 " << response.statusCode << " " << getReasonPhrase (response.statusCode) << "\r\n";
+
+        auto keys = response.headers.getAllKeys();
+
+        for (auto& key : keys)
+            head << key << ": " << response.headers[key] << "\r\n";
+
+        if (response.statusCode != 304)
+            head << "Content-Length: " << length << "\r\n";
+
+        head << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n\r\n";
+
+        if (! writeAll (socket, head.toRawUTF8(), head.getNumBytesAsUTF8()))
+            return false;
+
+        if (logRequests)
+            printInfo (request.method + " " + request.path + " " + String (response.statusCode));
+
+        if (request.method == "HEAD" || response.statusCode == 304)
+            return true;
+
+        const double startMs = Time::getMillisecondCounterHiRes();
+        int64 sent = 0;
+
+        if (! fromFile)
+            return writeBody (socket, response, static_cast<const char*> (response.body.getData()),
+                              response.body.getSize(), sent, startMs);
+
+        FileInputStream in (response.file);
+
+        if (in.failedToOpen() || ! in.setPosition (response.rangeStart))
+            return false;
+
+        HeapBlock<char> buffer (65536);
+        int64 remaining = length;
+
+        while (remaining > 0)
+        {
+            auto n = in.read (buffer, (int) jmin (remaining, (int64) 65536));
+
+            if (n <= 0 || ! writeBody (socket, response, buffer, (size_t) n, sent, startMs))
+                return false;
+
+            remaining -= n;
+        }
+
+        return true;
+    }
+
+    /**
+     * Writes the next part of a body, pacing it and cutting it short as the
+     * response asks.  sent counts the body bytes written so far.
+     */
+    static bool writeBody (StreamingSocket& socket, const Response& response, const char* data, size_t size,
+                           int64& sent, double startMs)
+    {
+        if (response.bytesPerSecond <= 0 && response.dropAfter < 0)
+            return writeAll (socket, data, size);
+
+        /* Small writes when paced, about fifty a second, so the rate is smooth. */
+        const size_t chunk = response.bytesPerSecond > 0
+                             ? (size_t) jlimit ((int64) 1024, (int64) 65536, response.bytesPerSecond / 50)
+                             : (size_t) 65536;
+
+        while (size > 0)
+        {
+            auto n = jmin (size, chunk);
+
+            if (response.dropAfter >= 0 && sent + (int64) n > response.dropAfter)
+            {
+                writeAll (socket, data, (size_t) (response.dropAfter - sent));
+                return false;
+            }
+
+            if (! writeAll (socket, data, n))
+                return false;
+
+            data += n;
+            size -= n;
+            sent += (int64) n;
+
+            if (response.bytesPerSecond > 0)
+            {
+                auto wait = startMs + sent * 1000.0 / response.bytesPerSecond - Time::getMillisecondCounterHiRes();
+
+                if (wait >= 1.0)
+                    Thread::sleep ((int) wait);
+            }
+        }
+
+        return true;
+    }
+
+    static bool writeAll (StreamingSocket& socket, const void* data, size_t size)
+    {
+        auto* p = static_cast<const char*> (data);
+
+        while (size > 0)
+        {
+            auto n = socket.write (p, (int) jmin (size, (size_t) 65536));
+
+            if (n <= 0)
+                return false;
+
+            p += n;
+            size -= (size_t) n;
+        }
+
+        return true;
+    }
+
+    static String getReasonPhrase (int statusCode)
+    {
+        switch (statusCode)
+        {
+            case 200: return "OK";
+            case 206: return "Partial Content";
+            case 304: return "Not Modified";
+            case 400: return "Bad Request";
+            case 404: return "Not Found";
+            case 405: return "Method Not Allowed";
+            case 416: return "Range Not Satisfiable";
+            case 500: return "Internal Server Error";
+            case 502: return "Bad Gateway";
+            case 503: return "Service Unavailable";
+            default:  return "Unknown";
+        }
+    }
+
+    static const int maxConnections = 512;
+    static const int idleTimeoutMs = 30000;
+    static const size_t maxHeadSize = 16384;
+
+    Handler& handler;
+    StreamingSocket listener;
+    std::thread listenerThread;
+    std::atomic<bool> running { false };
+    bool logRequests { true };
+
+    std::mutex connectionsLock;
+    std::set<StreamingSocket*> connections;
+    std::atomic<int> numConnections { 0 };
+};
+
+#endif  // HTTPSERVER_H_INCLUDED
@@ -0,0 +1,177 @@
+/*
+  ==============================================================================
+
+    InstallFilter.h
+    Created: 20 Oct 2026 11:38:15pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef INSTALLFILTER_H_INCLUDED
+#define INSTALLFILTER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include <atomic>
+#include <memory>
+
+/**
+ * Decides which files in a module are worth installing.
+ *
+ * Patterns are semicolon separated wildcards.  One without a slash is
+ * compared with each file and folder name in a path, so "docs" drops every
+ * docs folder and "*.pdf" every PDF.  One with a slash is compared with the
+ * whole path below the module folder, or any folder above it, as in
+ * "native/android".  With includes, only files matching one are kept; a
+ * matching exclude always wins.  juce_module_info is always kept.
+ *
+ * Filters are applied as a module is copied into the store, never while a
+ * tarball is extracted: one extraction in the download cache serves every
+ * module in a repository, whatever their filters, so left out files are
+ * written there once but never reach jpm_modules.
+ *
+ * Copies of a filter share a tally of what was left out, so it can be
+ * passed by value and still report what the copy saved.
+ */
+class InstallFilter
+{
+public:
+    InstallFilter()
+        :
+        savings (std::make_shared<Savings>())
+    {}
+
+    InstallFilter (const String& includes_, const String& excludes_)
+        :
+        includes (split (includes_)),
+        excludes (split (excludes_)),
+        savings (std::make_shared<Savings>())
+    {}
+
+    /** Adds another set of patterns, e.g. module ones on top of the global defaults. */
+    void add (const InstallFilter& other)
+    {
+        includes.addArray (other.includes);
+        excludes.addArray (other.excludes);
+    }
+
+    bool isEmpty() const
+    {
+        return includes.isEmpty() && excludes.isEmpty();
+    }
+
+    /** path is relative to the module folder, with forward slashes. */
+    bool accepts (const String& path, bool isDirectory) const
+    {
+        if (path == "juce_module_info")
+            return true;
+
+        for (auto& pattern : excludes)
+            if (matches (pattern, path))
+                return false;
+
+        if (isDirectory || includes.isEmpty())
+            return true;
+
+        for (auto& pattern : includes)
+            if (matches (pattern, path))
+                return true;
+
+        return false;
+    }
+
+    /** Identifies the filter, for keying anything it was applied to. */
+    String getKey() const
+    {
+        return isEmpty() ? String() : "+" + includes.joinIntoString (";") + "-" + excludes.joinIntoString (";");
+    }
+
+    /** secondsSaved is an estimate of what writing the skipped files would have cost. */
+    void recordSkipped (int numFiles, int64 numBytes, double secondsSaved)
+    {
+        savings->numFiles += numFiles;
+        savings->numBytes += numBytes;
+        savings->microsecondsSaved += (int64) (secondsSaved * 1.0e6);
+    }
+
+    int getNumFilesSkipped() const
+    {
+        return savings->numFiles;
+    }
+
+    int64 getNumBytesSkipped() const
+    {
+        return savings->numBytes;
+    }
+
+    double getSecondsSaved() const
+    {
+        return savings->microsecondsSaved / 1.0e6;
+    }
+
+    String getSavingsString() const
+    {
+        auto s = "install filters left out " + String (getNumFilesSkipped()) + " files, "
+                 + String (getNumBytesSkipped() / (1024.0 * 1024.0), 1) + "MB";
+
+        if (getSecondsSaved() > 0.0)
+            s << ", saving about " << String (getSecondsSaved(), 2) << "s";
+
+        return s;
+    }
+
+private:
+    struct Savings
+    {
+        std::atomic<int> numFiles { 0 };
+        std::atomic<int64> numBytes { 0 };
+        std::atomic<int64> microsecondsSaved { 0 };
+    };
+
+    static StringArray split (const String& patterns)
+    {
+        StringArray result;
+        result.addTokens (patterns, ";", String());
+        result.trim();
+        result.removeEmptyStrings();
+
+        for (auto& p : result)
+            p = trimSlashes (p.replaceCharacter ('\\', '/'));
+
+        return result;
+    }
+
+    static bool matches (const String& pattern, const String& path)
+    {
+        StringArray parts;
+        parts.addTokens (path, "/", String());
+
+        if (! pattern.containsChar ('/'))
+        {
+            for (auto& p : parts)
+                if (p.matchesWildcard (pattern, false))
+                    return true;
+
+            return false;
+        }
+
+        String prefix;
+
+        for (auto& p : parts)
+        {
+            prefix = prefix.isEmpty() ? p : prefix + "/" + p;
+
+            if (prefix.matchesWildcard (pattern, false))
+                return true;
+        }
+
+        return false;
+    }
+
+    StringArray includes;
+    StringArray excludes;
+    std::shared_ptr<Savings> savings;
+};
+
+#endif  // INSTALLFILTER_H_INCLUDED
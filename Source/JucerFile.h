@@ -13,6 +13,8 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include <iostream>
+#include "Trace.h"
+#include "RunReport.h"
 
 class InvalidJucerFormat
 {};
@@ -67,7 +69,12 @@ public:
 
     void save()
     {
-        file.replaceWithText (jucer.toXmlString());
+        TraceSpan span ("save jucer", "project");
+        RunReport::Phase phase ("save");
+        auto text = jucer.toXmlString();
+        span.setArg ("bytes", (int64) text.getNumBytesAsUTF8());
+        file.replaceWithText (text);
+        RunReport::getInstance().addFileWritten();
     }
 
     ValueTree getAllModules()
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    Lockfile.h
+    Created: 20 Oct 2026 8:02:44pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef LOCKFILE_H_INCLUDED
+#define LOCKFILE_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "DependencyResolver.h"
+
+/**
+ * jpmfile.lock - the resolved dependency graph for a jpmfile.xml.
+ *
+ * It holds every module the project needs, including ones only pulled in by
+ * other modules, with the versions they resolved to.  The lock carries a
+ * hash of the modules in jpmfile.xml, and while that still matches the graph
+ * is used as it is, so a plain `jpm install` doesn't need the directory or
+ * any juce_module_info files.
+ */
+class Lockfile
+{
+public:
+    Lockfile (const File& file_)
+        :
+        file (file_)
+    {
+        ScopedPointer<XmlElement> xml = XmlDocument (file).getDocumentElement();
+
+        if (xml != nullptr)
+            lock = ValueTree::fromXml (*xml);
+    }
+
+    /** True if the lock was made from exactly these modules. */
+    bool isCurrentFor (const Array<Module>& roots) const
+    {
+        return lock.hasType ("jpm_lock") && lock["inputs"].toString() == getInputsHash (roots);
+    }
+
+    Array<DependencyResolver::Node> getNodes() const
+    {
+        Array<DependencyResolver::Node> nodes;
+
+        for (auto child : ValueTreeChildrenConnector (lock))
+        {
+            DependencyResolver::Node node;
+            auto state = child.createCopy();
+
+            node.requestedVersion = state["requested"];
+            node.infoVersion = state["info_version"];
+            node.direct = state["direct"];
+
+            for (auto d : ValueTreeChildrenConnector (state))
+            {
+                node.dependencies.add (d["id"]);
+                node.constraints.add (d["version"]);
+            }
+
+            for (auto* p : { "requested", "info_version", "direct", "level" })
+                state.removeProperty (p, nullptr);
+
+            state.removeAllChildren (nullptr);
+            node.module = Module (state);
+            nodes.add (node);
+        }
+
+        return nodes;
+    }
+
+    /** Modules in the lock that are only there because something else needs them. */
+    Array<Module> getDependencyModules() const
+    {
+        Array<Module> modules;
+
+        for (auto& n : getNodes())
+            if (! n.direct)
+                modules.add (n.module);
+
+        return modules;
+    }
+
+    /** Records a freshly resolved graph; roots should be as resolution left them. */
+    void store (const Array<Module>& roots, const OwnedArray<DependencyResolver::Node>& nodes)
+    {
+        lock = ValueTree ("jpm_lock");
+        lock.setProperty ("inputs", getInputsHash (roots), nullptr);
+
+        for (auto* n : nodes)
+        {
+            auto entry = n->module.getStateAsValueTree().createCopy();
+            entry.removeAllChildren (nullptr);
+            entry.setProperty ("requested", n->requestedVersion, nullptr);
+            entry.setProperty ("info_version", n->infoVersion, nullptr);
+            entry.setProperty ("direct", n->direct, nullptr);
+            entry.setProperty ("level", n->level, nullptr);
+
+            for (int d = 0; d < n->dependencies.size(); ++d)
+            {
+                ValueTree dependency ("dependency");
+                dependency.setProperty ("id", n->dependencies[d], nullptr);
+                dependency.setProperty ("version", n->constraints[d], nullptr);
+                entry.addChild (dependency, -1, nullptr);
+            }
+
+            lock.addChild (entry, -1, nullptr);
+        }
+
+        file.replaceWithText (lock.toXmlString());
+    }
+
+private:
+    static String getInputsHash (const Array<Module>& roots)
+    {
+        String inputs;
+
+        for (auto m : roots)
+            inputs << m.getStateAsValueTree().toXmlString();
+
+        return MD5 (inputs.toUTF8()).toHexString();
+    }
+
+    File file;
+    ValueTree lock;
+};
+
+#endif  // LOCKFILE_H_INCLUDED
@@ -20,26 +20,38 @@
 #include "Module.h"
 #include "Directory.h"
 #include "ConfigFile.h"
+#include "Lockfile.h"
+#include "Project.h"
+#include "Workspace.h"
+#include "OutdatedCheck.h"
+#include "ModuleServer.h"
+#include "Daemon.h"
+#include "Trace.h"
+#include "CacheStats.h"
+#include "RunReport.h"
+#include "Progress.h"
+#include "Benchmark.h"
+#include "NetworkBenchmark.h"
+#include "SelfTest.h"
 
 class App
 {
 public:
-    App (StringArray commandLine_)
+    /** sharedDirectory, if given, is used instead of loading the directory again. */
+    App (StringArray commandLine_, Directory* sharedDirectory_ = nullptr)
         :
-        config (File::getCurrentWorkingDirectory().getChildFile ("jpmfile.xml")),
+        project (File::getCurrentWorkingDirectory()),
+        sharedDirectory (sharedDirectory_),
         commandLine (commandLine_)
-    {
-        jucer.setFile (File::getCurrentWorkingDirectory());
-    }
-
-    ~App()
-    {
-        jucer.save();
-    }
+    {}
 
 
     void run()
     {
+        /* Keep stdout for the JSON. */
+        if (commandLine.contains ("--json"))
+            messageStream() = &std::cerr;
+
         printInfo ("juce package manager");
         String command = commandLine[1];
         commandLine.removeRange (0, 2);
@@ -51,21 +63,40 @@ public:
         else if (command == "genmodule")
             genmodule();
         else if (command == "rebuildjucer")
-            rebuildJucerModuleList();
+            project.rebuildJucerModuleList();
         else if (command == "erasecache")
             DownloadCache().clearCache();
+        else if (command == "cache")
+            cache();
+        else if (command == "bench")
+            bench();
         else if (command == "add")
             add();
+        else if (command == "serve")
+            serve();
+        else if (command == "outdated")
+            outdated();
+        else if (command == "prune")
+            prune();
+        else if (command == "verify")
+            verify();
+        else if (command == "selftest")
+            selftest();
         else
             printError ("command not found");
     }
 
+    /** Non-zero when a command found something wrong without throwing, e.g. verify. */
+    int getExitCode() const
+    {
+        return exitCode;
+    }
+
 private:
-    /** Add a modules to the jpmfile.xml and install it. */
+    /** Add a modules to the jpmfile.xml; installMissingModules then installs it. */
     void addModuleFromDirectory (const String& moduleName)
     {
-        Directory directory (directoryUrl);
-        auto modules = directory.getModulesByName (moduleName);
+        auto modules = getDirectory().getModulesByName (moduleName);
 
         if (modules.size() == 0)
         {
@@ -74,20 +105,15 @@ private:
         }
 
         if (modules.size() > 1)
-            printInfo ("installing " + String (modules.size()) + " modules");
+            printInfo ("adding " + String (modules.size()) + " modules");
 
         for (auto module : modules)
         {
-            printHeading ("installing: " + module.getRepo() + "/" + module.getName() + "@" + module.getVersion());
+            printHeading ("adding: " + module.getRepo() + "/" + module.getName() + "@" + module.getVersion());
 
             if (module.isValid())
-            {
-                module.install (File::getCurrentWorkingDirectory().getChildFile ("jpm_modules"));
-                config.addModule (module);
-            }
+                project.getConfig().addModule (module);
         }
-
-        rebuildJucerModuleList();
     }
 
 
@@ -108,52 +134,48 @@ private:
         /* A path provided by the user is made relative to the project, and without the module
          * folder itself being included to avoid confusing the introjucer. */
         m.setPath (folder.getParentDirectory().getRelativePathFrom (File::getCurrentWorkingDirectory()));
-        config.addModule (m);
+        project.getConfig().addModule (m);
 
-        rebuildJucerModuleList();
+        project.rebuildJucerModuleList();
     }
 
-    void addModuleToJucer (Module module)
+    /** Installs any modules, and anything they depend on, that are missing from jpm_modules. */
+    void installMissingModules()
     {
-        if (module.getSource() == "LocalPath")
-            jucer.addModule (module.getName(), module.getPath());
-        else
-            jucer.addModule (module.getName());
+        project.installMissingModules (getLookup());
     }
 
-    /** Update the jucer file with the latest list of modules. */
-    void rebuildJucerModuleList()
+    DependencyResolver::Lookup getLookup()
     {
-        jucer.clearModules();
-
-        auto allModules = config.getModules();
-
-        for (auto m : allModules)
-            addModuleToJucer (m);
+        return [this] (const String& name) { return getDirectory().getModulesByName (name); };
     }
 
-    /** Installs any modules that are missing from the jpm_modules folder. */
-    void installMissingModules()
+    /** The directory is only loaded if something needs it. */
+    Directory& getDirectory()
     {
-        auto allModules = config.getModules();
+        if (sharedDirectory != nullptr)
+            return *sharedDirectory;
 
-        for (auto module : allModules)
-        {
-            auto jpmModulesFolder = File::getCurrentWorkingDirectory().getChildFile ("jpm_modules");
-            auto name = module.getName();
+        if (directory == nullptr)
+            directory = new Directory (Settings::getInstance().getDirectoryUrls());
 
-            if (!jpmModulesFolder.getChildFile (name).exists())
-            {
-                std::cout << "installing: " << name << std::endl;
-                module.install (jpmModulesFolder);
-            }
-        }
+        return *directory;
     }
 
 
     void install()
     {
-        if (commandLine.size() == 0)
+        /* A daemon's engine outlives each command, so only this one's share is shown. */
+        auto& engine = TransferEngine::getInstance();
+        const int requestsBefore = engine.getNumRequests();
+        const int connectionsBefore = engine.getNumConnectionsOpened();
+        const int unpooledBefore = engine.getNumUnpooledRequests();
+
+        if (commandLine.contains ("--workspace"))
+        {
+            Workspace (File::getCurrentWorkingDirectory()).install (getLookup());
+        }
+        else if (commandLine.size() == 0)
         {
             printInfo ("installing missing modules");
             printInfo ("to force a refresh delete the jpm_modules folder first)");
@@ -166,7 +188,19 @@ private:
                 addModuleFromDirectory (commandLine[0]);
                 commandLine.remove (0);
             }
+
+            installMissingModules();
         }
+
+        const int requests = engine.getNumRequests() - requestsBefore;
+        const int unpooled = engine.getNumUnpooledRequests() - unpooledBefore;
+
+        if (requests > 0)
+            printInfo (String (requests) + " requests over "
+                       + String (engine.getNumConnectionsOpened() - connectionsBefore) + " connections");
+
+        if (unpooled > 0)
+            printInfo (String (unpooled) + " requests through the system's HTTP stack, one connection each");
     }
 
     void genmodule()
@@ -177,7 +211,6 @@ private:
 
     void list()
     {
-        Directory directory (directoryUrl);
         String searchString;
 
         if (commandLine.size() == 0)
@@ -185,7 +218,7 @@ private:
         else
             searchString = commandLine[0];
 
-        auto result = directory.getModulesByName (searchString);
+        auto result = getDirectory().getModulesByName (searchString);
 
         for (auto r : result)
             std::cout << r.getSummaryString() << std::endl;
@@ -199,12 +232,261 @@ private:
             addLocalModule (commandLine[0]);
     }
 
-    ConfigFile config;
-    JucerFile jucer;
+    /** Shows which modules have newer versions upstream. */
+    void outdated()
+    {
+        OutdatedCheck check (project.getConfig().getModules(), Lockfile (project.getLockFile()).getNodes());
+        check.run();
+
+        if (commandLine.contains ("--json"))
+        {
+            std::cout << check.toJson() << std::endl;
+            return;
+        }
+
+        check.printTable();
+        printInfo (String (check.getNumOutdated()) + " module(s) outdated");
+    }
+
+    /** jpm cache stats [--json] [--reset] */
+    void cache()
+    {
+        if (commandLine[0] != "stats")
+        {
+            printError ("usage: jpm cache stats [--json] [--reset]");
+            return;
+        }
+
+        auto& stats = CacheStats::getInstance();
+
+        if (commandLine.contains ("--reset"))
+        {
+            stats.reset();
+            printInfo ("cache statistics reset");
+            return;
+        }
+
+        if (commandLine.contains ("--json"))
+            std::cout << stats.toJson() << std::endl;
+        else
+            stats.printTable();
+    }
+
+    /** jpm bench [<wildcard>] [--quick] [--iterations=<n>] [--work=<folder>] [--out=<file.json>] */
+    void bench()
+    {
+        if (commandLine[0] == "install")
+        {
+            benchInstall();
+            return;
+        }
+
+        Benchmark::Options options;
+        options.workFolder = File::getSpecialLocation (File::tempDirectory).getChildFile ("jpm-bench");
+        auto output = File::getCurrentWorkingDirectory().getChildFile ("jpm-bench.json");
+
+        for (auto& arg : commandLine)
+        {
+            if (arg == "--quick")
+                options.quick = true;
+            else if (arg.startsWith ("--iterations="))
+                options.iterations = jmax (1, arg.fromFirstOccurrenceOf ("=", false, false).getIntValue());
+            else if (arg.startsWith ("--work="))
+                options.workFolder = File::getCurrentWorkingDirectory().getChildFile (arg.fromFirstOccurrenceOf ("=", false, false));
+            else if (arg.startsWith ("--out="))
+                output = File::getCurrentWorkingDirectory().getChildFile (arg.fromFirstOccurrenceOf ("=", false, false));
+            else if (! arg.startsWith ("--"))
+                options.filter = arg;
+        }
+
+        /* Keep the fixtures out of the real cache. */
+        Settings::getInstance().setCacheFolder (options.workFolder.getChildFile ("cache"));
+
+        Benchmark benchmark (options);
+        benchmark.run();
+        benchmark.printTable();
+
+        if (output.replaceWithText (benchmark.toJson()))
+            printInfo ("results written to " + output.getFullPathName());
+        else
+            printError ("could not write " + output.getFullPathName());
+    }
+
+    /**
+     * jpm bench install [--modules=1,10,50,100,200] [--runs=<n>] [--latency=<ms>] [--handshake=<ms>]
+     *                   [--bandwidth=<KB/s>] [--drop=<rate>] [--errors=<rate>] [--seed=<n>] [--work=<folder>]
+     *                   [--out=<file.json>]
+     *
+     * The handshake is paid once per connection and defaults to the latency,
+     * as a TCP handshake takes one round trip.
+     */
+    void benchInstall()
+    {
+        NetworkBenchmark::Options options;
+        options.workFolder = File::getSpecialLocation (File::tempDirectory).getChildFile ("jpm-bench-install");
+        options.jpmExecutable = File::getSpecialLocation (File::currentExecutableFile);
+        auto output = File::getCurrentWorkingDirectory().getChildFile ("jpm-bench-install.json");
+        auto counts = String ("1,10,50,100,200");
+        auto& conditions = options.conditions;
+        int handshakeMs = -1;
+
+        for (auto& arg : commandLine)
+        {
+            auto value = arg.fromFirstOccurrenceOf ("=", false, false);
+
+            if (arg.startsWith ("--modules="))
+                counts = value;
+            else if (arg.startsWith ("--runs="))
+                options.runs = jmax (1, value.getIntValue());
+            else if (arg.startsWith ("--latency="))
+                conditions.latencyMs = jmax (0, value.getIntValue());
+            else if (arg.startsWith ("--handshake="))
+                handshakeMs = jmax (0, value.getIntValue());
+            else if (arg.startsWith ("--bandwidth="))
+                conditions.bytesPerSecond = jmax ((int64) 0, value.getLargeIntValue() * 1024);
+            else if (arg.startsWith ("--drop="))
+                conditions.dropRate = jlimit (0.0, 1.0, value.getDoubleValue());
+            else if (arg.startsWith ("--errors="))
+                conditions.errorRate = jlimit (0.0, 1.0, value.getDoubleValue());
+            else if (arg.startsWith ("--seed="))
+                conditions.seed = value.getLargeIntValue();
+            else if (arg.startsWith ("--work="))
+                options.workFolder = File::getCurrentWorkingDirectory().getChildFile (value);
+            else if (arg.startsWith ("--out="))
+                output = File::getCurrentWorkingDirectory().getChildFile (value);
+        }
+
+        for (auto& n : StringArray::fromTokens (counts, ",", String()))
+            if (n.getIntValue() > 0)
+                options.moduleCounts.add (n.getIntValue());
+
+        conditions.handshakeMs = handshakeMs >= 0 ? handshakeMs : conditions.latencyMs;
+
+        NetworkBenchmark benchmark (options);
+
+        if (! benchmark.run())
+            return;
+
+        benchmark.printTable();
+
+        if (output.replaceWithText (benchmark.toJson()))
+            printInfo ("results written to " + output.getFullPathName());
+        else
+            printError ("could not write " + output.getFullPathName());
+    }
+
+    /** Deletes stored module versions the project no longer refers to.  jpm prune [--unversioned] */
+    void prune()
+    {
+        StringArray keep;
+
+        for (auto m : project.getConfig().getModules())
+            keep.add (m.getName() + "@" + ModuleStore::getStoredVersion (m));
+
+        for (auto& n : Lockfile (project.getLockFile()).getNodes())
+            keep.add (n.module.getName() + "@" + ModuleStore::getStoredVersion (n.module));
+
+        ModuleStore store (project.getModulesFolder());
+        auto freed = store.prune (keep, commandLine.contains ("--unversioned"));
+
+        printInfo ("freed " + String (freed / (1024.0 * 1024.0), 1) + "MB");
+    }
+
+    /** Checks the installed modules haven't changed since they were fetched. */
+    void verify()
+    {
+        auto modulesFolder = project.getModulesFolder();
+        ModuleStore store (modulesFolder);
+        StringArray names;
+
+        for (auto m : project.getConfig().getModules())
+            if (m.getSource() != "LocalPath")
+                names.addIfNotAlreadyThere (m.getName());
+
+        for (auto& n : Lockfile (project.getLockFile()).getNodes())
+            if (n.module.getSource() != "LocalPath")
+                names.addIfNotAlreadyThere (n.module.getName());
+
+        Array<ModuleVerifier::Target> targets;
+
+        for (auto& name : names)
+        {
+            ModuleVerifier::Target t;
+            t.name = name;
+            t.folder = modulesFolder.getChildFile (name);
+            t.manifest = ModuleStore::getManifest (store.getActiveEntry (name));
+            targets.add (t);
+        }
+
+        ModuleVerifier verifier (modulesFolder.getChildFile (".store").getChildFile ("verify.statcache"),
+                                 ! commandLine.contains ("--full"));
+
+        auto problems = verifier.verify (targets);
+        auto& stats = verifier.getStats();
+
+        for (auto& p : problems)
+            printError (p);
+
+        printInfo ("checked " + String (stats.numFiles) + " files in " + String (stats.numModules) + " modules in "
+                   + String (stats.seconds, 3) + "s, hashed " + String (stats.numHashed) + " ("
+                   + String (stats.numBytesHashed / (1024.0 * 1024.0), 1) + "MB"
+                   + (Sha256::isAccelerated() ? ", SHA extensions" : "") + ")");
+
+        printInfo (problems.isEmpty() ? String ("all modules match their manifests")
+                                      : String (problems.size()) + " problem(s) found");
+
+        if (! problems.isEmpty())
+            exitCode = 1;
+    }
+
+    /** Runs the behaviour tests against local servers.  jpm selftest */
+    void selftest()
+    {
+        /* Keep test downloads out of the real cache. */
+        Settings::getInstance().setCacheFolder (File::getSpecialLocation (File::tempDirectory)
+                                                    .getChildFile ("jpm-selftest").getChildFile ("cache"));
+
+        const int numFailures = SelfTest::runAll();
+
+        if (numFailures > 0)
+        {
+            printError (String (numFailures) + " test failure(s)");
+            exitCode = 1;
+            return;
+        }
+
+        printInfo ("all tests passed");
+    }
+
+    /** Serves the download cache to other machines until killed. */
+    void serve()
+    {
+        const int port = commandLine.size() > 0 ? commandLine[0].getIntValue() : 8080;
+
+        ModuleServer moduleServer;
+        HttpServer server (moduleServer);
+
+        if (! server.start (port))
+        {
+            printError ("could not listen on port " + String (port));
+            return;
+        }
+
+        auto baseUrl = "http://" + SystemStats::getComputerName() + ":" + String (port) + "/";
+        printInfo ("serving the module cache at " + baseUrl);
+        printInfo ("clients should use this in their jpm.settings.xml (" + Settings::getFile().getFullPathName() + "):");
+        std::cout << moduleServer.getClientSettings (baseUrl) << std::endl;
+
+        for (;;)
+            Thread::sleep (1000);
+    }
 
-    URL directoryUrl { URL ("https://raw.githubusercontent.com/jcredland/jpm/master/jpm_directory.xml") };
+    Project project;
+    ScopedPointer<Directory> directory;
+    Directory* sharedDirectory;
 
     StringArray commandLine;
+    int exitCode { 0 };
 };
 
 
@@ -214,41 +496,70 @@ void usage()
     std::cout << "jpm - a juce package manager  (version 0.01)" << std::endl;
     std::cout << std::endl;
     std::cout << "ESSENTIAL COMMANDS" << std::endl;
-    std::cout << "jpm install <source>      add and install a modules" << std::endl;
+    std::cout << "jpm install <source>      add a module, then install it and any other missing modules" << std::endl;
     std::cout << "jpm install               download any missing modules for the current project" << std::endl;
+    std::cout << "jpm install --workspace   install every project below the current folder in one go" << std::endl;
     std::cout << "jpm add <source>          add a local module without using the directory" << std::endl;
     std::cout << "jpm list [<wildcard>]     show all available modules, e.g. jpm list *core*" << std::endl;
     std::cout << "jpm erasecache            erase the download cache" << std::endl;
+    std::cout << "jpm cache stats [--json]  show how often the download cache is hit; --reset clears the counts" << std::endl;
+    std::cout << "jpm prune [--unversioned] delete installed module versions the project no longer uses; folders" << std::endl;
+    std::cout << "                          from before the store, which may have local edits, need --unversioned" << std::endl;
+    std::cout << "jpm verify [--full]       check installed modules against the hashes recorded at install" << std::endl;
     std::cout << std::endl;
     std::cout << "OTHER COMMANDS" << std::endl;
     std::cout << "jpm genmodule <name>      create a module template [ beta ]" << std::endl;
     std::cout << "jpm rebuildjucer          rewrite the modules section of the jucer file" << std::endl;
+    std::cout << "jpm serve [<port>]        serve the download cache as a mirror for other machines" << std::endl;
+    std::cout << "jpm outdated [--json]     show modules with newer versions upstream" << std::endl;
+    std::cout << "jpm daemon [--stop]       keep jpm resident so later commands start warm" << std::endl;
+    std::cout << "jpm bench [--quick]       time jpm's subsystems on generated fixtures, results in jpm-bench.json" << std::endl;
+    std::cout << "jpm bench install         time installs of 1 to 200 modules over a simulated network; see --latency," << std::endl;
+    std::cout << "                          --handshake=<ms>, --bandwidth=<KB/s>, --drop=<rate>, --errors=<rate>," << std::endl;
+    std::cout << "                          --modules=1,10 and --runs; plain http only, https isn't simulated" << std::endl;
+    std::cout << "jpm selftest              run the behaviour tests, offline, and exit non-zero on a failure" << std::endl;
+    std::cout << std::endl;
+    std::cout << "OPTIONS" << std::endl;
+    std::cout << "--trace=<file>            write a timeline of the run that chrome://tracing or Perfetto can open" << std::endl;
+    std::cout << "--report=<file.json>      write times, bytes, peak memory and requests per host as JSON" << std::endl;
     std::cout << std::endl;
     std::cout << "Run this from the root of your JUCE project" << std::endl;
 }
 
 
-int main (int argc, char* argv[])
+/** Removes --name=value from the arguments and returns the value, or an empty string if it isn't there. */
+String takeOption (StringArray& commandLineArguments, const String& name)
 {
-    StringArray commandLineArguments;
-
-    for (int i = 0; i < argc; ++i)
-        commandLineArguments.add (argv[i]);
+    auto prefix = "--" + name + "=";
 
-    if (commandLineArguments.size() <= 1)
+    for (int i = 0; i < commandLineArguments.size(); ++i)
     {
-        usage();
-        return 1;
+        if (commandLineArguments[i].startsWith (prefix))
+        {
+            auto value = commandLineArguments[i].substring (prefix.length());
+            commandLineArguments.remove (i);
+            return value;
+        }
     }
 
+    return String();
+}
+
+
+int runApp (const StringArray& commandLineArguments, Directory* sharedDirectory)
+{
     /*
     This mega-try/catch probably isn't the best idea. Though it's a commandline failure and
     some hard-failure modes are probably not inappropriate.
     */
     try
     {
-        App app (commandLineArguments);
+        TraceSpan span ("jpm", "command");
+        span.setArg ("command", commandLineArguments[1]);
+
+        App app (commandLineArguments, sharedDirectory);
         app.run();
+        return app.getExitCode();
     }
     catch (InvalidJucerFormat)
     {
@@ -261,6 +572,116 @@ int main (int argc, char* argv[])
         std::cerr << "exception: " << e.debugInfo << std::endl;
         return 1;
     }
+}
+
+
+/** Runs one command line, returning the exit code.  The daemon runs each request through this too. */
+int runCommand (StringArray commandLineArguments, Directory* sharedDirectory)
+{
+    auto traceFile = takeOption (commandLineArguments, "trace");
+    auto reportFile = takeOption (commandLineArguments, "report");
+
+    if (traceFile.isNotEmpty())
+        Trace::getInstance().start (File::getCurrentWorkingDirectory().getChildFile (traceFile));
+
+    if (reportFile.isNotEmpty())
+        RunReport::getInstance().start();
+
+    const int exitCode = runApp (commandLineArguments, sharedDirectory);
+
+    if (traceFile.isNotEmpty() && ! Trace::getInstance().finish())
+        printError ("could not write the trace to " + traceFile);
+
+    if (reportFile.isNotEmpty()
+        && ! RunReport::getInstance().finish (File::getCurrentWorkingDirectory().getChildFile (reportFile),
+                                              commandLineArguments, exitCode))
+        printError ("could not write the report to " + reportFile);
+
+    return exitCode;
+}
+
+
+/**
+ * Runs the daemon.  It keeps one directory for every request, loading it
+ * again when it's old enough that the published one may have moved on.
+ */
+int runDaemon (const StringArray& commandLineArguments)
+{
+    if (commandLineArguments.contains ("--stop"))
+    {
+        if (! Daemon::stop())
+        {
+            printError ("no daemon is running");
+            return 1;
+        }
+
+        printInfo ("daemon stopped");
+        return 0;
+    }
+
+    /* Output goes back to the client, which may not be a terminal, so stick to summaries. */
+    Progress::getInstance().setInteractive (false);
+
+    ScopedPointer<Directory> directory;
+    uint32 directoryLoadTime = 0;
+
+    Daemon daemon ([&] (const StringArray& requestArguments)
+    {
+        const uint32 directoryLifetimeMs = 10 * 60 * 1000;
+
+        if (directory == nullptr || Time::getMillisecondCounter() - directoryLoadTime > directoryLifetimeMs)
+        {
+            try
+            {
+                directory = new Directory (Settings::getInstance().getDirectoryUrls());
+                directoryLoadTime = Time::getMillisecondCounter();
+            }
+            catch (JpmFatalExcepton)
+            {
+                /* Let the command load it and report the problem itself. */
+                directory = nullptr;
+            }
+        }
+
+        const int exitCode = runCommand (requestArguments, directory);
+
+        /* The daemon doesn't exit between commands, so it can't leave this until then. */
+        CacheStats::getInstance().save();
+        return exitCode;
+    });
+
+    return daemon.run() ? 0 : 1;
+}
+
+
+int main (int argc, char* argv[])
+{
+    StringArray commandLineArguments;
+
+    for (int i = 0; i < argc; ++i)
+        commandLineArguments.add (argv[i]);
+
+    if (commandLineArguments.size() <= 1)
+    {
+        usage();
+        return 1;
+    }
+
+    const String command = commandLineArguments[1];
+
+    if (command == "daemon")
+        return runDaemon (commandLineArguments);
+
+    int exitCode = 0;
+
+    /* Serving runs forever and benchmarks and tests need a cache of their own, so they stay in their own process. */
+    if (command != "serve" && command != "bench" && command != "selftest" && Daemon::runInDaemon (commandLineArguments, exitCode))
+        return exitCode;
+
+    exitCode = runCommand (commandLineArguments, nullptr);
+
+    /* Let a background directory fetch that's nearly done land in the cache for next time. */
+    BackgroundRefresh::getInstance().stop (2000);
 
-    return 0;
+    return exitCode;
 }
@@ -0,0 +1,402 @@
+/*
+  ==============================================================================
+
+    Mirrors.h
+    Created: 20 Oct 2026 9:48:37am
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef MIRRORS_H_INCLUDED
+#define MIRRORS_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "Settings.h"
+#include "TransferEngine.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+/**
+ * Chooses between the upstream URL and any mirrors configured for it.
+ *
+ * Every transfer made through here updates running averages of latency and
+ * throughput for the host that served it.  These are saved with the download
+ * cache when the process exits and decide the order the candidates are tried
+ * in next time.
+ *
+ * Small documents are fetched with hedging: if the best candidate hasn't
+ * answered within the hedge delay the next one is asked as well, and
+ * whichever succeeds first wins.  Archives are too big to fetch twice, so
+ * for those only a one byte probe is hedged and the download then goes to
+ * the winner.
+ */
+class Mirrors
+{
+public:
+    typedef std::function<bool (const TransferResult&)> SuccessTest;
+
+    Mirrors (const File& statsFile_)
+        :
+        Mirrors (statsFile_, Settings::getInstance().getMirrors(), Settings::getInstance().getHedgeDelayMs())
+    {}
+
+    /** Uses the given rules instead of the user's settings, e.g. for the self tests. */
+    Mirrors (const File& statsFile_, const Array<Settings::Mirror>& rules_, int hedgeDelayMs_)
+        :
+        statsFile (statsFile_),
+        rules (rules_),
+        hedgeDelayMs (hedgeDelayMs_)
+    {
+        loadStats();
+    }
+
+    ~Mirrors()
+    {
+        if (statsChanged)
+            saveStats();
+    }
+
+    static Mirrors& getInstance()
+    {
+        static Mirrors instance (Settings::getInstance().getCacheFolder().getChildFile ("mirrors.xml"));
+        return instance;
+    }
+
+    /** The URLs that can serve canonicalUrl, best first. */
+    StringArray getCandidates (const String& canonicalUrl)
+    {
+        StringArray candidates;
+
+        /* Longest prefix first, so a repository specific mirror beats a
+         * general one, and upstream comes last unless it measures better. */
+        Array<Settings::Mirror> matching;
+
+        for (auto& m : rules)
+            if (canonicalUrl.startsWith (m.prefix))
+                matching.add (m);
+
+        std::stable_sort (matching.begin(), matching.end(), [] (const Settings::Mirror & a, const Settings::Mirror & b)
+        {
+            return a.prefix.length() > b.prefix.length();
+        });
+
+        bool exclusive = false;
+
+        for (auto& m : matching)
+        {
+            candidates.addIfNotAlreadyThere (m.url + canonicalUrl.substring (m.prefix.length()));
+            exclusive = exclusive || m.exclusive;
+        }
+
+        if (! exclusive)
+            candidates.addIfNotAlreadyThere (canonicalUrl);
+
+        if (candidates.size() > 1)
+        {
+            std::lock_guard<std::mutex> lock (statsLock);
+            Array<double> scores;
+
+            for (int i = 0; i < candidates.size(); ++i)
+                scores.add (getScore (candidates[i], i, candidates[i] == canonicalUrl));
+
+            Array<int> order;
+
+            for (int i = 0; i < candidates.size(); ++i)
+                order.add (i);
+
+            std::stable_sort (order.begin(), order.end(), [&scores] (int a, int b) { return scores[a] < scores[b]; });
+
+            StringArray sorted;
+
+            for (auto i : order)
+                sorted.add (candidates[i]);
+
+            candidates = sorted;
+        }
+
+        return candidates;
+    }
+
+    /**
+     * Fetches a small document from the best candidate, hedging to the others.
+     * Returns the first successful result, or the last failure.  isSuccess
+     * can widen what counts, e.g. to accept 304 Not Modified.
+     */
+    TransferResult fetch (const String& canonicalUrl, const String& extraHeaders = String(), String* source = nullptr,
+                          SuccessTest isSuccess = nullptr)
+    {
+        if (isSuccess == nullptr)
+            isSuccess = [] (const TransferResult& r) { return r.succeeded(); };
+
+        auto candidates = getCandidates (canonicalUrl);
+
+        return fetchHedged (candidates, [&extraHeaders] (const String& url)
+        {
+            TransferRequest request ((URL (url)));
+            request.extraHeaders = extraHeaders;
+            request.allowPipelining = true;
+            return request;
+        },
+        isSuccess,
+        source);
+    }
+
+    /** Like fetch() but returns the body as text, or an empty string on failure. */
+    String fetchText (const String& canonicalUrl, const String& extraHeaders = String())
+    {
+        auto result = fetch (canonicalUrl, extraHeaders);
+        return result.succeeded() ? result.getBodyAsString() : String();
+    }
+
+    /**
+     * Orders the candidates for a large download.  With more than one, the
+     * first byte is requested from each in hedged fashion and whoever answers
+     * first goes to the front.
+     */
+    StringArray rankArchiveSources (const String& canonicalUrl)
+    {
+        auto candidates = getCandidates (canonicalUrl);
+
+        if (candidates.size() <= 1)
+            return candidates;
+
+        String winner;
+
+        fetchHedged (candidates, [] (const String& url)
+        {
+            TransferRequest request ((URL (url)));
+            request.extraHeaders = "Range: bytes=0-0";
+
+            /* A server that ignores the range sends everything, so stop it early. */
+            request.onData = [] (const void*, size_t size) { return size <= 1; };
+            return request;
+        },
+        [] (const TransferResult& r) { return r.statusCode / 100 == 2; },
+        &winner);
+
+        if (winner.isNotEmpty())
+        {
+            candidates.removeString (winner);
+            candidates.insert (0, winner);
+        }
+
+        return candidates;
+    }
+
+    /** Records how a transfer from url went. */
+    void record (const String& url, const TransferResult& result)
+    {
+        if (result.cancelled)
+            return;
+
+        std::lock_guard<std::mutex> lock (statsLock);
+        auto& s = stats[HttpUrl (url).getConnectionKey()];
+
+        /* Not Modified is a cheap, successful answer to a conditional request. */
+        if (! result.succeeded() && result.statusCode != 304)
+        {
+            ++s.failures;
+        }
+        else
+        {
+            s.failures = 0;
+            const double ms = result.seconds * 1000.0;
+
+            /* Small replies tell us about latency, big ones about throughput. */
+            if (result.bytesReceived < 64 * 1024)
+                s.latencyMs = s.latencyMs < 0 ? ms : s.latencyMs * 0.7 + ms * 0.3;
+            else if (result.seconds > 0.0)
+            {
+                const double rate = result.bytesReceived / result.seconds;
+                s.bytesPerSecond = s.bytesPerSecond < 0 ? rate : s.bytesPerSecond * 0.7 + rate * 0.3;
+            }
+        }
+
+        statsChanged = true;
+    }
+
+private:
+    struct Stats
+    {
+        double latencyMs { -1.0 };
+        double bytesPerSecond { -1.0 };
+        int failures { 0 };
+    };
+
+    /**
+     * Lower is better.  A mirror we've never measured is tried in the
+     * configured order ahead of anything we have, so new mirrors get a go.
+     * Upstream is the opposite: until it's measured it goes after every
+     * mirror that's working, though still ahead of one that has just failed.
+     * A host that has never answered still counts its failures.
+     */
+    double getScore (const String& url, int configuredPosition, bool isUpstream)
+    {
+        auto it = stats.find (HttpUrl (url).getConnectionKey());
+
+        if (it == stats.end())
+            return isUpstream ? 10000.0 : configuredPosition;
+
+        auto& s = it->second;
+        double score = isUpstream ? 10000.0 : configuredPosition;
+
+        if (s.latencyMs >= 0)
+        {
+            score = 1000.0 + s.latencyMs;
+
+            /* Roughly the time to fetch a typical 4MB archive. */
+            if (s.bytesPerSecond > 0)
+                score += 4.0 * 1024 * 1024 / s.bytesPerSecond * 1000.0;
+        }
+
+        return score + s.failures * 100000.0;
+    }
+
+    int getHedgeDelay (const String& url)
+    {
+        std::lock_guard<std::mutex> lock (statsLock);
+        auto it = stats.find (HttpUrl (url).getConnectionKey());
+
+        /* Give a known host a little longer than it usually takes, but never
+         * longer than configured. */
+        if (it != stats.end() && it->second.latencyMs > 0)
+            return jlimit (50, hedgeDelayMs, (int) (it->second.latencyMs * 3.0));
+
+        return hedgeDelayMs;
+    }
+
+    TransferResult fetchHedged (const StringArray& candidates,
+                                std::function<TransferRequest (const String&)> makeRequest,
+                                SuccessTest isSuccess,
+                                String* winningUrl)
+    {
+        struct Attempt
+        {
+            String url;
+            std::shared_ptr<Transfer> transfer;
+            bool done;
+        };
+
+        auto wakeup = std::make_shared<WaitableEvent>();
+        Array<Attempt> attempts;
+        TransferResult lastFailure;
+        lastFailure.error = "no candidates";
+
+        auto startNext = [&]() -> double
+        {
+            auto url = candidates[attempts.size()];
+            auto request = makeRequest (url);
+            request.onComplete = [wakeup] (const TransferResult&) { wakeup->signal(); };
+
+            Attempt a = { url, TransferEngine::getInstance().start (request), false };
+            attempts.add (a);
+            return Time::getMillisecondCounterHiRes() + getHedgeDelay (url);
+        };
+
+        double nextHedge = startNext();
+
+        for (;;)
+        {
+            int numRunning = 0;
+
+            for (auto& a : attempts)
+            {
+                if (a.done)
+                    continue;
+
+                if (! a.transfer->isFinished())
+                {
+                    ++numRunning;
+                    continue;
+                }
+
+                a.done = true;
+                auto result = a.transfer->wait();
+
+                if (isSuccess (result))
+                {
+                    for (auto& other : attempts)
+                        if (! other.done)
+                            other.transfer->cancel();
+
+                    record (a.url, result);
+
+                    if (winningUrl != nullptr)
+                        *winningUrl = a.url;
+
+                    return result;
+                }
+
+                record (a.url, result);
+                lastFailure = result;
+
+                /* A failure doesn't need to wait for the hedge delay. */
+                nextHedge = 0.0;
+            }
+
+            const bool moreToTry = attempts.size() < candidates.size();
+
+            if (numRunning == 0 && ! moreToTry)
+                return lastFailure;
+
+            if (moreToTry && Time::getMillisecondCounterHiRes() >= nextHedge)
+            {
+                if (attempts.size() > 0 && numRunning > 0)
+                    printWarning ("slow response, also trying " + candidates[attempts.size()]);
+
+                nextHedge = startNext();
+                continue;
+            }
+
+            const int wait = moreToTry ? jmax (1, (int) (nextHedge - Time::getMillisecondCounterHiRes())) : 1000;
+            wakeup->wait (wait);
+        }
+    }
+
+    void loadStats()
+    {
+        ScopedPointer<XmlElement> xml = XmlDocument (statsFile).getDocumentElement();
+
+        if (xml == nullptr)
+            return;
+
+        forEachXmlChildElementWithTagName (*xml, e, "host")
+        {
+            Stats s;
+            s.latencyMs = e->getDoubleAttribute ("latencyMs", -1.0);
+            s.bytesPerSecond = e->getDoubleAttribute ("bytesPerSecond", -1.0);
+            s.failures = e->getIntAttribute ("failures");
+            stats[e->getStringAttribute ("key")] = s;
+        }
+    }
+
+    void saveStats()
+    {
+        XmlElement xml ("mirror_stats");
+
+        for (auto& i : stats)
+        {
+            auto* e = xml.createNewChildElement ("host");
+            e->setAttribute ("key", i.first);
+            e->setAttribute ("latencyMs", i.second.latencyMs);
+            e->setAttribute ("bytesPerSecond", i.second.bytesPerSecond);
+            e->setAttribute ("failures", i.second.failures);
+        }
+
+        statsFile.getParentDirectory().createDirectory();
+        xml.writeToFile (statsFile, String());
+    }
+
+    File statsFile;
+    Array<Settings::Mirror> rules;
+    int hedgeDelayMs;
+
+    std::mutex statsLock;
+    std::map<String, Stats> stats;
+    bool statsChanged { false };
+};
+
+#endif  // MIRRORS_H_INCLUDED
@@ -14,6 +14,8 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "DownloadCache.h"
 #include "Source_GitHub.h"
+#include "InstallFilter.h"
+#include "Settings.h"
 
 /** Refers to a module. */
 class Module
@@ -46,43 +48,30 @@ public:
         return name.paddedRight (' ', 40) + getDescription();
     }
 
-    /** Install this module into a destination folder. */
-    void install (const File& destinationFolder)
+    /**
+     * Downloads the module if need be and returns the folder holding it, or
+     * File::nonexistent.  The version is updated to what was actually fetched.
+     * Install filters aren't applied here but when the folder is copied.
+     */
+    File fetch()
     {
-        File file;
-
         if (getSource() == "GitHub")
         {
             GitHubSource github;
             auto result = github.download (getPath(), getVersion(), getSubPath());
 
             if (! result.success)
-                return;
+                return File::nonexistent;
 
-            file = result.file;
             setVersion (result.actualVersionNumber);
+            return result.file;
         }
-        else if (getSource() == "LocalPath")
-        {
 
-        }
-        else
-        {
-            std::cerr << "Invalid source " + getSource() << std::endl;
-        }
+        if (getSource() == "LocalPath")
+            return File::getCurrentWorkingDirectory().getChildFile (getPath()).getChildFile (getName());
 
-        if (! file.exists())
-        {
-            std::cerr << "Invalid module" << std::endl;
-            return;
-        }
-
-        auto result = file.copyDirectoryTo (destinationFolder.getChildFile (getName()));
-
-        if (!result)
-        {
-            std::cerr << "Problem copying module" << std::endl;
-        }
+        std::cerr << "Invalid source " + getSource() << std::endl;
+        return File::nonexistent;
     }
 
     /* Getters and setters. */
@@ -142,6 +131,33 @@ public:
     {
         state.setProperty ("repo", repo, nullptr);
     }
+    /** Semicolon separated patterns of files to install; see InstallFilter. */
+    String getIncludes() const
+    {
+        return state["include"];
+    }
+    void setIncludes (const String& includes)
+    {
+        state.setProperty ("include", includes, nullptr);
+    }
+    /** Semicolon separated patterns of files to leave out; see InstallFilter. */
+    String getExcludes() const
+    {
+        return state["exclude"];
+    }
+    void setExcludes (const String& excludes)
+    {
+        state.setProperty ("exclude", excludes, nullptr);
+    }
+
+    /** The global defaults from the settings plus this module's own patterns. */
+    InstallFilter getInstallFilter() const
+    {
+        auto& settings = Settings::getInstance();
+        InstallFilter filter (settings.getDefaultIncludes(), settings.getDefaultExcludes());
+        filter.add (InstallFilter (getIncludes(), getExcludes()));
+        return filter;
+    }
 private:
     static StringArray& getValidSources()
     {
@@ -3,6 +3,7 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "Utilities.h"
+#include "Mirrors.h"
 
 
 #define ID(x) const Identifier x (#x);
@@ -37,12 +38,7 @@ ID (mingwLibs)
 String readEntireTextStreamCustomHeaders (URL url)
 {
     String headers = "Accept: application/vnd.github.drax-preview+json";
-    const ScopedPointer<InputStream> in (url.createInputStream (false, nullptr, nullptr, headers));
-
-    if (in != nullptr)
-        return in->readEntireStreamAsString();
-
-    return String();
+    return Mirrors::getInstance().fetchText (url.toString (true), headers);
 }
 
 
@@ -0,0 +1,313 @@
+/*
+  ==============================================================================
+
+    ModuleServer.h
+    Created: 20 Oct 2026 11:47:09am
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef MODULESERVER_H_INCLUDED
+#define MODULESERVER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "HttpServer.h"
+#include "DownloadCache.h"
+#include "Settings.h"
+#include "DirectoryDelta.h"
+#include <map>
+
+/**
+ * Serves this machine's download cache to other jpm clients - `jpm serve`.
+ *
+ *   /directory.xml[?since=<version>]            the module directory, or what
+ *                                               changed since a version
+ *   /github/<owner>/<repo>/archive/<ver>.<ext>  GitHub source archives
+ *   /api/repos/<owner>/<repo>/commits/<ref>     ref lookups
+ *   /api/licenses/<name>                        licence texts for genmodule
+ *
+ * Anything not already cached, or past its refresh time, is fetched from
+ * upstream first; concurrent requests for the same thing wait for a single
+ * fetch.  If upstream can't be reached the stale copy is served.
+ *
+ * Each distinct directory fetched from upstream is kept as a numbered
+ * snapshot, so clients can be sent just the changes since the version they
+ * already hold.
+ *
+ * The server's own upstream requests ignore any mirrors in its settings, so
+ * a machine that points at itself can't loop.
+ */
+class ModuleServer
+    :
+    public HttpServer::Handler
+{
+public:
+    ModuleServer()
+        :
+        directoryUrl (Settings::getInstance().getDirectoryUrl())
+    {}
+
+    HttpServer::Response handle (const HttpServer::Request& request) override
+    {
+        auto path = request.path;
+
+        if (path == "/directory.xml")
+            return serveDirectory (request);
+
+        if (path.startsWith ("/github/") && isArchivePath (path.substring (8)))
+            return serveArchive (request, githubUrl + path.substring (8));
+
+        if (path.startsWith ("/api/repos/") && path.contains ("/commits/"))
+            return serveText (request, apiUrl + path.substring (5), "application/json", refMaxAgeMinutes);
+
+        if (path.startsWith ("/api/licenses/"))
+            return serveText (request, apiUrl + path.substring (5), "application/json", directoryMaxAgeMinutes);
+
+        return HttpServer::makeError (404, "not found: " + path);
+    }
+
+    /** A jpm.settings.xml for clients, given the URL they reach this server at. */
+    String getClientSettings (const String& baseUrl) const
+    {
+        String s;
+        s << "<jpm_settings>" << newLine
+          << "  <mirror prefix=\"" << directoryUrl << "\" url=\"" << baseUrl << "directory.xml\"/>" << newLine
+          << "  <mirror prefix=\"" << githubUrl << "\" url=\"" << baseUrl << "github/\"/>" << newLine
+          << "  <mirror prefix=\"" << apiUrl << "\" url=\"" << baseUrl << "api/\"/>" << newLine
+          << "</jpm_settings>" << newLine;
+        return s;
+    }
+
+private:
+    /** Only archives are proxied, so this isn't an open proxy onto GitHub. */
+    static bool isArchivePath (const String& path)
+    {
+        StringArray parts;
+        parts.addTokens (path, "/", String());
+
+        return parts.size() == 4
+               && parts[2] == "archive"
+               && ! parts.contains ("..")
+               && (parts[3].endsWith (".zip") || parts[3].endsWith (".tar.gz"));
+    }
+
+    HttpServer::Response serveArchive (const HttpServer::Request& request, const String& upstream)
+    {
+        URL url (upstream);
+        auto archive = cache.getArchiveLocation (url);
+
+        {
+            auto lock = getFillLock (upstream);
+            std::lock_guard<std::mutex> fill (*lock);
+
+            if (! archive.existsAsFile() || ! cache.isRecent (archive))
+            {
+                printInfo ("fetching " + upstream);
+
+                if (! ResumableDownload (url, archive).run() && ! archive.existsAsFile())
+                    return HttpServer::makeError (502, "could not fetch " + upstream);
+            }
+        }
+
+        auto type = upstream.endsWith (".zip") ? "application/zip" : "application/gzip";
+        return HttpServer::serveFile (request, archive, type);
+    }
+
+    HttpServer::Response serveText (const HttpServer::Request& request, const String& upstream,
+                                    const String& contentType, int maxAgeMinutes)
+    {
+        /* Licence lookups need a preview Accept header, which changes the reply. */
+        auto accept = request.headers["Accept"];
+        String error;
+        auto cached = fillText (upstream, accept.startsWith ("application/vnd.github") ? accept : String(), maxAgeMinutes, error);
+
+        if (cached == File::nonexistent)
+            return HttpServer::makeError (502, error);
+
+        return HttpServer::serveFile (request, cached, contentType);
+    }
+
+    /** Returns the cached copy of upstream, fetching it first if it's missing or too old. */
+    File fillText (const String& upstream, const String& accept, int maxAgeMinutes, String& error)
+    {
+        auto cached = cache.getCachedFileLocation (URL (upstream), accept);
+        auto lock = getFillLock (cached.getFullPathName());
+        std::lock_guard<std::mutex> fill (*lock);
+
+        if (cached.existsAsFile() && isYoungerThan (cached, maxAgeMinutes))
+            return cached;
+
+        TransferRequest fetch ((URL (upstream)));
+
+        if (accept.isNotEmpty())
+            fetch.extraHeaders = "Accept: " + accept;
+
+        auto result = TransferEngine::getInstance().fetch (fetch);
+
+        if (result.succeeded())
+        {
+            cached.replaceWithData (result.body.getData(), result.body.getSize());
+        }
+        else if (cached.existsAsFile())
+        {
+            printWarning ("could not refresh " + upstream + ", serving cached copy");
+        }
+        else
+        {
+            error = "could not fetch " + upstream + " (" + result.getFailureReason() + ")";
+            return File::nonexistent;
+        }
+
+        return cached;
+    }
+
+    HttpServer::Response serveDirectory (const HttpServer::Request& request)
+    {
+        String error;
+        auto upstream = fillText (directoryUrl, String(), directoryMaxAgeMinutes, error);
+
+        if (upstream == File::nonexistent)
+            return HttpServer::makeError (502, error);
+
+        auto latest = updateDirectoryHistory (upstream);
+
+        if (latest == File::nonexistent)
+            return HttpServer::makeError (502, "directory from " + directoryUrl + " isn't valid");
+
+        const int since = getQueryParameter (request.query, "since").getIntValue();
+        auto old = since > 0 ? loadTree (getHistoryFolder().getChildFile (String (since) + ".xml")) : ValueTree();
+
+        /* Too old to have kept, so they get the whole thing. */
+        if (! old.isValid())
+            return HttpServer::serveFile (request, latest, "text/xml");
+
+        auto delta = DirectoryDelta::compute (old, loadTree (latest));
+        auto text = delta.toXmlString();
+
+        HttpServer::Response r;
+        r.headers.set ("Content-Type", "text/xml");
+        r.body.append (text.toRawUTF8(), text.getNumBytesAsUTF8());
+        return r;
+    }
+
+    /**
+     * Numbers each distinct directory seen from upstream.  The upstream's own
+     * version is used when it has one and it moves forward; otherwise the
+     * number after the last is assigned.  Returns the latest snapshot.
+     */
+    File updateDirectoryHistory (const File& upstream)
+    {
+        std::lock_guard<std::mutex> lock (historyLock);
+        auto folder = getHistoryFolder();
+
+        if (latestVersion < 0)
+        {
+            latestVersion = 0;
+            Array<File> snapshots;
+            folder.findChildFiles (snapshots, File::findFiles, false, "*.xml");
+
+            for (auto& f : snapshots)
+                latestVersion = jmax (latestVersion, f.getFileNameWithoutExtension().getIntValue());
+        }
+
+        auto latest = folder.getChildFile (String (latestVersion) + ".xml");
+
+        if (latestVersion > 0 && latest.getLastModificationTime() >= upstream.getLastModificationTime())
+            return latest;
+
+        auto tree = loadTree (upstream);
+
+        if (! tree.isValid())
+            return latestVersion > 0 ? latest : File::nonexistent;
+
+        const int upstreamVersion = DirectoryDelta::getVersion (tree);
+        tree.setProperty ("version", latestVersion, nullptr);
+
+        if (latestVersion > 0 && tree.isEquivalentTo (loadTree (latest)))
+        {
+            latest.setLastModificationTime (Time::getCurrentTime());
+            return latest;
+        }
+
+        latestVersion = jmax (latestVersion + 1, upstreamVersion);
+        tree.setProperty ("version", latestVersion, nullptr);
+
+        latest = folder.getChildFile (String (latestVersion) + ".xml");
+        folder.createDirectory();
+        latest.replaceWithText (tree.toXmlString());
+
+        /* Keep enough history for clients that update now and then. */
+        for (int v = latestVersion - maxSnapshots; v > 0; --v)
+        {
+            auto old = folder.getChildFile (String (v) + ".xml");
+
+            if (! old.existsAsFile())
+                break;
+
+            old.deleteFile();
+        }
+
+        printInfo ("directory is now version " + String (latestVersion));
+        return latest;
+    }
+
+    File getHistoryFolder() const
+    {
+        return cache.location.getChildFile ("directory.history");
+    }
+
+    static ValueTree loadTree (const File& file)
+    {
+        ScopedPointer<XmlElement> xml = XmlDocument (file).getDocumentElement();
+        return xml != nullptr ? ValueTree::fromXml (*xml) : ValueTree();
+    }
+
+    static String getQueryParameter (const String& query, const String& name)
+    {
+        StringArray pairs;
+        pairs.addTokens (query, "&", String());
+
+        for (auto& p : pairs)
+            if (p.upToFirstOccurrenceOf ("=", false, false) == name)
+                return URL::removeEscapeChars (p.fromFirstOccurrenceOf ("=", false, false));
+
+        return String();
+    }
+
+    static bool isYoungerThan (const File& file, int minutes)
+    {
+        return Time::getCurrentTime() - file.getLastModificationTime() < RelativeTime::minutes (minutes);
+    }
+
+    std::shared_ptr<std::mutex> getFillLock (const String& key)
+    {
+        std::lock_guard<std::mutex> lock (fillLocksLock);
+        auto& m = fillLocks[key];
+
+        if (m == nullptr)
+            m = std::make_shared<std::mutex>();
+
+        return m;
+    }
+
+    const String githubUrl { "https://www.github.com/" };
+    const String apiUrl { "https://api.github.com/" };
+
+    /* Refs move, so a fleet should see a new commit on master within a minute. */
+    static const int refMaxAgeMinutes = 1;
+    static const int directoryMaxAgeMinutes = 60;
+    static const int maxSnapshots = 100;
+
+    String directoryUrl;
+    DownloadCache cache;
+
+    std::mutex historyLock;
+    int latestVersion { -1 };
+
+    std::mutex fillLocksLock;
+    std::map<String, std::shared_ptr<std::mutex>> fillLocks;
+};
+
+#endif  // MODULESERVER_H_INCLUDED
@@ -0,0 +1,315 @@
+/*
+  ==============================================================================
+
+    ModuleStore.h
+    Created: 20 Oct 2026 10:26:50pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef MODULESTORE_H_INCLUDED
+#define MODULESTORE_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "Module.h"
+#include "DirectoryCopier.h"
+#include "ModuleVerifier.h"
+#include <set>
+
+#if JUCE_MAC || JUCE_LINUX
+ #include <stdio.h>
+ #include <unistd.h>
+#endif
+
+/**
+ * Keeps every installed version of a module side by side.
+ *
+ *   jpm_modules/.store/<name>@<version>/   an installed copy, with a suffix
+ *                                          if install filters were applied
+ *   jpm_modules/<name>                     a symlink to the active one
+ *
+ * Switching to a version that's already in the store is a single rename of a
+ * new symlink over the old one, so the project never sees a half-switched
+ * module and going back and forth between branches doesn't copy anything.
+ * Copies are written to a .partial folder and renamed into place once
+ * complete, with a manifest of their hashes beside them for `jpm verify`.
+ *
+ * On Windows, where symlinks need special privileges, the active version is
+ * copied out of the store instead.
+ */
+class ModuleStore
+{
+public:
+    ModuleStore (const File& modulesFolder_)
+        :
+        modulesFolder (modulesFolder_),
+        storeFolder (modulesFolder_.getChildFile (".store"))
+    {}
+
+    /** Where a version of a module lives in the store. */
+    File getEntry (const String& name, const String& version) const
+    {
+        return storeFolder.getChildFile (File::createLegalFileName (name + "@" + version));
+    }
+
+    /** The version a module is stored under; a filtered copy is kept apart from an unfiltered one. */
+    static String getStoredVersion (const Module& module)
+    {
+        auto key = module.getInstallFilter().getKey();
+
+        if (key.isEmpty())
+            return module.getVersion();
+
+        return module.getVersion() + "+" + String::toHexString (key.hashCode64());
+    }
+
+    /** The file hashes recorded when an entry was added. */
+    static File getManifest (const File& entry)
+    {
+        return entry.getSiblingFile (entry.getFileName() + ".manifest");
+    }
+
+    /** The stored copy jpm_modules/<name> currently refers to. */
+    File getActiveEntry (const String& name) const
+    {
+#if JUCE_MAC || JUCE_LINUX
+        auto link = modulesFolder.getChildFile (name);
+        return link.isSymbolicLink() ? link.getLinkedTarget() : File::nonexistent;
+#else
+        return getEntry (name, getActiveVersionFile (name).loadFileAsString());
+#endif
+    }
+
+    bool contains (const String& name, const String& version) const
+    {
+        return getEntry (name, version).isDirectory();
+    }
+
+    /** True if jpm_modules/<name> is already this version. */
+    bool isActive (const String& name, const String& version) const
+    {
+        auto link = modulesFolder.getChildFile (name);
+
+#if JUCE_MAC || JUCE_LINUX
+        return link.isSymbolicLink() && link.getLinkedTarget() == getEntry (name, version);
+#else
+        return link.isDirectory() && getActiveVersionFile (name).loadFileAsString() == version;
+#endif
+    }
+
+    /**
+     * Copies a fetched module into the store, replacing any half-finished
+     * copy.  Files the filter rejects aren't copied, and what they would have
+     * cost is reported.
+     */
+    Result add (const Module& module, const File& source, InstallFilter filter)
+    {
+        auto entry = getEntry (module.getName(), getStoredVersion (module));
+
+        if (entry.isDirectory())
+            return Result::ok();
+
+        auto partial = entry.getSiblingFile (entry.getFileName() + ".partial");
+        partial.deleteRecursively();
+
+        DirectoryCopier copier;
+
+        auto accepted = [&filter] (const String& path, bool isDirectory)
+        {
+            return filter.accepts (path, isDirectory);
+        };
+
+        if (! copier.copy (source, partial, accepted))
+        {
+            partial.deleteRecursively();
+            return Result::fail ("problem copying " + module.getName() + ": " + copier.getError());
+        }
+
+        auto& stats = copier.getStats();
+        printInfo (stats.getSummaryString());
+
+        /* The time saved is estimated from the rate this copy ran at. */
+        const double rate = stats.getMegabytesPerSecond();
+        const double megabytesSkipped = stats.numBytesSkipped / (1024.0 * 1024.0);
+        filter.recordSkipped (stats.numFilesSkipped, stats.numBytesSkipped, rate > 0.0 ? megabytesSkipped / rate : 0.0);
+
+        if (filter.getNumFilesSkipped() > 0)
+            printInfo (module.getName() + ": " + filter.getSavingsString());
+
+        if (! ModuleVerifier::writeManifest (partial, getManifest (entry)))
+            printWarning ("could not record a manifest for " + module.getName());
+
+        if (! partial.moveFileTo (entry))
+        {
+            partial.deleteRecursively();
+
+            /* Another process got there first. */
+            if (! entry.isDirectory())
+                return Result::fail ("could not move " + module.getName() + " into the store");
+        }
+
+        return Result::ok();
+    }
+
+    /** Makes a stored version the one the project sees. */
+    bool activate (const String& name, const String& version)
+    {
+        auto entry = getEntry (name, version);
+        auto link = modulesFolder.getChildFile (name);
+
+        if (! entry.isDirectory())
+            return false;
+
+        /* A real folder from before the store existed is kept, in case it
+         * was edited, and so is anything adopted earlier. */
+        if (link.isDirectory() && ! isManaged (name))
+        {
+            auto adopted = getUnusedAdoptionEntry (name);
+
+            if (! link.moveFileTo (adopted))
+            {
+                printError ("could not move " + link.getFullPathName() + " to " + adopted.getFullPathName());
+                return false;
+            }
+
+            printInfo ("kept the existing " + name + " as " + adopted.getFileName());
+        }
+
+#if JUCE_MAC || JUCE_LINUX
+        auto temp = modulesFolder.getChildFile ("." + name + ".link");
+        auto target = entry.getRelativePathFrom (modulesFolder);
+
+        unlink (temp.getFullPathName().toRawUTF8());
+
+        if (symlink (target.toRawUTF8(), temp.getFullPathName().toRawUTF8()) != 0)
+            return false;
+
+        /* rename() swaps the link in one step. */
+        if (rename (temp.getFullPathName().toRawUTF8(), link.getFullPathName().toRawUTF8()) != 0)
+        {
+            unlink (temp.getFullPathName().toRawUTF8());
+            return false;
+        }
+
+        return true;
+#else
+        link.deleteRecursively();
+
+        DirectoryCopier copier;
+
+        if (! copier.copy (entry, link))
+            return false;
+
+        return getActiveVersionFile (name).replaceWithText (version);
+#endif
+    }
+
+    /**
+     * Removes stored versions that aren't active and aren't in keep, which
+     * holds "<name>@<version>" strings.  Returns the bytes freed.
+     *
+     * Folders adopted by activate() as @unversioned, or @unversioned-2 and
+     * so on, may hold local edits and exist nowhere else, so they're only
+     * removed if includeUnversioned is set; otherwise each one left is
+     * mentioned.
+     */
+    int64 prune (const StringArray& keep, bool includeUnversioned = false)
+    {
+        std::set<String> wanted;
+
+        for (auto& k : keep)
+            wanted.insert (File::createLegalFileName (k));
+
+        Array<File> entries;
+        storeFolder.findChildFiles (entries, File::findDirectories, false, "*");
+
+        int64 freed = 0;
+
+        for (auto& e : entries)
+        {
+            auto name = e.getFileName().upToLastOccurrenceOf ("@", false, false);
+
+            if (wanted.count (e.getFileName()) > 0)
+                continue;
+
+            if (! includeUnversioned && isAdopted (e))
+            {
+                printInfo ("kept " + e.getFileName() + ", which may have local changes; use --unversioned to delete it");
+                continue;
+            }
+
+#if JUCE_MAC || JUCE_LINUX
+            auto link = modulesFolder.getChildFile (name);
+
+            if (link.isSymbolicLink() && link.getLinkedTarget() == e)
+                continue;
+#else
+            if (getEntry (name, getActiveVersionFile (name).loadFileAsString()) == e)
+                continue;
+#endif
+
+            const int64 size = getSize (e);
+
+            if (e.deleteRecursively())
+            {
+                getManifest (e).deleteFile();
+                printInfo ("pruned " + e.getFileName());
+                freed += size;
+            }
+        }
+
+        return freed;
+    }
+
+private:
+    File getActiveVersionFile (const String& name) const
+    {
+        return storeFolder.getChildFile (File::createLegalFileName (name) + ".active");
+    }
+
+    /** True if jpm_modules/<name> was put there by activate() rather than by hand. */
+    bool isManaged (const String& name) const
+    {
+#if JUCE_MAC || JUCE_LINUX
+        return modulesFolder.getChildFile (name).isSymbolicLink();
+#else
+        /* The active version is a real copy here, so the marker is what tells them apart. */
+        return getActiveVersionFile (name).existsAsFile();
+#endif
+    }
+
+    /** Never an earlier adoption, which may be the only copy of someone's edits. */
+    File getUnusedAdoptionEntry (const String& name) const
+    {
+        auto entry = getEntry (name, "unversioned");
+
+        for (int i = 2; entry.exists(); ++i)
+            entry = getEntry (name, "unversioned-" + String (i));
+
+        return entry;
+    }
+
+    static bool isAdopted (const File& entry)
+    {
+        return entry.getFileName().fromLastOccurrenceOf ("@", false, false).startsWith ("unversioned");
+    }
+
+    static int64 getSize (const File& folder)
+    {
+        int64 total = 0;
+        DirectoryIterator iter (folder, true, "*", File::findFiles);
+        int64 size = 0;
+
+        while (iter.next (nullptr, nullptr, &size, nullptr, nullptr, nullptr))
+            total += size;
+
+        return total;
+    }
+
+    File modulesFolder;
+    File storeFolder;
+};
+
+#endif  // MODULESTORE_H_INCLUDED
@@ -0,0 +1,324 @@
+/*
+  ==============================================================================
+
+    ModuleVerifier.h
+    Created: 21 Oct 2026 9:32:18am
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef MODULEVERIFIER_H_INCLUDED
+#define MODULEVERIFIER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "Sha256.h"
+#include <map>
+
+#if JUCE_MAC || JUCE_LINUX
+ #include <sys/stat.h>
+#endif
+
+/**
+ * Checks installed modules against the manifests written when they were
+ * added to the store - `jpm verify`.
+ *
+ * A manifest lists the SHA-256 of every file in the same format as
+ * sha256sum, so it can also be checked by hand.  Every file of every module
+ * is hashed on a pool of threads.  A stat cache remembers the hash of each
+ * file along with its inode, size and modification time, and a file whose
+ * stat still matches isn't read again, so checking an unchanged project only
+ * costs a stat per file.
+ */
+class ModuleVerifier
+{
+public:
+    struct Target
+    {
+        String name;
+        File folder;
+        File manifest;
+    };
+
+    struct Stats
+    {
+        int numModules { 0 };
+        int numFiles { 0 };
+        int numHashed { 0 };
+        int64 numBytesHashed { 0 };
+        double seconds { 0.0 };
+    };
+
+    /** With useStatCache false every file is read, which catches edits that preserved the modification time. */
+    ModuleVerifier (const File& statCacheFile_, bool useStatCache_ = true)
+        :
+        statCacheFile (statCacheFile_),
+        useStatCache (useStatCache_)
+    {
+        if (useStatCache)
+            loadStatCache();
+    }
+
+    /** Hashes every file below folder and writes the manifest. */
+    static bool writeManifest (const File& folder, const File& manifest)
+    {
+        Array<Job> jobs;
+        addJobs (folder, jobs);
+
+        parallelFor (jobs.size(), SystemStats::getNumCpus(), [&jobs] (int i)
+        {
+            auto& j = jobs.getReference (i);
+            j.hash = hashFile (j.file);
+        });
+
+        StringArray lines;
+
+        for (auto& j : jobs)
+            lines.add (j.hash + "  " + j.relativePath);
+
+        lines.sort (false);
+        return manifest.replaceWithText (lines.joinIntoString ("\n") + "\n");
+    }
+
+    /** Returns a line for each thing that doesn't match, e.g. "juce_core: modified text/juce_String.cpp". */
+    StringArray verify (const Array<Target>& targets)
+    {
+        const double startTime = Time::getMillisecondCounterHiRes();
+        stats = Stats();
+        stats.numModules = targets.size();
+
+        StringArray problems;
+        Array<Job> jobs;
+        Array<int> firstJob;
+
+        for (auto& t : targets)
+        {
+            firstJob.add (jobs.size());
+
+            if (! t.folder.isDirectory())
+                problems.add (t.name + ": not installed");
+            else
+                addJobs (t.folder, jobs);
+        }
+
+        firstJob.add (jobs.size());
+
+        std::atomic<int> numHashed (0);
+        std::atomic<int64> numBytesHashed (0);
+
+        parallelFor (jobs.size(), SystemStats::getNumCpus(), [&] (int i)
+        {
+            auto& j = jobs.getReference (i);
+            getStat (j.file, j.stat);
+
+            auto cached = statCache.find (j.file.getFullPathName());
+
+            if (useStatCache && cached != statCache.end() && cached->second.matches (j.stat))
+            {
+                j.hash = cached->second.hash;
+                return;
+            }
+
+            j.hash = hashFile (j.file);
+            ++numHashed;
+            numBytesHashed += j.stat.size;
+        });
+
+        for (int t = 0; t < targets.size(); ++t)
+        {
+            if (! targets[t].folder.isDirectory())
+                continue;
+
+            std::map<String, String> expected;
+
+            if (! readManifest (targets[t].manifest, expected))
+            {
+                problems.add (targets[t].name + ": no manifest, reinstall it to record one");
+                continue;
+            }
+
+            for (int i = firstJob[t]; i < firstJob[t + 1]; ++i)
+            {
+                auto& j = jobs.getReference (i);
+                auto e = expected.find (j.relativePath);
+
+                if (e == expected.end())
+                    problems.add (targets[t].name + ": unexpected " + j.relativePath);
+                else if (e->second != j.hash)
+                    problems.add (targets[t].name + ": modified " + j.relativePath);
+
+                if (e != expected.end())
+                    expected.erase (e);
+            }
+
+            for (auto& missing : expected)
+                problems.add (targets[t].name + ": missing " + missing.first);
+        }
+
+        /* Only what's installed now, so the cache doesn't fill up with old versions. */
+        statCache.clear();
+
+        for (auto& j : jobs)
+        {
+            j.stat.hash = j.hash;
+            statCache[j.file.getFullPathName()] = j.stat;
+        }
+
+        saveStatCache();
+
+        stats.numFiles = jobs.size();
+        stats.numHashed = numHashed;
+        stats.numBytesHashed = numBytesHashed;
+        stats.seconds = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+        return problems;
+    }
+
+    const Stats& getStats() const
+    {
+        return stats;
+    }
+
+private:
+    struct StatInfo
+    {
+        int64 inode { 0 };
+        int64 size { 0 };
+        int64 modified { 0 };
+        String hash;
+
+        bool matches (const StatInfo& other) const
+        {
+            return inode == other.inode && size == other.size && modified == other.modified;
+        }
+    };
+
+    struct Job
+    {
+        File file;
+        String relativePath;
+        StatInfo stat;
+        String hash;
+    };
+
+    static void addJobs (const File& folder, Array<Job>& jobs)
+    {
+        DirectoryIterator iter (folder, true, "*", File::findFiles);
+
+        while (iter.next())
+        {
+            Job j;
+            j.file = iter.getFile();
+            j.relativePath = j.file.getRelativePathFrom (folder).replaceCharacter ('\\', '/');
+            jobs.add (j);
+        }
+    }
+
+    static void getStat (const File& file, StatInfo& info)
+    {
+#if JUCE_MAC || JUCE_LINUX
+        struct stat s;
+
+        if (stat (file.getFullPathName().toRawUTF8(), &s) != 0)
+            return;
+
+        info.inode = (int64) s.st_ino;
+        info.size = (int64) s.st_size;
+       #if JUCE_MAC
+        info.modified = (int64) s.st_mtimespec.tv_sec * 1000000000 + s.st_mtimespec.tv_nsec;
+       #else
+        info.modified = (int64) s.st_mtim.tv_sec * 1000000000 + s.st_mtim.tv_nsec;
+       #endif
+#else
+        info.size = file.getSize();
+        info.modified = file.getLastModificationTime().toMilliseconds();
+#endif
+    }
+
+    static String hashFile (const File& file)
+    {
+        FileInputStream in (file);
+
+        if (in.failedToOpen())
+            return String();
+
+        Sha256 sha;
+        HeapBlock<char> buffer (bufferSize);
+
+        for (;;)
+        {
+            const int n = in.read (buffer, bufferSize);
+
+            if (n <= 0)
+                break;
+
+            sha.update (buffer, (size_t) n);
+        }
+
+        return sha.finishAsHex();
+    }
+
+    static bool readManifest (const File& manifest, std::map<String, String>& entries)
+    {
+        if (! manifest.existsAsFile())
+            return false;
+
+        StringArray lines;
+        manifest.readLines (lines);
+
+        for (auto& line : lines)
+            if (line.length() > 66)
+                entries[line.substring (66)] = line.substring (0, 64);
+
+        return true;
+    }
+
+    /** One line per file: inode size modified hash path. */
+    void loadStatCache()
+    {
+        StringArray lines;
+        statCacheFile.readLines (lines);
+
+        for (auto& line : lines)
+        {
+            StringArray fields;
+            fields.addTokens (line.upToFirstOccurrenceOf ("\t", false, false), " ", String());
+
+            if (fields.size() != 4)
+                continue;
+
+            StatInfo info;
+            info.inode = fields[0].getLargeIntValue();
+            info.size = fields[1].getLargeIntValue();
+            info.modified = fields[2].getLargeIntValue();
+            info.hash = fields[3];
+            statCache[line.fromFirstOccurrenceOf ("\t", false, false)] = info;
+        }
+    }
+
+    void saveStatCache() const
+    {
+        String text;
+
+        for (auto& entry : statCache)
+        {
+            auto& info = entry.second;
+
+            if (info.hash.isNotEmpty())
+                text << info.inode << " " << info.size << " " << info.modified << " " << info.hash
+                     << "\t" << entry.first << "\n";
+        }
+
+        statCacheFile.replaceWithText (text);
+    }
+
+    static const int bufferSize = 256 * 1024;
+
+    File statCacheFile;
+    bool useStatCache;
+    std::map<String, StatInfo> statCache;
+    Stats stats;
+};
+
+#endif  // MODULEVERIFIER_H_INCLUDED
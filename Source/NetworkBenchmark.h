@@ -0,0 +1,483 @@
+/*
+  ==============================================================================
+
+    NetworkBenchmark.h
+    Created: 21 Oct 2026 7:34:18pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef NETWORKBENCHMARK_H_INCLUDED
+#define NETWORKBENCHMARK_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "BenchmarkFixtures.h"
+#include "HttpServer.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+
+/**
+ * Stands in for GitHub and the directory host, over a link that can be made
+ * slow and unreliable.  The layout is the one `jpm serve` uses:
+ *
+ *   /directory.xml                                 the generated directory
+ *   /github/bench/repo_<n>/archive/<ref>.tar.gz    archives, any ref
+ *   /github/bench/repo_<n>/archive/<ref>.zip
+ *   /api/repos/bench/repo_<n>/commits/master       a fixed commit
+ *
+ * Every new connection is held up by the handshake time before its first
+ * request is read, and every response is delayed by the latency and paced
+ * to the bandwidth.  A response may instead fail with a 503, or have its
+ * connection dropped part way through, at the configured rates.  The dice
+ * come from a fixed seed.
+ *
+ * It only speaks plain http, so it exercises jpm's event loop and its
+ * connection pool.  Real GitHub traffic is https, which runs over the same
+ * loop and pool with TLS on top; the cost of the TLS handshakes and of the
+ * encryption isn't measured here, and the results say so.
+ */
+class SimulatedNetwork
+    :
+    public HttpServer::Handler
+{
+public:
+    struct Conditions
+    {
+        int latencyMs { 0 };
+        int handshakeMs { 0 };
+        int64 bytesPerSecond { 0 };
+        double dropRate { 0.0 };
+        double errorRate { 0.0 };
+        int64 seed { 1 };
+    };
+
+    SimulatedNetwork (const Conditions& conditions_, const File& fixtures_)
+        :
+        conditions (conditions_),
+        fixtures (fixtures_),
+        random (conditions_.seed)
+    {}
+
+    HttpServer::Response handle (const HttpServer::Request& request) override
+    {
+        bool fail, drop;
+        double dropPoint;
+
+        {
+            std::lock_guard<std::mutex> lock (randomLock);
+            fail = random.nextDouble() < conditions.errorRate;
+            drop = random.nextDouble() < conditions.dropRate;
+            dropPoint = random.nextDouble();
+        }
+
+        ++numRequests;
+
+        if (conditions.latencyMs > 0)
+            Thread::sleep (conditions.latencyMs);
+
+        if (fail)
+        {
+            ++numErrors;
+            return HttpServer::makeError (503, "simulated failure");
+        }
+
+        auto response = route (request);
+        response.bytesPerSecond = conditions.bytesPerSecond;
+
+        if (drop && response.statusCode / 100 == 2)
+        {
+            const int64 length = response.file != File::nonexistent ? response.rangeLength
+                                                                    : (int64) response.body.getSize();
+            response.dropAfter = (int64) (length * dropPoint);
+            ++numDrops;
+        }
+
+        return response;
+    }
+
+    void connectionOpened() override
+    {
+        ++numConnections;
+
+        if (conditions.handshakeMs > 0)
+            Thread::sleep (conditions.handshakeMs);
+    }
+
+    static File getArchive (const File& fixtures, int repo, const String& extension)
+    {
+        return fixtures.getChildFile ("archives").getChildFile ("repo_" + String (repo) + extension);
+    }
+
+    int getNumRequests() const { return numRequests; }
+    int getNumConnections() const { return numConnections; }
+    int getNumErrors() const { return numErrors; }
+    int getNumDrops() const { return numDrops; }
+
+private:
+    HttpServer::Response route (const HttpServer::Request& request)
+    {
+        auto path = request.path;
+
+        if (path == "/directory.xml")
+            return HttpServer::serveFile (request, fixtures.getChildFile ("directory.xml"), "text/xml");
+
+        if (path.startsWith ("/api/repos/bench/") && path.endsWith ("/commits/master"))
+        {
+            HttpServer::Response r;
+            auto text = String ("{\"sha\":\"b3c4d5e6f708192a3b4c5d6e7f8091a2b3c4d5e6\"}");
+            r.headers.set ("Content-Type", "application/json");
+            r.body.append (text.toRawUTF8(), text.getNumBytesAsUTF8());
+            return r;
+        }
+
+        StringArray parts;
+        parts.addTokens (path, "/", String());
+
+        /* "", "github", "bench", "repo_<n>", "archive", "<ref>.<ext>" */
+        if (parts.size() == 6 && parts[1] == "github" && parts[2] == "bench" && parts[4] == "archive"
+            && parts[3].startsWith ("repo_"))
+        {
+            const bool zip = parts[5].endsWith (".zip");
+            auto archive = getArchive (fixtures, parts[3].substring (5).getIntValue(), zip ? ".zip" : ".tar.gz");
+
+            if ((zip || parts[5].endsWith (".tar.gz")) && archive.existsAsFile())
+                return HttpServer::serveFile (request, archive, zip ? "application/zip" : "application/gzip");
+        }
+
+        return HttpServer::makeError (404, "not found: " + path);
+    }
+
+    Conditions conditions;
+    File fixtures;
+
+    std::mutex randomLock;
+    Random random;
+
+    std::atomic<int> numRequests { 0 };
+    std::atomic<int> numConnections { 0 };
+    std::atomic<int> numErrors { 0 };
+    std::atomic<int> numDrops { 0 };
+};
+
+/**
+ * Times whole installs over a SimulatedNetwork - `jpm bench install`.
+ *
+ * jpm is run as a child process in a fresh project, installing the first n
+ * modules of a generated directory, each module in a repository of its own.
+ * It finds the stand-in through a settings file written for the run: the
+ * directory points at it and its mirrors of GitHub are exclusive, so
+ * nothing reaches the real network, and the download cache is kept in the
+ * work folder.
+ *
+ * Each run installs cold, from an empty cache, then warm, into another
+ * fresh project with the cache the cold install left behind.  Percentiles
+ * of the wall time over the runs are reported for each module count.
+ */
+class NetworkBenchmark
+{
+public:
+    struct Options
+    {
+        File workFolder;
+        File jpmExecutable;
+        Array<int> moduleCounts;
+        int runs { 5 };
+        int port { 47100 };
+        SimulatedNetwork::Conditions conditions;
+        BenchmarkFixtures::TreeShape shape { "module", 40, 4096, 2 };
+    };
+
+    struct Result
+    {
+        int numModules { 0 };
+        String mode;
+        int failures { 0 };
+        Array<double> samplesMs;
+
+        /** Nearest rank, so with few runs the high percentiles are the slowest run. */
+        double getPercentile (double percent) const
+        {
+            if (samplesMs.isEmpty())
+                return 0.0;
+
+            auto sorted = samplesMs;
+            std::sort (sorted.begin(), sorted.end());
+            const int rank = (int) std::ceil (percent / 100.0 * sorted.size());
+            return sorted[jlimit (0, sorted.size() - 1, rank - 1)];
+        }
+    };
+
+    NetworkBenchmark (const Options& options_)
+        :
+        options (options_)
+    {}
+
+    /** Returns false if the stand-in couldn't be started. */
+    bool run()
+    {
+        auto fixtures = options.workFolder.getChildFile ("fixtures");
+        int maxModules = 0;
+
+        for (auto n : options.moduleCounts)
+            maxModules = jmax (maxModules, n);
+
+        createFixtures (fixtures, maxModules);
+
+        network = new SimulatedNetwork (options.conditions, fixtures);
+        HttpServer server (*network);
+        server.setLogRequests (false);
+
+        int port = options.port;
+
+        while (! server.start (port))
+        {
+            if (++port >= options.port + 100)
+            {
+                printError ("could not find a free port from " + String (options.port));
+                return false;
+            }
+        }
+
+        printInfo ("simulated network on port " + String (port));
+
+        auto settingsFile = writeSettings (port);
+        setEnvironmentVariable ("JPM_SETTINGS", settingsFile.getFullPathName());
+        setEnvironmentVariable ("JPM_NO_DAEMON", "1");
+
+        auto originalDirectory = File::getCurrentWorkingDirectory();
+        auto cacheFolder = options.workFolder.getChildFile ("cache");
+
+        for (auto n : options.moduleCounts)
+        {
+            Result cold, warm;
+            cold.numModules = warm.numModules = n;
+            cold.mode = "cold";
+            warm.mode = "warm";
+
+            for (int i = 0; i < options.runs; ++i)
+            {
+                printInfo ("installing " + String (n) + " module(s), run " + String (i + 1) + " of " + String (options.runs));
+
+                cacheFolder.deleteRecursively();
+                timeInstall (cold, fixtures, i);
+                timeInstall (warm, fixtures, i);
+            }
+
+            results.add (cold);
+            results.add (warm);
+        }
+
+        originalDirectory.setAsCurrentWorkingDirectory();
+        server.stop();
+        return true;
+    }
+
+    void printTable() const
+    {
+        std::cout << String ("modules").paddedRight (' ', 9)
+                  << String ("cache").paddedRight (' ', 7)
+                  << String ("p50 ms").paddedLeft (' ', 10)
+                  << String ("p90 ms").paddedLeft (' ', 10)
+                  << String ("p99 ms").paddedLeft (' ', 10)
+                  << String ("failed").paddedLeft (' ', 8) << std::endl;
+
+        for (auto& r : results)
+        {
+            std::cout << String (r.numModules).paddedRight (' ', 9)
+                      << r.mode.paddedRight (' ', 7)
+                      << String (r.getPercentile (50), 0).paddedLeft (' ', 10)
+                      << String (r.getPercentile (90), 0).paddedLeft (' ', 10)
+                      << String (r.getPercentile (99), 0).paddedLeft (' ', 10)
+                      << String (r.failures).paddedLeft (' ', 8) << std::endl;
+        }
+
+        if (network != nullptr)
+            printInfo (String (network->getNumRequests()) + " requests served over " + String (network->getNumConnections())
+                       + " connections, " + String (network->getNumErrors()) + " failed and "
+                       + String (network->getNumDrops()) + " dropped on purpose");
+
+        printWarning (getCoverageNote());
+    }
+
+    String toJson() const
+    {
+        auto& c = options.conditions;
+
+        auto* conditions = new DynamicObject();
+        conditions->setProperty ("latency_ms", c.latencyMs);
+        conditions->setProperty ("handshake_ms", c.handshakeMs);
+        conditions->setProperty ("bytes_per_second", c.bytesPerSecond);
+        conditions->setProperty ("drop_rate", c.dropRate);
+        conditions->setProperty ("error_rate", c.errorRate);
+        conditions->setProperty ("seed", c.seed);
+
+        auto* shape = new DynamicObject();
+        shape->setProperty ("files", options.shape.numFiles);
+        shape->setProperty ("file_size", options.shape.fileSize);
+
+        auto* root = new DynamicObject();
+        root->setProperty ("schema", "jpm-bench-install");
+        root->setProperty ("schema_version", 1);
+        root->setProperty ("timestamp_ms", Time::currentTimeMillis());
+        root->setProperty ("os", SystemStats::getOperatingSystemName());
+        root->setProperty ("cpus", SystemStats::getNumCpus());
+        root->setProperty ("runs", options.runs);
+        root->setProperty ("conditions", var (conditions));
+        root->setProperty ("module_shape", var (shape));
+        root->setProperty ("transport", "http");
+        root->setProperty ("coverage_note", getCoverageNote());
+
+        if (network != nullptr)
+        {
+            root->setProperty ("requests", network->getNumRequests());
+            root->setProperty ("connections", network->getNumConnections());
+            root->setProperty ("errors_injected", network->getNumErrors());
+            root->setProperty ("drops_injected", network->getNumDrops());
+        }
+
+        Array<var> list;
+
+        for (auto& r : results)
+        {
+            auto* o = new DynamicObject();
+            o->setProperty ("modules", r.numModules);
+            o->setProperty ("cache", r.mode);
+            o->setProperty ("failures", r.failures);
+            o->setProperty ("p50_ms", r.getPercentile (50));
+            o->setProperty ("p90_ms", r.getPercentile (90));
+            o->setProperty ("p99_ms", r.getPercentile (99));
+            o->setProperty ("min_ms", r.getPercentile (0));
+            o->setProperty ("max_ms", r.getPercentile (100));
+
+            Array<var> samples;
+
+            for (auto s : r.samplesMs)
+                samples.add (s);
+
+            o->setProperty ("samples_ms", samples);
+            list.add (var (o));
+        }
+
+        root->setProperty ("results", list);
+        return JSON::toString (var (root));
+    }
+
+private:
+    static String getCoverageNote()
+    {
+        return "only plain http was simulated; the TLS handshakes and encryption that real https "
+               "adds on top of the same connections aren't covered by these numbers";
+    }
+
+    void createFixtures (const File& fixtures, int numModules)
+    {
+        printInfo ("generating " + String (numModules) + " module archives");
+
+        BenchmarkFixtures::createDirectory (fixtures.getChildFile ("directory.xml"), numModules, 1);
+        BenchmarkFixtures::createJucer (fixtures.getChildFile ("Bench.jucer"), 100, 2);
+
+        for (int m = 0; m < numModules; ++m)
+        {
+            auto name = BenchmarkFixtures::getModuleName (m);
+            BenchmarkFixtures::createTarGz (SimulatedNetwork::getArchive (fixtures, m, ".tar.gz"), options.shape, name);
+            BenchmarkFixtures::createZip (SimulatedNetwork::getArchive (fixtures, m, ".zip"), options.shape, name);
+        }
+    }
+
+    /** Mirrors are exclusive so a failure never falls back to the real GitHub. */
+    File writeSettings (int port)
+    {
+        auto base = "http://127.0.0.1:" + String (port) + "/";
+
+        XmlElement xml ("jpm_settings");
+        xml.setAttribute ("cacheFolder", "cache");
+        xml.createNewChildElement ("directory")->setAttribute ("url", base + "directory.xml");
+
+        auto* github = xml.createNewChildElement ("mirror");
+        github->setAttribute ("prefix", "https://www.github.com/");
+        github->setAttribute ("url", base + "github/");
+        github->setAttribute ("exclusive", 1);
+
+        auto* api = xml.createNewChildElement ("mirror");
+        api->setAttribute ("prefix", "https://api.github.com/");
+        api->setAttribute ("url", base + "api/");
+        api->setAttribute ("exclusive", 1);
+
+        auto file = options.workFolder.getChildFile ("jpm.settings.xml");
+        xml.writeToFile (file, String());
+        return file;
+    }
+
+    /** Installs result.numModules modules into a fresh project and adds the time taken. */
+    void timeInstall (Result& result, const File& fixtures, int run)
+    {
+        auto project = options.workFolder.getChildFile ("project");
+        project.deleteRecursively();
+        project.createDirectory();
+        fixtures.getChildFile ("Bench.jucer").copyFileTo (project.getChildFile ("Bench.jucer"));
+        project.setAsCurrentWorkingDirectory();
+
+        StringArray args;
+        args.add (options.jpmExecutable.getFullPathName());
+        args.add ("install");
+
+        for (int m = 0; m < result.numModules; ++m)
+            args.add (BenchmarkFixtures::getModuleName (m));
+
+        ChildProcess child;
+        const double start = Time::getMillisecondCounterHiRes();
+
+        if (! child.start (args))
+        {
+            printError ("could not run " + args[0]);
+            ++result.failures;
+            return;
+        }
+
+        /* Reading to the end also waits for it to exit. */
+        auto output = child.readAllProcessOutput();
+        result.samplesMs.add (Time::getMillisecondCounterHiRes() - start);
+
+        if (child.getExitCode() == 0 && isInstalled (project, result.numModules))
+            return;
+
+        ++result.failures;
+
+        auto log = options.workFolder.getChildFile ("failures").getChildFile (String (result.numModules) + "_" + result.mode
+                                                                               + "_" + String (run) + ".log");
+        log.getParentDirectory().createDirectory();
+        log.replaceWithText (output);
+        printWarning ("install failed, output in " + log.getFullPathName());
+    }
+
+    static bool isInstalled (const File& project, int numModules)
+    {
+        for (int m = 0; m < numModules; ++m)
+            if (! project.getChildFile ("jpm_modules").getChildFile (BenchmarkFixtures::getModuleName (m)).isDirectory())
+                return false;
+
+        return true;
+    }
+
+    /** Child processes inherit it. */
+    static void setEnvironmentVariable (const char* name, const String& value)
+    {
+       #if JUCE_WINDOWS
+        _putenv_s (name, value.toRawUTF8());
+       #else
+        setenv (name, value.toRawUTF8(), 1);
+       #endif
+    }
+
+    Options options;
+    ScopedPointer<SimulatedNetwork> network;
+    Array<Result> results;
+};
+
+#endif  // NETWORKBENCHMARK_H_INCLUDED
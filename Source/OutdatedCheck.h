@@ -0,0 +1,308 @@
+/*
+  ==============================================================================
+
+    OutdatedCheck.h
+    Created: 20 Oct 2026 9:14:37pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef OUTDATEDCHECK_H_INCLUDED
+#define OUTDATEDCHECK_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "Module.h"
+#include "Mirrors.h"
+#include "DownloadCache.h"
+#include "DependencyResolver.h"
+#include <iostream>
+#include <map>
+
+/**
+ * Compares a project's modules with what upstream has now - `jpm outdated`.
+ *
+ * Modules are grouped by repository and each repository is asked for its
+ * master commit and its tags, which is two https requests per repository.  Up
+ * to maxConcurrentRequests are in flight at once, with the transfer engine
+ * given as many extra helper threads while the check runs, so anything up to
+ * 16 repositories takes about one round trip and more take one per 16.  The
+ * requests are conditional on the ETag of the previous answer; a 304 reuses
+ * the copy kept in the download cache and doesn't count against GitHub's
+ * rate limit.
+ */
+class OutdatedCheck
+{
+public:
+    struct Row
+    {
+        String name;
+        String repo;
+        String path;
+        String current;
+        String locked;
+        String latestTag;
+        String masterCommit;
+        bool direct { true };
+        String error;
+
+        /** The version upstream is compared with; a transitive module only has the locked one. */
+        String getInstalled() const
+        {
+            return current.isNotEmpty() ? current : locked;
+        }
+
+        /** What this module would move to. */
+        String getLatest() const
+        {
+            return looksLikeTag (getInstalled()) && latestTag.isNotEmpty() ? latestTag : masterCommit;
+        }
+
+        String getStatus() const
+        {
+            if (error.isNotEmpty())
+                return error;
+
+            if (path.isEmpty())
+                return "local";
+
+            auto installed = getInstalled();
+
+            if (installed.isEmpty() || installed == "master")
+                return "tracks master";
+
+            if (looksLikeTag (installed) && latestTag.isNotEmpty())
+                return VersionConstraint::compare (latestTag, installed) > 0 ? "outdated" : "up to date";
+
+            return masterCommit.isEmpty() || masterCommit == installed ? "up to date" : "outdated";
+        }
+    };
+
+    /** The project's modules, and the resolved graph from its lockfile if there is one. */
+    OutdatedCheck (const Array<Module>& modules, const Array<DependencyResolver::Node>& locked)
+    {
+        for (auto m : modules)
+            addRow (m, true);
+
+        for (auto& n : locked)
+        {
+            auto* row = findRow (n.module.getName());
+
+            if (row == nullptr)
+                row = addRow (n.module, false);
+
+            row->locked = n.module.getVersion();
+        }
+    }
+
+    void run()
+    {
+        StringArray paths;
+
+        for (auto& r : rows)
+            if (r.path.isNotEmpty())
+                paths.addIfNotAlreadyThere (r.path);
+
+        printInfo ("checking " + String (rows.size()) + " modules in " + String (paths.size()) + " repositories");
+
+        struct Query
+        {
+            String path;
+            bool tags;
+            var reply;
+            String error;
+        };
+
+        Array<Query> queries;
+
+        for (auto& p : paths)
+        {
+            queries.add ({ p, false, var(), String() });
+            queries.add ({ p, true, var(), String() });
+        }
+
+        /* One thread per request; they spend their time waiting on the network.  Where
+         * https goes through the engine's helper threads, as on Windows, it needs as
+         * many of those too. */
+        const int numConcurrent = jmin (queries.size(), (int) maxConcurrentRequests);
+        TransferEngine::ExtraHelpers extraHelpers (TransferEngine::getInstance(), numConcurrent);
+
+        parallelFor (queries.size(), numConcurrent, [&] (int i)
+        {
+            auto& q = queries.getReference (i);
+            auto url = "https://api.github.com/repos/" + q.path + (q.tags ? "/tags?per_page=100" : "/commits/master");
+            q.reply = fetchJson (url, q.error);
+        });
+
+        for (auto& q : queries)
+        {
+            for (auto& r : rows)
+            {
+                if (r.path != q.path)
+                    continue;
+
+                if (q.error.isNotEmpty())
+                    r.error = q.error;
+                else if (q.tags)
+                    r.latestTag = getHighestTag (q.reply);
+                else
+                    r.masterCommit = q.reply.getProperty ("sha", String()).toString();
+            }
+        }
+    }
+
+    void printTable() const
+    {
+        std::cout << String ("module").paddedRight (' ', 32)
+                  << String ("current").paddedRight (' ', 12)
+                  << String ("locked").paddedRight (' ', 12)
+                  << String ("latest").paddedRight (' ', 12)
+                  << "status" << std::endl;
+
+        for (auto& r : rows)
+        {
+            auto name = r.direct ? r.name : r.name + " (dep)";
+
+            std::cout << name.paddedRight (' ', 32)
+                      << shorten (r.current).paddedRight (' ', 12)
+                      << shorten (r.locked).paddedRight (' ', 12)
+                      << shorten (r.getLatest()).paddedRight (' ', 12)
+                      << r.getStatus() << std::endl;
+        }
+    }
+
+    String toJson() const
+    {
+        Array<var> modules;
+
+        for (auto& r : rows)
+        {
+            auto* o = new DynamicObject();
+            o->setProperty ("name", r.name);
+            o->setProperty ("repo", r.repo);
+            o->setProperty ("path", r.path);
+            o->setProperty ("direct", r.direct);
+            o->setProperty ("current", r.current);
+            o->setProperty ("locked", r.locked);
+            o->setProperty ("latest", r.getLatest());
+            o->setProperty ("latest_tag", r.latestTag);
+            o->setProperty ("master", r.masterCommit);
+            o->setProperty ("status", r.getStatus());
+            modules.add (var (o));
+        }
+
+        return JSON::toString (var (modules));
+    }
+
+    int getNumOutdated() const
+    {
+        int n = 0;
+
+        for (auto& r : rows)
+            if (r.getStatus() == "outdated")
+                ++n;
+
+        return n;
+    }
+
+    static const int maxConcurrentRequests = 32;
+
+private:
+    Row* addRow (Module m, bool direct)
+    {
+        Row r;
+        r.name = m.getName();
+        r.repo = m.getRepo();
+        r.current = direct ? m.getVersion() : String();
+        r.direct = direct;
+
+        if (m.getSource() == "GitHub")
+            r.path = trimSlashes (m.getPath());
+
+        rows.add (r);
+        return &rows.getReference (rows.size() - 1);
+    }
+
+    Row* findRow (const String& name)
+    {
+        for (auto& r : rows)
+            if (r.name == name)
+                return &r;
+
+        return nullptr;
+    }
+
+    /** A conditional GET, answered from the download cache on a 304. */
+    var fetchJson (const String& url, String& error)
+    {
+        auto cached = cache.getCachedFileLocation (URL (url));
+        auto etagFile = cached.withFileExtension ("etag");
+
+        String headers;
+
+        if (cached.existsAsFile() && etagFile.existsAsFile())
+            headers = "If-None-Match: " + etagFile.loadFileAsString().trim();
+
+        auto result = Mirrors::getInstance().fetch (url, headers, nullptr, [] (const TransferResult& r)
+        {
+            return r.succeeded() || r.statusCode == 304;
+        });
+
+        if (result.statusCode == 304)
+            return JSON::parse (cached.loadFileAsString());
+
+        if (! result.succeeded())
+        {
+            error = result.getFailureReason();
+            return var();
+        }
+
+        cached.replaceWithData (result.body.getData(), result.body.getSize());
+
+        auto etag = result.headers.getValue ("ETag", String());
+
+        if (etag.isNotEmpty())
+            etagFile.replaceWithText (etag);
+        else
+            etagFile.deleteFile();
+
+        return JSON::parse (result.getBodyAsString());
+    }
+
+    /** The highest version-like tag; GitHub doesn't list them in version order. */
+    static String getHighestTag (const var& tags)
+    {
+        String best;
+
+        if (auto* list = tags.getArray())
+        {
+            for (auto& t : *list)
+            {
+                auto name = t.getProperty ("name", String()).toString();
+
+                if (looksLikeTag (name) && (best.isEmpty() || VersionConstraint::compare (name, best) > 0))
+                    best = name;
+            }
+        }
+
+        return best;
+    }
+
+    static bool looksLikeTag (const String& version)
+    {
+        auto v = version.startsWithIgnoreCase ("v") ? version.substring (1) : version;
+        return v.isNotEmpty() && CharacterFunctions::isDigit (v[0]) && v.length() < 40;
+    }
+
+    /** Commit hashes are cut down to something that fits a column. */
+    static String shorten (const String& version)
+    {
+        return version.length() == 40 && version.containsOnly ("0123456789abcdef") ? version.substring (0, 7) : version;
+    }
+
+    DownloadCache cache;
+    Array<Row> rows;
+};
+
+#endif  // OUTDATEDCHECK_H_INCLUDED
@@ -0,0 +1,264 @@
+/*
+  ==============================================================================
+
+    Progress.h
+    Created: 21 Oct 2026 8:41:55pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef PROGRESS_H_INCLUDED
+#define PROGRESS_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "TransferEngine.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if JUCE_WINDOWS
+ #include <io.h>
+#else
+ #include <unistd.h>
+#endif
+
+/**
+ * One progress line for all the downloads in flight.
+ *
+ * Transfers are handed over with track() and the rest happens on a thread of
+ * its own, which reads the counters the engine already keeps for each
+ * transfer.  Nothing is added to the transfer loops and they never wait on
+ * the terminal.
+ *
+ * On a terminal the line is redrawn ten times a second, and messages printed
+ * meanwhile blank it first.  When output is redirected, to a CI log say, a
+ * summary line is printed every few seconds instead, and once more at the
+ * end, so downloads shorter than that print nothing.
+ */
+class Progress
+{
+public:
+    static Progress& getInstance()
+    {
+        static Progress progress;
+        return progress;
+    }
+
+    ~Progress()
+    {
+        {
+            std::lock_guard<std::mutex> lock (entriesLock);
+            stopping = true;
+        }
+
+        wakeup.notify_all();
+
+        if (drawThread.joinable())
+            drawThread.join();
+    }
+
+    /** Shows the transfer until it finishes.  alreadyHave is anything fetched earlier, e.g. before a resume. */
+    void track (const std::shared_ptr<Transfer>& transfer, int64 alreadyHave = 0)
+    {
+        std::lock_guard<std::mutex> lock (entriesLock);
+        Entry e = { transfer, alreadyHave };
+        entries.push_back (e);
+
+        if (running)
+            return;
+
+        /* The last batch's thread has finished with the lock, so this can't deadlock. */
+        if (drawThread.joinable())
+            drawThread.join();
+
+        batch = Batch();
+        batch.startMs = Time::getMillisecondCounterHiRes();
+        running = true;
+        drawThread = std::thread ([this] { run(); });
+    }
+
+    /** Overrides the terminal check, for when output isn't going to this process's own stdout. */
+    void setInteractive (bool shouldRedraw)
+    {
+        interactive = shouldRedraw ? 1 : 0;
+    }
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<Transfer> transfer;
+        int64 alreadyHave;
+    };
+
+    /** Totals since the line last went idle. */
+    struct Batch
+    {
+        double startMs { 0.0 };
+        int numFinished { 0 };
+        int64 finishedBytes { 0 };
+        int64 finishedReceived { 0 };
+        bool summarised { false };
+    };
+
+    void run()
+    {
+        const bool redraw = isInteractive();
+        const std::chrono::milliseconds interval (redraw ? 100 : 500);
+        double lastSummaryMs = Time::getMillisecondCounterHiRes();
+        double lastSampleMs = lastSummaryMs;
+        int64 lastReceived = 0;
+        double bytesPerSecond = 0.0;
+
+        for (;;)
+        {
+            Batch b;
+            int numActive = 0;
+            int64 done = 0, total = 0, received = 0;
+
+            {
+                std::unique_lock<std::mutex> lock (entriesLock);
+                wakeup.wait_for (lock, interval, [this] { return stopping; });
+
+                bool totalKnown = true;
+
+                for (auto i = entries.begin(); i != entries.end();)
+                {
+                    auto& t = *i->transfer;
+                    const int64 got = t.getBytesReceived();
+
+                    if (t.isFinished())
+                    {
+                        ++batch.numFinished;
+                        batch.finishedBytes += i->alreadyHave + got;
+                        batch.finishedReceived += got;
+                        i = entries.erase (i);
+                        continue;
+                    }
+
+                    const int64 length = t.getTotalLength();
+                    totalKnown = totalKnown && length >= 0;
+                    done += i->alreadyHave + got;
+                    total += i->alreadyHave + length;
+                    received += got;
+                    ++numActive;
+                    ++i;
+                }
+
+                b = batch;
+
+                if (entries.empty() || stopping)
+                {
+                    running = false;
+                    lock.unlock();
+                    finishBatch (redraw, b);
+                    return;
+                }
+
+                if (! totalKnown)
+                    total = -1;
+            }
+
+            const double now = Time::getMillisecondCounterHiRes();
+            received += b.finishedReceived;
+
+            if (now - lastSampleMs >= 500.0)
+            {
+                const double rate = (received - lastReceived) * 1000.0 / (now - lastSampleMs);
+                bytesPerSecond = bytesPerSecond > 0.0 ? bytesPerSecond * 0.7 + rate * 0.3 : rate;
+                lastReceived = received;
+                lastSampleMs = now;
+            }
+
+            auto line = describe (b.numFinished, b.numFinished + numActive, b.finishedBytes + done,
+                                  total >= 0 ? b.finishedBytes + total : -1, bytesPerSecond);
+
+            if (redraw)
+            {
+                drawLine (line);
+            }
+            else if (now - lastSummaryMs >= summaryIntervalMs)
+            {
+                printInfo (line);
+                lastSummaryMs = now;
+
+                std::lock_guard<std::mutex> lock (entriesLock);
+                batch.summarised = true;
+            }
+        }
+    }
+
+    static String describe (int numFinished, int numStarted, int64 done, int64 total, double bytesPerSecond)
+    {
+        String line;
+        line << "downloading " << numFinished << "/" << numStarted << " ... " << formatBytes (done);
+
+        if (total >= 0)
+            line << " of " << formatBytes (total);
+
+        if (bytesPerSecond > 0.0)
+            line << " at " << formatBytes ((int64) bytesPerSecond) << "/s";
+
+        return line;
+    }
+
+    void finishBatch (bool redraw, const Batch& b)
+    {
+        if (redraw)
+        {
+            clearProgressLine();
+        }
+        else if (b.summarised)
+        {
+            const double seconds = (Time::getMillisecondCounterHiRes() - b.startMs) / 1000.0;
+            printInfo ("downloaded " + String (b.numFinished) + " file(s), " + formatBytes (b.finishedBytes)
+                       + " in " + String (seconds, 1) + "s");
+        }
+    }
+
+    /** Writes over the previous line, padding out whatever it had beyond this one. */
+    static void drawLine (const String& text)
+    {
+        auto line = "jpm      : " + text;
+
+        std::lock_guard<std::recursive_mutex> lock (outputLock());
+        const int previous = progressLineWidth().exchange (line.length());
+
+        *messageStream() << '\r' << line.paddedRight (' ', previous) << std::flush;
+    }
+
+    bool isInteractive() const
+    {
+        if (interactive >= 0)
+            return interactive == 1;
+
+        FILE* out = messageStream() == &std::cerr ? stderr : stdout;
+
+       #if JUCE_WINDOWS
+        return _isatty (_fileno (out)) != 0;
+       #else
+        return isatty (fileno (out)) != 0;
+       #endif
+    }
+
+    static const int summaryIntervalMs = 5000;
+
+    std::mutex entriesLock;
+    std::condition_variable wakeup;
+    std::vector<Entry> entries;
+    Batch batch;
+    bool running { false };
+    bool stopping { false };
+    std::thread drawThread;
+
+    /* -1 until set, meaning check the terminal. */
+    std::atomic<int> interactive { -1 };
+};
+
+#endif  // PROGRESS_H_INCLUDED
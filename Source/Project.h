@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+
+    Project.h
+    Created: 21 Oct 2026 11:05:40am
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef PROJECT_H_INCLUDED
+#define PROJECT_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "ConfigFile.h"
+#include "JucerFile.h"
+#include "Lockfile.h"
+#include "DependencyResolver.h"
+
+/**
+ * One JUCE project managed by jpm: the folder holding its jpmfile.xml,
+ * jpmfile.lock, jucer file and jpm_modules.  The jucer and config are saved
+ * when it is destroyed.
+ */
+class Project
+{
+public:
+    Project (const File& root_)
+        :
+        root (root_),
+        config (root_.getChildFile ("jpmfile.xml"))
+    {
+        hasJucer = jucer.setFile (root);
+    }
+
+    ~Project()
+    {
+        if (hasJucer)
+            jucer.save();
+    }
+
+    File getRoot() const
+    {
+        return root;
+    }
+
+    File getModulesFolder() const
+    {
+        return root.getChildFile ("jpm_modules");
+    }
+
+    File getLockFile() const
+    {
+        return root.getChildFile ("jpmfile.lock");
+    }
+
+    ConfigFile& getConfig()
+    {
+        return config;
+    }
+
+    /** Update the jucer file with the latest list of modules. */
+    void rebuildJucerModuleList()
+    {
+        if (! hasJucer)
+        {
+            printWarning ("no jucer file in " + root.getFullPathName() + ", not updated");
+            return;
+        }
+
+        jucer.clearModules();
+
+        auto allModules = config.getModules();
+
+        for (auto m : allModules)
+            addModuleToJucer (m);
+
+        /* Modules needed by the ones above. */
+        for (auto m : Lockfile (getLockFile()).getDependencyModules())
+            addModuleToJucer (m);
+    }
+
+    /**
+     * Works out every module the project needs.  The dependency graph comes
+     * from jpmfile.lock when jpmfile.xml hasn't changed since it was written,
+     * otherwise it is resolved again and the lock rewritten.
+     */
+    Result resolve (DependencyResolver& resolver)
+    {
+        auto allModules = config.getModules();
+        Lockfile lockfile (getLockFile());
+
+        if (lockfile.isCurrentFor (allModules))
+        {
+            printInfo ("using dependencies from " + getLockFile().getFullPathName());
+            return resolver.setNodes (lockfile.getNodes());
+        }
+
+        auto result = resolver.resolve (allModules);
+
+        if (result.wasOk())
+            lockfile.store (allModules, resolver.getNodes());
+
+        return result;
+    }
+
+    /** Installs any modules, and anything they depend on, that are missing from jpm_modules. */
+    void installMissingModules (DependencyResolver::Lookup lookup)
+    {
+        DependencyResolver resolver (getModulesFolder(), lookup);
+        auto result = resolve (resolver);
+
+        if (result.wasOk())
+            result = resolver.install();
+
+        if (result.failed())
+            printError (result.getErrorMessage());
+
+        rebuildJucerModuleList();
+    }
+
+private:
+    void addModuleToJucer (Module module)
+    {
+        if (module.getSource() == "LocalPath")
+            jucer.addModule (module.getName(), module.getPath());
+        else
+            jucer.addModule (module.getName());
+    }
+
+    File root;
+    ConfigFile config;
+    JucerFile jucer;
+    bool hasJucer { false };
+
+    JUCE_DECLARE_NON_COPYABLE (Project)
+};
+
+#endif  // PROJECT_H_INCLUDED
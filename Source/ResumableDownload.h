@@ -0,0 +1,505 @@
+/*
+  ==============================================================================
+
+    ResumableDownload.h
+    Created: 19 Oct 2026 4:52:30pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef RESUMABLEDOWNLOAD_H_INCLUDED
+#define RESUMABLEDOWNLOAD_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "TransferEngine.h"
+#include "Progress.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Downloads a URL to a file in a way that survives interruptions.
+ *
+ * Data is written to <destination>.download as it arrives, with the server's
+ * validator (ETag or Last-Modified) kept alongside in <destination>.download.xml.
+ * An interrupted download - in this run or a previous one - continues with a
+ * Range request guarded by If-Range, so a file that changed upstream is
+ * fetched again from the start instead of being spliced.
+ *
+ * A fresh download is a single GET.  If its headers show a large file from
+ * a server that takes ranges, the rest of the file is fetched as concurrent
+ * ranges alongside it and the GET stops where the second range starts.
+ * Each range has its own part file; they resume independently and are
+ * joined at the end.
+ */
+class ResumableDownload
+{
+public:
+    ResumableDownload (const URL& url_, const File& destination_)
+        :
+        url (url_),
+        destination (destination_),
+        stateFile (destination_.getSiblingFile (destination_.getFileName() + ".download.xml"))
+    {}
+
+    /** Returns true once the destination holds the complete file. */
+    bool run (int maxAttempts = 5)
+    {
+        for (int attempt = 1; attempt <= maxAttempts; ++attempt)
+        {
+            if (attempt > 1)
+                printWarning ("download interrupted, resuming (attempt " + String (attempt) + " of " + String (maxAttempts) + ")");
+
+            const int64 before = getBytesOnDisk();
+
+            if (attemptDownload())
+                return true;
+
+            /* Retrying without progress won't help - probably a 404 or a dead host. */
+            if (getBytesOnDisk() == before)
+                return false;
+        }
+
+        return false;
+    }
+
+    int64 getBytesDownloaded() const
+    {
+        return bytesDownloaded;
+    }
+
+    /** Removes any partial data and state. */
+    void discard()
+    {
+        for (int i = 0; i < maxParts; ++i)
+            getPartFile (i).deleteFile();
+
+        getJoinFile().deleteFile();
+        stateFile.deleteFile();
+    }
+
+    /** What to send in If-Range to resume a reply with these headers, or an empty string if it can't be. */
+    static String getValidator (const StringPairArray& headers)
+    {
+        auto etag = headers["ETag"];
+
+        /* Weak ETags aren't allowed in If-Range. */
+        if (etag.isNotEmpty() && ! etag.startsWith ("W/"))
+            return etag;
+
+        return headers["Last-Modified"];
+    }
+
+    static const int64 parallelThreshold = 8 * 1024 * 1024;
+    static const int maxParts = 4;
+
+private:
+    struct State
+    {
+        int64 totalLength { -1 };
+        String validator;
+        int numParts { 1 };
+    };
+
+    bool attemptDownload()
+    {
+        loadState();
+
+        if (state.numParts > 1)
+            return downloadParts (nullptr);
+
+        return downloadSingle();
+    }
+
+    /** What the first reply said, passed back from the engine's thread. */
+    struct FirstResponse
+    {
+        WaitableEvent arrived;
+        int statusCode { 0 };
+        StringPairArray headers;
+        int64 partSize { -1 };
+    };
+
+    bool downloadSingle()
+    {
+        auto partial = getPartFile (0);
+        const int64 have = partial.existsAsFile() ? partial.getSize() : 0;
+        const bool canSplit = have == 0 && ! rangesRefused;
+
+        TransferRequest request (url);
+        request.destination = partial;
+
+        if (have > 0)
+        {
+            request.appendToDestination = true;
+            request.extraHeaders = getRangeHeaders (have, -1);
+        }
+
+        /* The length, validator and range support come from the reply itself,
+         * so there's no separate probe.  Splitting stops this transfer at the
+         * end of part 0. */
+        auto response = std::make_shared<FirstResponse>();
+
+        request.onResponse = [response, canSplit] (int statusCode, const StringPairArray& headers) -> int64
+        {
+            response->statusCode = statusCode;
+            response->headers = headers;
+
+            if (canSplit && statusCode == 200)
+                response->partSize = getSplitPartSize (headers);
+
+            response->arrived.signal();
+            return response->partSize;
+        };
+
+        request.onComplete = [response] (const TransferResult&) { response->arrived.signal(); };
+
+        auto transfer = TransferEngine::getInstance().start (request);
+        response->arrived.wait();
+
+        /* Saved now, so an interruption from here on resumes with If-Range. */
+        noteResponse (response->statusCode, response->headers);
+
+        if (response->partSize > 0)
+        {
+            state.numParts = maxParts;
+            saveState();
+            return downloadParts (transfer);
+        }
+
+        Array<std::shared_ptr<Transfer>> transfers;
+        transfers.add (transfer);
+        waitForAll (transfers, have);
+
+        auto result = transfer->wait();
+        noteResponse (result.statusCode, result.headers);
+
+        /* Asked for a range beyond the end, so what we have is already complete. */
+        if (result.statusCode == 416 && state.totalLength == have)
+            return finish();
+
+        if (! result.succeeded())
+        {
+            if (result.statusCode / 100 == 4)
+                discard();
+
+            return false;
+        }
+
+        return finish();
+    }
+
+    /** The part transfers, so the first to find its range ignored can stop the rest. */
+    struct PartGroup
+    {
+        std::mutex lock;
+        std::vector<std::weak_ptr<Transfer>> transfers;
+        bool rangeIgnored { false };
+    };
+
+    /**
+     * Fetches the parts that aren't complete yet.  first, if given, is a
+     * fresh download's GET, already under way and limited to part 0.
+     */
+    bool downloadParts (std::shared_ptr<Transfer> first)
+    {
+        const int64 partSize = getPartSize (state.totalLength, state.numParts);
+        Array<std::shared_ptr<Transfer>> transfers;
+        auto group = std::make_shared<PartGroup>();
+        int64 have = 0;
+
+        /* A join that stopped after its rename left the whole file in part 0. */
+        if (first == nullptr && getPartFile (0).existsAsFile() && getPartFile (0).getSize() == state.totalLength)
+            return finishJoin() && finish();
+
+        if (first != nullptr)
+        {
+            transfers.add (first);
+            group->transfers.push_back (first);
+        }
+
+        for (int i = first != nullptr ? 1 : 0; i < state.numParts; ++i)
+        {
+            const int64 start = i * partSize;
+            const int64 end = jmin (state.totalLength, start + partSize);
+            auto file = getPartFile (i);
+            const int64 partHave = file.existsAsFile() ? file.getSize() : 0;
+
+            /* Can't be spliced, so start again rather than failing the same way every time. */
+            if (partHave > end - start)
+            {
+                printWarning ("part " + String (i) + " of " + destination.getFileName() + " is too long, starting again");
+                discard();
+                state = State();
+                return downloadSingle();
+            }
+
+            have += partHave;
+
+            if (partHave >= end - start)
+                continue;
+
+            TransferRequest request (url);
+            request.destination = file;
+            request.appendToDestination = partHave > 0;
+            request.extraHeaders = getRangeHeaders (start + partHave, end - 1);
+
+            /* A 200 is the whole file, which every part would otherwise fetch in full. */
+            request.onResponse = [group] (int statusCode, const StringPairArray&) -> int64
+            {
+                if (statusCode != 200)
+                    return -1;
+
+                std::lock_guard<std::mutex> lock (group->lock);
+                group->rangeIgnored = true;
+
+                for (auto& w : group->transfers)
+                    if (auto sibling = w.lock())
+                        sibling->cancel();
+
+                return 0;
+            };
+
+            auto transfer = TransferEngine::getInstance().start (request);
+            transfers.add (transfer);
+
+            std::lock_guard<std::mutex> lock (group->lock);
+            group->transfers.push_back (transfer);
+
+            if (group->rangeIgnored)
+                transfer->cancel();
+        }
+
+        waitForAll (transfers, have);
+
+        for (auto& t : transfers)
+        {
+            auto result = t->wait();
+
+            /* The server has stopped honouring ranges or the file changed;
+             * either way the parts can't be trusted, so start again as one
+             * stream.  Part 0's own GET is the one reply that should be a 200. */
+            if (group->rangeIgnored || (result.statusCode == 200 && t != first))
+            {
+                const int64 totalLength = state.totalLength;
+                rangesRefused = true;
+                discard();
+                state = State();
+                state.totalLength = totalLength;
+                saveState();
+                return downloadSingle();
+            }
+
+            if (! result.succeeded())
+                return false;
+        }
+
+        for (int i = 0; i < state.numParts; ++i)
+        {
+            const int64 start = i * partSize;
+            const int64 expected = jmin (state.totalLength, start + partSize) - start;
+
+            if (getPartFile (i).getSize() != expected)
+                return false;
+        }
+
+        return joinParts() && finish();
+    }
+
+    /**
+     * Joins the parts in a separate file, which then replaces part 0, so an
+     * interruption at any point leaves either the parts or the whole file.
+     */
+    bool joinParts()
+    {
+        auto joined = getJoinFile();
+        joined.deleteFile();
+
+        {
+            FileOutputStream out (joined);
+
+            if (out.failedToOpen())
+                return false;
+
+            for (int i = 0; i < state.numParts; ++i)
+            {
+                FileInputStream in (getPartFile (i));
+
+                if (in.failedToOpen() || out.writeFromInputStream (in, -1) != in.getTotalLength())
+                    return false;
+            }
+
+            out.flush();
+
+            if (out.getStatus().failed())
+                return false;
+        }
+
+        return joined.moveFileTo (getPartFile (0)) && finishJoin();
+    }
+
+    /** Tidies up once part 0 holds the whole file. */
+    bool finishJoin()
+    {
+        for (int i = 1; i < maxParts; ++i)
+            getPartFile (i).deleteFile();
+
+        state.numParts = 1;
+        saveState();
+        return true;
+    }
+
+    bool finish()
+    {
+        auto partial = getPartFile (0);
+
+        /* Short is a transfer that stopped early, which the next attempt
+         * continues; too long can't be trusted. */
+        if (state.totalLength >= 0 && partial.getSize() < state.totalLength)
+            return false;
+
+        if (state.totalLength >= 0 && partial.getSize() > state.totalLength)
+        {
+            printWarning ("downloaded more than expected, discarding " + partial.getFileName());
+            discard();
+            return false;
+        }
+
+        destination.deleteFile();
+
+        if (! partial.moveFileTo (destination))
+            return false;
+
+        stateFile.deleteFile();
+        return true;
+    }
+
+    /** Puts the transfers on the progress line and blocks until they've all finished. */
+    void waitForAll (const Array<std::shared_ptr<Transfer>>& transfers, int64 alreadyHave)
+    {
+        for (int i = 0; i < transfers.size(); ++i)
+            Progress::getInstance().track (transfers[i], i == 0 ? alreadyHave : 0);
+
+        int64 received = 0;
+
+        for (auto& t : transfers)
+        {
+            t->wait();
+            received += t->getBytesReceived();
+        }
+
+        bytesDownloaded = received;
+    }
+
+    /** Remembers the length and validator from a 200 or 206, so an interruption can resume. */
+    void noteResponse (int statusCode, const StringPairArray& headers)
+    {
+        if (statusCode != 200 && statusCode != 206)
+            return;
+
+        /* A full reply means we started over, possibly on a changed file. */
+        if (statusCode == 200)
+            state.totalLength = headers["Content-Length"].isNotEmpty() ? headers["Content-Length"].getLargeIntValue() : -1;
+
+        auto validator = getValidator (headers);
+
+        if (validator.isNotEmpty())
+            state.validator = validator;
+
+        saveState();
+    }
+
+    /**
+     * Whether a full reply is worth splitting: a large file from a server that
+     * says it takes ranges and gives a validator to guard them with.  Returns
+     * the size of each part, or -1 to keep it as one stream.
+     */
+    static int64 getSplitPartSize (const StringPairArray& headers)
+    {
+        if (headers["Content-Length"].isEmpty() || ! headers["Accept-Ranges"].containsIgnoreCase ("bytes")
+            || getValidator (headers).isEmpty())
+            return -1;
+
+        const int64 totalLength = headers["Content-Length"].getLargeIntValue();
+        return totalLength >= parallelThreshold ? getPartSize (totalLength, maxParts) : -1;
+    }
+
+    static int64 getPartSize (int64 totalLength, int numParts)
+    {
+        return (totalLength + numParts - 1) / numParts;
+    }
+
+    String getRangeHeaders (int64 from, int64 to) const
+    {
+        String headers = "Range: bytes=" + String (from) + "-" + (to >= 0 ? String (to) : String());
+
+        if (state.validator.isNotEmpty())
+            headers << "\nIf-Range: " << state.validator;
+
+        return headers;
+    }
+
+    File getPartFile (int index) const
+    {
+        return destination.getSiblingFile (destination.getFileName() + ".download"
+                                           + (index > 0 ? "." + String (index) : String()));
+    }
+
+    File getJoinFile() const
+    {
+        return destination.getSiblingFile (destination.getFileName() + ".download.joined");
+    }
+
+    int64 getBytesOnDisk() const
+    {
+        int64 total = 0;
+
+        for (int i = 0; i < maxParts; ++i)
+            if (getPartFile (i).existsAsFile())
+                total += getPartFile (i).getSize();
+
+        return total;
+    }
+
+    void loadState()
+    {
+        state = State();
+        ScopedPointer<XmlElement> xml = XmlDocument (stateFile).getDocumentElement();
+
+        if (xml == nullptr)
+            return;
+
+        /* Left by a download from another mirror, which may not have served
+         * exactly the same bytes, so don't splice onto it. */
+        if (xml->getStringAttribute ("url") != url.toString (true))
+        {
+            discard();
+            return;
+        }
+
+        state.totalLength = xml->getStringAttribute ("total", "-1").getLargeIntValue();
+        state.validator = xml->getStringAttribute ("validator");
+        state.numParts = jlimit (1, (int) maxParts, xml->getIntAttribute ("parts", 1));
+    }
+
+    void saveState()
+    {
+        XmlElement xml ("download");
+        xml.setAttribute ("url", url.toString (true));
+        xml.setAttribute ("total", String (state.totalLength));
+        xml.setAttribute ("validator", state.validator);
+        xml.setAttribute ("parts", state.numParts);
+        xml.writeToFile (stateFile, String());
+    }
+
+    URL url;
+    File destination;
+    File stateFile;
+    State state;
+    int64 bytesDownloaded { 0 };
+    bool rangesRefused { false };
+};
+
+#endif  // RESUMABLEDOWNLOAD_H_INCLUDED
@@ -0,0 +1,324 @@
+/*
+  ==============================================================================
+
+    RunReport.h
+    Created: 21 Oct 2026 5:02:14pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef RUNREPORT_H_INCLUDED
+#define RUNREPORT_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#if JUCE_MAC || JUCE_LINUX
+ #include <sys/resource.h>
+ #include <time.h>
+#endif
+
+/**
+ * A machine readable summary of one jpm run - `--report=<file.json>`.
+ *
+ * The file is a single JSON object.  Fields are only ever added to this
+ * schema; anything that changes meaning gets a new schema_version.
+ *
+ *   schema            "jpm-run-report"
+ *   schema_version    1
+ *   command           e.g. "install"
+ *   arguments         the rest of the command line
+ *   exit_code         0 on success
+ *   started_ms        start time, milliseconds since 1970 UTC
+ *   wall_seconds      whole run
+ *   cpu_seconds       user + system time of the whole run
+ *   peak_rss_bytes    peak resident set size of the process, 0 if unknown;
+ *                     under the daemon this is the daemon's peak so far
+ *   phases            [ { name, count, wall_seconds, cpu_seconds } ] in the
+ *                     order they first finished.  Phases nest and run in
+ *                     parallel, so their wall times overlap; cpu_seconds is
+ *                     the CPU time of the thread that ran each instance,
+ *                     which leaves out work it handed to other threads such
+ *                     as the transfer engine's.
+ *   bytes_downloaded  bytes received from the network
+ *   bytes_extracted   bytes written by unpacking archives
+ *   bytes_copied      bytes copied into jpm_modules
+ *   files_written     files created by extracting, copying and saving
+ *   requests          [ { host, count, failed, bytes } ] by host
+ *
+ * Counting is a few atomic increments, so it's always on; only phase
+ * timing and the per host table check whether a report was asked for.
+ */
+class RunReport
+{
+public:
+    static RunReport& getInstance()
+    {
+        static RunReport report;
+        return report;
+    }
+
+    static bool isEnabled()
+    {
+        return getEnabledFlag().load (std::memory_order_relaxed);
+    }
+
+    /** Starts a new report, forgetting anything counted before. */
+    void start()
+    {
+        std::lock_guard<std::mutex> lock (tablesLock);
+        phases.clear();
+        hosts.clear();
+        bytesDownloaded = 0;
+        bytesExtracted = 0;
+        bytesCopied = 0;
+        filesWritten = 0;
+        startTime = Time::currentTimeMillis();
+        startWall = Time::getMillisecondCounterHiRes();
+        startCpu = getCpuSeconds();
+        getEnabledFlag() = true;
+    }
+
+    /** Stops counting and writes the report for commandLine, which starts with jpm and the command. */
+    bool finish (const File& output, const StringArray& commandLine, int exitCode)
+    {
+        getEnabledFlag() = false;
+        std::lock_guard<std::mutex> lock (tablesLock);
+
+        auto* root = new DynamicObject();
+        var report (root);
+
+        root->setProperty ("schema", "jpm-run-report");
+        root->setProperty ("schema_version", 1);
+        root->setProperty ("command", commandLine[1]);
+
+        Array<var> arguments;
+
+        for (int i = 2; i < commandLine.size(); ++i)
+            arguments.add (commandLine[i]);
+
+        root->setProperty ("arguments", arguments);
+        root->setProperty ("exit_code", exitCode);
+        root->setProperty ("started_ms", startTime);
+        root->setProperty ("wall_seconds", (Time::getMillisecondCounterHiRes() - startWall) / 1000.0);
+        root->setProperty ("cpu_seconds", getCpuSeconds() - startCpu);
+        root->setProperty ("peak_rss_bytes", getPeakResidentBytes());
+
+        Array<var> phaseList;
+
+        for (auto& p : phases)
+        {
+            auto* o = new DynamicObject();
+            o->setProperty ("name", p.name);
+            o->setProperty ("count", p.count);
+            o->setProperty ("wall_seconds", p.wallSeconds);
+            o->setProperty ("cpu_seconds", p.cpuSeconds);
+            phaseList.add (var (o));
+        }
+
+        root->setProperty ("phases", phaseList);
+        root->setProperty ("bytes_downloaded", bytesDownloaded.load());
+        root->setProperty ("bytes_extracted", bytesExtracted.load());
+        root->setProperty ("bytes_copied", bytesCopied.load());
+        root->setProperty ("files_written", filesWritten.load());
+
+        Array<var> requestList;
+
+        for (auto& h : hosts)
+        {
+            auto* o = new DynamicObject();
+            o->setProperty ("host", h.first);
+            o->setProperty ("count", h.second.count);
+            o->setProperty ("failed", h.second.failed);
+            o->setProperty ("bytes", h.second.bytes);
+            requestList.add (var (o));
+        }
+
+        root->setProperty ("requests", requestList);
+
+        return output.replaceWithText (JSON::toString (report));
+    }
+
+    /** Called once per network request as it completes. */
+    void addRequest (const String& host, int64 bytes, bool succeeded)
+    {
+        bytesDownloaded += bytes;
+
+        if (! isEnabled())
+            return;
+
+        std::lock_guard<std::mutex> lock (tablesLock);
+        auto& h = hosts[host];
+        ++h.count;
+        h.bytes += bytes;
+
+        if (! succeeded)
+            ++h.failed;
+    }
+
+    void addExtracted (int numFiles, int64 numBytes)
+    {
+        filesWritten += numFiles;
+        bytesExtracted += numBytes;
+    }
+
+    void addCopied (int numFiles, int64 numBytes)
+    {
+        filesWritten += numFiles;
+        bytesCopied += numBytes;
+    }
+
+    void addFileWritten()
+    {
+        ++filesWritten;
+    }
+
+    /**
+     * Times the code between its construction and destruction as a phase of
+     * the run.  Phases with the same name are added together.
+     */
+    class Phase
+    {
+    public:
+        Phase (const char* name_)
+            :
+            active (RunReport::isEnabled())
+        {
+            if (active)
+            {
+                name = name_;
+                startWall = Time::getMillisecondCounterHiRes();
+                startCpu = getThreadCpuSeconds();
+            }
+        }
+
+        ~Phase()
+        {
+            if (active)
+                RunReport::getInstance().addPhase (name, (Time::getMillisecondCounterHiRes() - startWall) / 1000.0,
+                                                   getThreadCpuSeconds() - startCpu);
+        }
+
+    private:
+        bool active;
+        const char* name { nullptr };
+        double startWall { 0.0 };
+        double startCpu { 0.0 };
+
+        JUCE_DECLARE_NON_COPYABLE (Phase)
+    };
+
+    /** User plus system time used by the process so far. */
+    static double getCpuSeconds()
+    {
+#if JUCE_MAC || JUCE_LINUX
+        struct rusage usage;
+
+        if (getrusage (RUSAGE_SELF, &usage) != 0)
+            return 0.0;
+
+        return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1.0e6
+               + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1.0e6;
+#else
+        return 0.0;
+#endif
+    }
+
+    /** CPU time used by the calling thread so far. */
+    static double getThreadCpuSeconds()
+    {
+#if JUCE_MAC || JUCE_LINUX
+        struct timespec t;
+
+        if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &t) != 0)
+            return 0.0;
+
+        return t.tv_sec + t.tv_nsec / 1.0e9;
+#else
+        return 0.0;
+#endif
+    }
+
+    static int64 getPeakResidentBytes()
+    {
+#if JUCE_MAC || JUCE_LINUX
+        struct rusage usage;
+
+        if (getrusage (RUSAGE_SELF, &usage) != 0)
+            return 0;
+
+       #if JUCE_MAC
+        return (int64) usage.ru_maxrss;
+       #else
+        return (int64) usage.ru_maxrss * 1024;
+       #endif
+#else
+        return 0;
+#endif
+    }
+
+private:
+    struct PhaseTotals
+    {
+        const char* name;
+        int count;
+        double wallSeconds;
+        double cpuSeconds;
+    };
+
+    struct HostTotals
+    {
+        int count { 0 };
+        int failed { 0 };
+        int64 bytes { 0 };
+    };
+
+    void addPhase (const char* name, double wallSeconds, double cpuSeconds)
+    {
+        std::lock_guard<std::mutex> lock (tablesLock);
+
+        if (! isEnabled())
+            return;
+
+        for (auto& p : phases)
+        {
+            if (strcmp (p.name, name) == 0)
+            {
+                ++p.count;
+                p.wallSeconds += wallSeconds;
+                p.cpuSeconds += cpuSeconds;
+                return;
+            }
+        }
+
+        PhaseTotals p = { name, 1, wallSeconds, cpuSeconds };
+        phases.push_back (p);
+    }
+
+    /* Constant initialised, so checking it is just a load. */
+    static std::atomic<bool>& getEnabledFlag()
+    {
+        static std::atomic<bool> enabled (false);
+        return enabled;
+    }
+
+    std::mutex tablesLock;
+    std::vector<PhaseTotals> phases;
+    std::map<String, HostTotals> hosts;
+
+    std::atomic<int64> bytesDownloaded { 0 };
+    std::atomic<int64> bytesExtracted { 0 };
+    std::atomic<int64> bytesCopied { 0 };
+    std::atomic<int> filesWritten { 0 };
+
+    int64 startTime { 0 };
+    double startWall { 0.0 };
+    double startCpu { 0.0 };
+};
+
+#endif  // RUNREPORT_H_INCLUDED
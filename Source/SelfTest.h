@@ -0,0 +1,1335 @@
+/*
+  ==============================================================================
+
+    SelfTest.h
+    Created: 21 Oct 2026 6:12:40pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef SELFTEST_H_INCLUDED
+#define SELFTEST_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "HttpMessage.h"
+#include "HttpServer.h"
+#include "TarStream.h"
+#include "BenchmarkFixtures.h"
+#include "ResumableDownload.h"
+#include "Mirrors.h"
+#include "DownloadCache.h"
+#include "DirectoryDelta.h"
+#include "DirectoryIndex.h"
+#include "DirectoryModel.h"
+#include "ModuleStore.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+/**
+ * Behaviour tests for the parts of jpm that talk to the network, unpack
+ * what comes back and keep track of it on disk.  Anything needing a server
+ * gets a local HttpServer and anything needing files a work folder, so the
+ * tests run offline and don't touch the user's cache or settings.
+ */
+namespace SelfTest
+{
+    /** A server whose replies are written by the test, which also records what it was asked. */
+    class ScriptedHandler
+        :
+        public HttpServer::Handler
+    {
+    public:
+        typedef std::function<HttpServer::Response (const HttpServer::Request&)> Responder;
+
+        ScriptedHandler (Responder respond_)
+            :
+            respond (respond_)
+        {}
+
+        HttpServer::Response handle (const HttpServer::Request& request) override
+        {
+            {
+                std::lock_guard<std::mutex> lock (requestsLock);
+                requests.add (request);
+            }
+
+            return respond (request);
+        }
+
+        Array<HttpServer::Request> getRequests()
+        {
+            std::lock_guard<std::mutex> lock (requestsLock);
+            return requests;
+        }
+
+    private:
+        Responder respond;
+        std::mutex requestsLock;
+        Array<HttpServer::Request> requests;
+    };
+
+    /** Starts the server on the first free port from 47300 and returns its base URL, or an empty string. */
+    inline String startServer (HttpServer& server)
+    {
+        for (int port = 47300; port < 47400; ++port)
+            if (server.start (port))
+                return "http://127.0.0.1:" + String (port) + "/";
+
+        return String();
+    }
+
+    inline HttpServer::Response makeText (int statusCode, const String& text)
+    {
+        HttpServer::Response r;
+        r.statusCode = statusCode;
+        r.headers.set ("Content-Type", "text/plain");
+        r.body.append (text.toRawUTF8(), text.getNumBytesAsUTF8());
+        return r;
+    }
+
+    /** A fresh, empty folder under the temp directory. */
+    inline File createWorkFolder (const String& name)
+    {
+        auto folder = File::getSpecialLocation (File::tempDirectory).getChildFile ("jpm-selftest").getChildFile (name);
+        folder.deleteRecursively();
+        folder.createDirectory();
+        return folder;
+    }
+
+    inline MemoryBlock createRandomData (int64 seed, int size)
+    {
+        Random random (seed);
+        MemoryBlock data ((size_t) size);
+        random.fillBitsRandomly (data.getData(), data.getSize());
+        return data;
+    }
+
+    //==============================================================================
+    class HttpResponseParserTest
+        :
+        public UnitTest
+    {
+    public:
+        HttpResponseParserTest() : UnitTest ("HttpResponseParser") {}
+
+        void runTest() override
+        {
+            beginTest ("content length, fed a byte at a time");
+            {
+                String body;
+                HttpResponseParser parser;
+                parser.reset();
+
+                String response ("HTTP/1.1 200 OK\r\nContent-Length: 5\r\nX-Test: a\r\nX-Test: b\r\n\r\nhello");
+                expectEquals (feedInPieces (parser, response, 1, body), response.length());
+                expect (parser.isComplete());
+                expectEquals (parser.getStatusCode(), 200);
+                expectEquals (parser.getContentLength(), (int64) 5);
+                expectEquals (parser.getHeaders()["x-test"], String ("a,b"));
+                expectEquals (body, String ("hello"));
+                expect (parser.canReuseConnection());
+            }
+
+            beginTest ("chunked, with extensions and trailers, split across reads");
+            {
+                String response ("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                                 "5;name=value\r\nhello\r\n"
+                                 "1\r\n \r\n"
+                                 "b\r\nchunked wor\r\n"
+                                 "2\r\nld\r\n"
+                                 "0\r\nX-Trailer: yes\r\n\r\n");
+
+                const int pieceSizes[] = { 1, 3, 7, 1000 };
+
+                for (int pieceSize : pieceSizes)
+                {
+                    String body;
+                    HttpResponseParser parser;
+                    parser.reset();
+
+                    expectEquals (feedInPieces (parser, response, pieceSize, body), response.length());
+                    expect (parser.isComplete(), "piece size " + String (pieceSize));
+                    expectEquals (body, String ("hello chunked world"));
+                    expectEquals (parser.getContentLength(), (int64) -1);
+                }
+            }
+
+            beginTest ("a chunk cut short is an error");
+            {
+                String body;
+                HttpResponseParser parser;
+                parser.reset();
+                feedInPieces (parser, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhel", 1000, body);
+                parser.connectionClosed();
+                expect (parser.hasError());
+            }
+
+            beginTest ("pipelined responses in one read");
+            {
+                String first ("HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\none");
+                String second ("HTTP/1.1 100 Continue\r\n\r\n"
+                               "HTTP/1.1 404 Not Found\r\nTransfer-Encoding: chunked\r\n\r\n3\r\ntwo\r\n0\r\n\r\n");
+                String third ("HTTP/1.1 304 Not Modified\r\nETag: \"x\"\r\n\r\n");
+                String head ("HTTP/1.1 200 OK\r\nContent-Length: 100\r\n\r\n");
+                String fifth ("HTTP/1.1 200 OK\r\nContent-Length: 4\r\nConnection: close\r\n\r\nfour");
+                auto all = (first + second + third + head + fifth).toStdString();
+
+                const char* data = all.data();
+                int size = (int) all.size();
+                StringArray bodies, statusCodes;
+                HttpResponseParser parser;
+
+                /* The fourth request was a HEAD, so its Content-Length has no body behind it. */
+                for (int i = 0; i < 5; ++i)
+                {
+                    String body;
+                    parser.reset (i == 3);
+                    const int used = parser.feed (data, size, [&body] (const char* d, int n) { body += String (d, (size_t) n); });
+
+                    expect (parser.isComplete(), "response " + String (i + 1));
+                    statusCodes.add (String (parser.getStatusCode()));
+                    bodies.add (body);
+                    data += used;
+                    size -= used;
+                }
+
+                expectEquals (size, 0);
+                expectEquals (bodies.joinIntoString ("|"), String ("one|two|||four"));
+                expectEquals (statusCodes.joinIntoString (" "), String ("200 404 304 200 200"));
+                expect (! parser.canReuseConnection());
+            }
+
+            beginTest ("HTTP/1.0 without a length reads until the connection closes");
+            {
+                String body;
+                HttpResponseParser parser;
+                parser.reset();
+                feedInPieces (parser, "HTTP/1.0 200 OK\r\n\r\nall of it", 4, body);
+                expect (! parser.isComplete());
+                parser.connectionClosed();
+                expect (parser.isComplete());
+                expectEquals (body, String ("all of it"));
+                expect (! parser.canReuseConnection());
+            }
+        }
+
+    private:
+        /** Feeds text to the parser pieceSize bytes at a time and returns how many bytes it took. */
+        static int feedInPieces (HttpResponseParser& parser, const String& text, int pieceSize, String& body)
+        {
+            auto bytes = text.toStdString();
+            int consumed = 0;
+
+            while (consumed < (int) bytes.size() && ! parser.isComplete() && ! parser.hasError())
+            {
+                const int n = jmin (pieceSize, (int) bytes.size() - consumed);
+                const int used = parser.feed (bytes.data() + consumed, n,
+                                              [&body] (const char* d, int size) { body += String (d, (size_t) size); });
+                consumed += used;
+
+                if (used < n)
+                    break;
+            }
+
+            return consumed;
+        }
+    };
+
+    //==============================================================================
+    class TransferEngineTest
+        :
+        public UnitTest
+    {
+    public:
+        TransferEngineTest() : UnitTest ("TransferEngine") {}
+
+        void runTest() override
+        {
+            ScriptedHandler handler ([] (const HttpServer::Request&) { return makeText (200, "hello"); });
+            HttpServer server (handler);
+            auto baseUrl = startServer (server);
+            expect (baseUrl.isNotEmpty(), "no free port for the test server");
+
+            if (baseUrl.isEmpty())
+                return;
+
+            auto& engine = TransferEngine::getInstance();
+
+            beginTest ("a kept-alive connection serves the next request");
+            {
+                const int opened = engine.getNumConnectionsOpened();
+                expectEquals (engine.fetchText (URL (baseUrl + "a"), String(), 5000), String ("hello"));
+                expectEquals (engine.fetchText (URL (baseUrl + "b"), String(), 5000), String ("hello"));
+                expectEquals (engine.getNumConnectionsOpened() - opened, 1);
+            }
+
+            beginTest ("https to a server that doesn't speak TLS fails by its deadline");
+            {
+                TransferRequest request (URL (baseUrl.replace ("http://", "https://") + "a"));
+                request.timeoutMs = 1000;
+
+                auto transfer = engine.start (request);
+                expect (transfer->waitFor (5000), "the transfer outlived its deadline");
+
+                if (transfer->isFinished())
+                    expect (! transfer->wait().succeeded());
+            }
+        }
+    };
+
+    //==============================================================================
+    class TarExtractorTest
+        :
+        public UnitTest
+    {
+    public:
+        TarExtractorTest() : UnitTest ("TarExtractor") {}
+
+        void runTest() override
+        {
+            auto folder = createWorkFolder ("tar");
+            auto longName = "repo-master/" + String::repeatedString ("long/", 30) + "name.h";
+            auto binary = createRandomData (1, 5000);
+
+            beginTest ("files, long names and skipped entries");
+            {
+                MemoryOutputStream tar;
+                addFile (tar, "repo-master/module/a.cpp", "int a;");
+                addFile (tar, "repo-master/module/empty.h", String());
+                BenchmarkFixtures::writeTarEntry (tar, "repo-master/module/data.bin", binary.getData(), binary.getSize());
+                addFile (tar, "repo-master/docs/readme.txt", "skipped");
+                addFile (tar, "../outside.txt", "unsafe");
+
+                auto name = longName.toStdString();
+                BenchmarkFixtures::writeTarEntry (tar, "././@LongLink", name.c_str(), name.size() + 1, 'L');
+                addFile (tar, "truncated-name", "long");
+                endArchive (tar);
+
+                StringArray skipped;
+                TarExtractor extractor;
+                extractor.onSkipped = [&skipped] (const String& path, int64) { skipped.add (path); };
+
+                auto result = extractGzipped (extractor, BenchmarkFixtures::gzip (tar.getMemoryBlock()), folder);
+
+                expect (result.wasOk(), result.getErrorMessage());
+                expectEquals (folder.getChildFile ("module/a.cpp").loadFileAsString(), String ("int a;"));
+                expect (folder.getChildFile ("module/empty.h").existsAsFile());
+                expectEquals (folder.getChildFile ("module/empty.h").getSize(), (int64) 0);
+
+                MemoryBlock written;
+                folder.getChildFile ("module/data.bin").loadFileAsData (written);
+                expect (written == binary);
+
+                expectEquals (folder.getChildFile (longName.fromFirstOccurrenceOf ("/", false, false)).loadFileAsString(),
+                              String ("long"));
+                expect (! folder.getChildFile ("truncated-name").exists());
+                expect (! folder.getChildFile ("docs").exists());
+                expect (! folder.getParentDirectory().getChildFile ("outside.txt").exists());
+                expect (skipped.contains ("repo-master/docs/readme.txt"));
+                expectEquals (extractor.getNumFilesWritten(), 4);
+            }
+
+            beginTest ("a corrupt header fails");
+            {
+                MemoryOutputStream tar;
+                addFile (tar, "repo-master/module/a.cpp", "int a;");
+                endArchive (tar);
+
+                MemoryBlock data (tar.getMemoryBlock());
+                static_cast<char*> (data.getData())[10] ^= 0x20;
+
+                TarExtractor extractor;
+                expect (extractGzipped (extractor, BenchmarkFixtures::gzip (data), createWorkFolder ("tar-corrupt")).failed());
+            }
+
+            beginTest ("a truncated archive fails");
+            {
+                MemoryOutputStream tar;
+                BenchmarkFixtures::writeTarEntry (tar, "repo-master/module/data.bin", binary.getData(), binary.getSize());
+
+                MemoryBlock data (tar.getData(), 512 + 1000);
+                TarExtractor extractor;
+                expect (extractGzipped (extractor, BenchmarkFixtures::gzip (data), createWorkFolder ("tar-truncated")).failed());
+            }
+
+            beginTest ("a bad gzip checksum or a missing trailer fails");
+            {
+                MemoryOutputStream tar;
+                addFile (tar, "repo-master/module/a.cpp", "int a;");
+                endArchive (tar);
+
+                auto gzipped = BenchmarkFixtures::gzip (tar.getMemoryBlock());
+                MemoryBlock badCrc (gzipped);
+                static_cast<char*> (badCrc.getData())[badCrc.getSize() - 8] ^= 1;
+                MemoryBlock cutShort (gzipped.getData(), gzipped.getSize() - 4);
+
+                TarExtractor extractor;
+                expect (extractGzipped (extractor, gzipped, createWorkFolder ("gzip-ok")).wasOk());
+                expect (extractGzipped (extractor, badCrc, createWorkFolder ("gzip-crc")).failed());
+                expect (extractGzipped (extractor, cutShort, createWorkFolder ("gzip-short")).failed());
+            }
+
+            beginTest ("an oversized extended header is refused");
+            {
+                MemoryOutputStream tar;
+                MemoryBlock name (2 * 1024 * 1024, true);
+                name.fillWith ('a');
+                BenchmarkFixtures::writeTarEntry (tar, "././@LongLink", name.getData(), name.getSize(), 'L');
+                addFile (tar, "truncated-name", "long");
+                endArchive (tar);
+
+                TarExtractor extractor;
+                expect (extractGzipped (extractor, BenchmarkFixtures::gzip (tar.getMemoryBlock()), createWorkFolder ("tar-huge")).failed());
+            }
+
+            beginTest ("data that isn't gzip is refused");
+            {
+                MemoryInputStream notGzip ("PK\3\4 this is a zip", 18, false);
+                ScopedPointer<InputStream> stream (TarExtractor::createGzipDecompressor (notGzip));
+                expect (stream == nullptr);
+            }
+
+            folder.getParentDirectory().deleteRecursively();
+        }
+
+    private:
+        static void addFile (OutputStream& tar, const String& path, const String& text)
+        {
+            BenchmarkFixtures::writeTarEntry (tar, path, text.toRawUTF8(), text.getNumBytesAsUTF8());
+        }
+
+        static void endArchive (OutputStream& tar)
+        {
+            tar.writeRepeatedByte (0, 1024);
+        }
+
+        /** Drops the archive's top folder, the way installs do, and skips docs. */
+        static Result extractGzipped (TarExtractor& extractor, const MemoryBlock& gzipped, const File& folder)
+        {
+            MemoryInputStream in (gzipped, false);
+            ScopedPointer<GzipInputStream> tar (TarExtractor::createGzipDecompressor (in));
+
+            if (tar == nullptr)
+                return Result::fail ("not gzip");
+
+            auto result = extractor.extract (*tar, folder, [] (const String& path)
+            {
+                auto relative = path.fromFirstOccurrenceOf ("/", false, false);
+                return relative.startsWith ("docs/") ? String() : relative;
+            });
+
+            return result.failed() ? result : tar->finish();
+        }
+    };
+
+    //==============================================================================
+    class ResumableDownloadTest
+        :
+        public UnitTest
+    {
+    public:
+        ResumableDownloadTest() : UnitTest ("ResumableDownload") {}
+
+        void runTest() override
+        {
+            auto folder = createWorkFolder ("resume");
+            auto served = folder.getChildFile ("served.bin");
+            auto destination = folder.getChildFile ("downloaded.bin");
+
+            /* Cuts off the first full reply part way, and can be told to ignore ranges. */
+            std::atomic<int64> dropNextAfter { -1 };
+            std::atomic<bool> honourRanges { true };
+
+            ScriptedHandler handler ([&] (const HttpServer::Request& request)
+            {
+                auto plain = request;
+
+                if (! honourRanges)
+                    plain.headers.remove ("Range");
+
+                auto r = HttpServer::serveFile (plain, served, "application/octet-stream");
+
+                if (r.statusCode == 200)
+                    r.dropAfter = dropNextAfter.exchange (-1);
+
+                return r;
+            });
+
+            HttpServer server (handler);
+            auto baseUrl = startServer (server);
+            expect (baseUrl.isNotEmpty(), "no free port for the test server");
+
+            if (baseUrl.isEmpty())
+                return;
+
+            URL url (baseUrl + "served.bin");
+
+            beginTest ("an interrupted download resumes with Range and If-Range");
+            {
+                auto contents = writeServed (served, 2, 300000);
+                dropNextAfter = 100000;
+
+                ResumableDownload download (url, destination);
+                expect (download.run());
+                expect (loadData (destination) == contents);
+
+                auto resumed = getRangeRequests (handler, 0);
+                expectEquals (resumed.size(), 1);
+                expect (resumed[0].headers["Range"].endsWith ("-"));
+                expect (resumed[0].headers["If-Range"].isNotEmpty());
+            }
+
+            beginTest ("a small file takes one request");
+            {
+                destination.deleteFile();
+                auto contents = writeServed (served, 8, 1000);
+                const int before = handler.getRequests().size();
+
+                ResumableDownload download (url, destination);
+                expect (download.run());
+                expect (loadData (destination) == contents);
+                expectEquals (handler.getRequests().size() - before, 1);
+            }
+
+            beginTest ("a file that changed before the resume is fetched again in full");
+            {
+                destination.deleteFile();
+                writeServed (served, 3, 300000);
+                dropNextAfter = 100000;
+
+                ResumableDownload interrupted (url, destination);
+                expect (! interrupted.run (1));
+                expect (! destination.exists());
+
+                /* Same size but different bytes, with a new modification time and so a new ETag. */
+                auto changed = writeServed (served, 4, 300000);
+                served.setLastModificationTime (Time::getCurrentTime() + RelativeTime::minutes (1));
+
+                ResumableDownload resumed (url, destination);
+                expect (resumed.run());
+                expect (loadData (destination) == changed);
+            }
+
+            beginTest ("a large file is fetched as parallel ranges");
+            {
+                destination.deleteFile();
+                auto contents = writeServed (served, 5, (int) ResumableDownload::parallelThreshold + 12345);
+                const int before = handler.getRequests().size();
+
+                ResumableDownload download (url, destination);
+                expect (download.run());
+                expect (loadData (destination) == contents);
+
+                /* No probe: the plain GET becomes part 0 and each other part is a range. */
+                expectEquals (getRangeRequests (handler, before).size(), (int) ResumableDownload::maxParts - 1);
+                expectEquals (handler.getRequests().size() - before, (int) ResumableDownload::maxParts);
+            }
+
+            beginTest ("a join interrupted after its rename finishes without fetching again");
+            {
+                destination.deleteFile();
+                auto contents = writeServed (served, 7, (int) ResumableDownload::parallelThreshold + 12345);
+                auto download = destination.getFileName() + ".download";
+                const int before = handler.getRequests().size();
+
+                destination.getSiblingFile (download).replaceWithData (contents.getData(), contents.getSize());
+                destination.getSiblingFile (download + ".2").replaceWithText ("left over");
+
+                XmlElement state ("download");
+                state.setAttribute ("url", url.toString (true));
+                state.setAttribute ("total", String ((int64) contents.getSize()));
+                state.setAttribute ("parts", (int) ResumableDownload::maxParts);
+                state.writeToFile (destination.getSiblingFile (download + ".xml"), String());
+
+                ResumableDownload resumed (url, destination);
+                expect (resumed.run());
+                expect (loadData (destination) == contents);
+                expectEquals (handler.getRequests().size() - before, 0);
+                expect (! destination.getSiblingFile (download + ".2").exists());
+            }
+
+            beginTest ("parts fall back to one stream when the server ignores ranges");
+            {
+                destination.deleteFile();
+                auto contents = writeServed (served, 6, (int) ResumableDownload::parallelThreshold + 12345);
+                honourRanges = false;
+
+                ResumableDownload download (url, destination);
+                expect (download.run());
+                expect (loadData (destination) == contents);
+
+                honourRanges = true;
+            }
+
+            server.stop();
+            folder.deleteRecursively();
+        }
+
+    private:
+        static MemoryBlock writeServed (const File& file, int64 seed, int size)
+        {
+            auto data = createRandomData (seed, size);
+            file.replaceWithData (data.getData(), data.getSize());
+            return data;
+        }
+
+        static MemoryBlock loadData (const File& file)
+        {
+            MemoryBlock data;
+            file.loadFileAsData (data);
+            return data;
+        }
+
+        /** The range requests made since the first few. */
+        static Array<HttpServer::Request> getRangeRequests (ScriptedHandler& handler, int from)
+        {
+            auto all = handler.getRequests();
+            Array<HttpServer::Request> found;
+
+            for (int i = from; i < all.size(); ++i)
+                if (all[i].headers["Range"].isNotEmpty())
+                    found.add (all[i]);
+
+            return found;
+        }
+    };
+
+    //==============================================================================
+    class DownloadCacheTest
+        :
+        public UnitTest
+    {
+    public:
+        DownloadCacheTest() : UnitTest ("DownloadCache") {}
+
+        void runTest() override
+        {
+            auto folder = createWorkFolder ("stream");
+            auto served = folder.getChildFile ("repo.tar.gz");
+            auto data = createRandomData (9, 300000);
+
+            MemoryOutputStream tar;
+            BenchmarkFixtures::writeTarEntry (tar, "repo-master/data.bin", data.getData(), data.getSize());
+            tar.writeRepeatedByte (0, 1024);
+
+            auto gzipped = BenchmarkFixtures::gzip (tar.getMemoryBlock());
+            served.replaceWithData (gzipped.getData(), gzipped.getSize());
+
+            std::atomic<int64> dropNextAfter { -1 };
+
+            ScriptedHandler handler ([&] (const HttpServer::Request& request)
+            {
+                auto r = HttpServer::serveFile (request, served, "application/gzip");
+
+                if (r.statusCode == 200)
+                    r.dropAfter = dropNextAfter.exchange (-1);
+
+                return r;
+            });
+
+            HttpServer server (handler);
+            auto baseUrl = startServer (server);
+            expect (baseUrl.isNotEmpty(), "no free port for the test server");
+
+            if (baseUrl.isEmpty())
+                return;
+
+            beginTest ("a tarball stream that breaks off continues with Range");
+            {
+                URL url (baseUrl + "repo.tar.gz");
+                DownloadCache cache;
+                auto entry = cache.getCachedFileLocation (url);
+                entry.deleteRecursively();
+                dropNextAfter = (int64) gzipped.getSize() / 2;
+
+                auto tree = cache.downloadUrlAndStreamExtract (url);
+                expect (tree.isDirectory());
+
+                MemoryBlock extracted;
+                tree.getChildFile ("repo-master/data.bin").loadFileAsData (extracted);
+                expect (extracted == data);
+
+                int numResumed = 0;
+
+                for (auto& r : handler.getRequests())
+                    if (r.headers["Range"].isNotEmpty() && r.headers["If-Range"].isNotEmpty())
+                        ++numResumed;
+
+                expectEquals (numResumed, 1);
+                expect (! entry.getSiblingFile (entry.getFileName() + ".tar.gz.download").exists());
+
+                entry.deleteRecursively();
+            }
+
+            server.stop();
+            folder.deleteRecursively();
+        }
+    };
+
+    //==============================================================================
+    class MirrorsTest
+        :
+        public UnitTest
+    {
+    public:
+        MirrorsTest() : UnitTest ("Mirrors") {}
+
+        void runTest() override
+        {
+            auto folder = createWorkFolder ("mirrors");
+            auto statsFile = folder.getChildFile ("mirrors.xml");
+            const String upstream ("http://127.0.0.1:9001/modules/a.json");
+            const String general ("http://127.0.0.1:9002/all/");
+            const String specific ("http://127.0.0.1:9003/modules-only/");
+
+            auto bothRules = makeRules (makeRule ("http://127.0.0.1:9001/", general));
+            bothRules.add (makeRule ("http://127.0.0.1:9001/modules/", specific));
+
+            beginTest ("unmeasured mirrors go first, most specific prefix first");
+            {
+                Mirrors mirrors (statsFile, bothRules, 500);
+
+                expectEquals (mirrors.getCandidates (upstream).joinIntoString (" "),
+                              specific + "a.json " + general + "modules/a.json " + upstream);
+                expectEquals (mirrors.getCandidates ("http://elsewhere/x").joinIntoString (" "), String ("http://elsewhere/x"));
+            }
+
+            beginTest ("an exclusive mirror leaves upstream out");
+            {
+                Mirrors mirrors (statsFile, makeRules (makeRule ("http://127.0.0.1:9001/", general, true)), 500);
+                expectEquals (mirrors.getCandidates (upstream).joinIntoString (" "), general + "modules/a.json");
+            }
+
+            beginTest ("measurements reorder the candidates");
+            {
+                XmlElement xml ("mirror_stats");
+                addStats (xml, "http://127.0.0.1:9001", 20.0, 0);
+                addStats (xml, "http://127.0.0.1:9002", 5.0, 0);
+                addStats (xml, "http://127.0.0.1:9003", 300.0, 0);
+                xml.writeToFile (statsFile, String());
+
+                Mirrors mirrors (statsFile, bothRules, 500);
+
+                expectEquals (mirrors.getCandidates (upstream).joinIntoString (" "),
+                              general + "modules/a.json " + upstream + " " + specific + "a.json");
+            }
+
+            beginTest ("a mirror that has only ever failed goes last");
+            {
+                XmlElement xml ("mirror_stats");
+                addStats (xml, "http://127.0.0.1:9002", -1.0, 1);
+                xml.writeToFile (statsFile, String());
+
+                Mirrors mirrors (statsFile, makeRules (makeRule ("http://127.0.0.1:9001/", general)), 500);
+                expectEquals (mirrors.getCandidates (upstream).joinIntoString (" "),
+                              upstream + " " + general + "modules/a.json");
+            }
+
+            statsFile.deleteFile();
+
+            std::atomic<int> slowMs { 0 };
+            std::atomic<int> mirrorStatus { 200 };
+
+            ScriptedHandler mirrorHandler ([&] (const HttpServer::Request&)
+            {
+                Thread::sleep (slowMs);
+                return makeText (mirrorStatus, "from the mirror");
+            });
+
+            ScriptedHandler upstreamHandler ([] (const HttpServer::Request&)
+            {
+                return makeText (200, "from upstream");
+            });
+
+            HttpServer mirrorServer (mirrorHandler);
+            HttpServer upstreamServer (upstreamHandler);
+            auto mirrorUrl = startServer (mirrorServer);
+            auto upstreamUrl = startServer (upstreamServer);
+            expect (mirrorUrl.isNotEmpty() && upstreamUrl.isNotEmpty(), "no free ports for the test servers");
+
+            if (mirrorUrl.isEmpty() || upstreamUrl.isEmpty())
+                return;
+
+            auto rules = makeRules (makeRule (upstreamUrl, mirrorUrl));
+
+            beginTest ("a fast mirror answers without asking upstream");
+            {
+                Mirrors mirrors (statsFile, rules, 1000);
+                String source;
+                auto result = mirrors.fetch (upstreamUrl + "index.json", String(), &source);
+
+                expect (result.succeeded());
+                expectEquals (result.getBodyAsString(), String ("from the mirror"));
+                expectEquals (source, mirrorUrl + "index.json");
+                expectEquals (upstreamHandler.getRequests().size(), 0);
+            }
+
+            beginTest ("a slow mirror is hedged to upstream");
+            {
+                statsFile.deleteFile();
+                slowMs = 3000;
+
+                Mirrors mirrors (statsFile, rules, 100);
+                String source;
+                const double start = Time::getMillisecondCounterHiRes();
+                auto result = mirrors.fetch (upstreamUrl + "index.json", String(), &source);
+                const double elapsed = Time::getMillisecondCounterHiRes() - start;
+
+                expect (result.succeeded());
+                expectEquals (result.getBodyAsString(), String ("from upstream"));
+                expectEquals (source, upstreamUrl + "index.json");
+                expect (elapsed < 2000.0, "took " + String (elapsed) + "ms");
+
+                slowMs = 0;
+            }
+
+            beginTest ("a failing mirror falls back at once and is remembered");
+            {
+                statsFile.deleteFile();
+                mirrorStatus = 500;
+
+                {
+                    Mirrors mirrors (statsFile, rules, 5000);
+                    String source;
+                    const double start = Time::getMillisecondCounterHiRes();
+                    auto result = mirrors.fetch (upstreamUrl + "index.json", String(), &source);
+
+                    expect (result.succeeded());
+                    expectEquals (source, upstreamUrl + "index.json");
+                    expect (Time::getMillisecondCounterHiRes() - start < 2000.0, "waited for the hedge delay");
+                }
+
+                Mirrors reloaded (statsFile, rules, 5000);
+                expectEquals (reloaded.getCandidates (upstreamUrl + "index.json")[0], upstreamUrl + "index.json");
+
+                mirrorStatus = 200;
+            }
+
+            mirrorServer.stop();
+            upstreamServer.stop();
+            folder.deleteRecursively();
+        }
+
+    private:
+        static Settings::Mirror makeRule (const String& prefix, const String& url, bool exclusive = false)
+        {
+            Settings::Mirror m;
+            m.prefix = prefix;
+            m.url = url;
+            m.exclusive = exclusive;
+            return m;
+        }
+
+        static Array<Settings::Mirror> makeRules (const Settings::Mirror& first)
+        {
+            Array<Settings::Mirror> rules;
+            rules.add (first);
+            return rules;
+        }
+
+        /** A host entry as Mirrors saves them, keyed by scheme, host and port. */
+        static void addStats (XmlElement& xml, const String& key, double latencyMs, int failures)
+        {
+            auto* e = xml.createNewChildElement ("host");
+            e->setAttribute ("key", key);
+            e->setAttribute ("latencyMs", latencyMs);
+            e->setAttribute ("bytesPerSecond", -1.0);
+            e->setAttribute ("failures", failures);
+        }
+    };
+
+    //==============================================================================
+    class DirectoryModelTest
+        :
+        public UnitTest
+    {
+    public:
+        DirectoryModelTest() : UnitTest ("DirectoryModel") {}
+
+        void runTest() override
+        {
+            beginTest ("repos and modules, skipping comments, declarations and stray modules");
+            {
+                DirectoryModel model;
+                expect (model.parse ("<?xml version=\"1.0\"?>\n"
+                                     "<!DOCTYPE jpm_directory>\n"
+                                     "<jpm_directory version=\"3\">\n"
+                                     "  <!-- <repo shortname=\"commented\" path=\"out\"/> -->\n"
+                                     "  <repo shortname='juce' path=\"julianstorer/JUCE\" source=\"GitHub\">\n"
+                                     "    <module name=\"juce_core\" description=\"core\" subpath=\"modules/juce_core\"/>\n"
+                                     "    <module name = \"juce_events\" subpath=\"modules/juce_events\" unknown=\"x\" />\n"
+                                     "  </repo>\n"
+                                     "  <repo shortname=\"empty\" path=\"someone/empty\" source=\"GitHub\"/>\n"
+                                     "  <module name=\"orphan\"/>\n"
+                                     "  <repo shortname=\"fork\" path=\"someone/JUCE\" source=\"GitHub\">\n"
+                                     "    <module name=\"juce_core\" description=\"forked core\"/>\n"
+                                     "  </repo>\n"
+                                     "</jpm_directory>\n"));
+
+                expectEquals (model.getNumRepos(), 3);
+                expectEquals (model.getNumModules(), 3);
+                expectEquals (model.getRepoShortname (0), String ("juce"));
+                expectEquals (model.getRepoPath (0), String ("julianstorer/JUCE"));
+                expectEquals (model.getRepoSource (0), String ("GitHub"));
+                expectEquals (model.getModuleName (1), String ("juce_events"));
+                expectEquals (model.getModuleSubpath (1), String ("modules/juce_events"));
+                expectEquals (model.getModuleDescription (1), String());
+                expectEquals (model.getModuleRepo (2), 2);
+
+                auto cores = model.findModules ("juce_core");
+                expectEquals (cores.size(), 2);
+                expectEquals (cores[0], 0);
+                expectEquals (cores[1], 2);
+                expectEquals (model.getModuleDescription (cores[1]), String ("forked core"));
+
+                expect (model.findModules ("orphan").isEmpty());
+                expect (model.findModules ("missing").isEmpty());
+                expect (model.isInRepo (cores[1], model.findString ("fork")));
+                expect (! model.isInRepo (cores[0], model.findString ("fork")));
+                expectEquals (model.findString ("commented"), (int64) -1);
+            }
+
+            beginTest ("entities in attribute values");
+            {
+                DirectoryModel model;
+                expect (model.parse ("<jpm_directory><repo shortname=\"r\" path=\"p\">"
+                                     "<module name=\"m\" description=\"a &amp; b &lt;c&gt; &quot;d&quot; &apos;e&apos; &#x41;&#66; &#233;\"/>"
+                                     "<module name=\"n\" description=\"AT&amp;T, R&D and &unknown; stay\"/>"
+                                     "</repo></jpm_directory>"));
+
+                expectEquals (model.getModuleDescription (0), String ("a & b <c> \"d\" 'e' AB ") + String (CharPointer_UTF8 ("\xc3\xa9")));
+                expectEquals (model.getModuleDescription (1), String ("AT&T, R&D and &unknown; stay"));
+            }
+
+            beginTest ("many distinct strings survive the string table growing");
+            {
+                String xml ("<jpm_directory><repo shortname=\"r\" path=\"p\">");
+
+                for (int i = 0; i < 5000; ++i)
+                    xml << "<module name=\"module_" << i << "\" description=\"description " << i << "\"/>";
+
+                xml << "</repo></jpm_directory>";
+
+                DirectoryModel model;
+                expect (model.parse (xml));
+                expectEquals (model.getNumModules(), 5000);
+
+                const int samples[] = { 0, 1023, 2048, 4999 };
+
+                for (auto i : samples)
+                {
+                    auto found = model.findModules ("module_" + String (i));
+                    expectEquals (found.size(), 1);
+                    expectEquals (model.getModuleDescription (found[0]), "description " + String (i));
+                }
+            }
+
+            beginTest ("malformed text is refused");
+            {
+                DirectoryModel unterminated;
+                expect (! unterminated.parse ("<jpm_directory><repo shortname=\"r path=\"p\"></repo></jpm_directory>"));
+
+                DirectoryModel unquoted;
+                expect (! unquoted.parse ("<jpm_directory><repo shortname=r/></jpm_directory>"));
+
+                DirectoryModel noRoot;
+                expect (! noRoot.parse ("<other><repo shortname=\"r\"/></other>"));
+            }
+        }
+    };
+
+    //==============================================================================
+    class DirectoryDeltaTest
+        :
+        public UnitTest
+    {
+    public:
+        DirectoryDeltaTest() : UnitTest ("DirectoryDelta") {}
+
+        void runTest() override
+        {
+            ValueTree from ("jpm_directory");
+            from.setProperty ("version", 10, nullptr);
+
+            auto juce = addRepo (from, "juce", "julianstorer/JUCE", "GitHub");
+            addModule (juce, "juce_core", "core");
+            addModule (juce, "juce_events", "events");
+            addModule (juce, "juce_gui_basics", "gui");
+            addModule (addRepo (from, "old", "someone/old", "GitHub"), "old_module", "going");
+            addModule (addRepo (from, "same", "someone/same", "GitHub"), "same_module", "staying");
+            addModule (addRepo (from, "moved", "someone/moved", "GitHub"), "moved_module", "staying");
+
+            ValueTree to ("jpm_directory");
+            to.setProperty ("version", 12, nullptr);
+
+            juce = addRepo (to, "juce", "julianstorer/JUCE", "GitHub");
+            addModule (juce, "juce_core", "core, but faster");
+            addModule (juce, "juce_events", "events");
+            addModule (juce, "juce_audio_basics", "audio");
+            addModule (addRepo (to, "same", "someone/same", "GitHub"), "same_module", "staying");
+            addModule (addRepo (to, "moved", "someone/moved", "Local"), "moved_module", "staying");
+            addModule (addRepo (to, "juce", "someone/JUCE", "GitHub"), "juce_core", "a fork");
+            addModule (addRepo (to, "new", "someone/new", "GitHub"), "new_module", "arriving");
+
+            beginTest ("the delta holds only what changed");
+            {
+                auto delta = DirectoryDelta::compute (from, to);
+                expect (DirectoryDelta::isDelta (delta));
+                expectEquals ((int) delta["from"], 10);
+                expectEquals ((int) delta["version"], 12);
+                expect (! findChange (delta, "same", "someone/same").isValid());
+                expect (findChange (delta, "moved", "someone/moved").isValid());
+                expectEquals (findChange (delta, "moved", "someone/moved").getNumChildren(), 0);
+                expect (findChange (delta, "old", "someone/old").hasType ("remove_repo"));
+                expect (findChange (delta, "juce", "someone/JUCE").isValid());
+
+                auto change = findChange (delta, "juce", "julianstorer/JUCE");
+                expect (change.getChildWithProperty ("name", "juce_core").isValid());
+                expect (change.getChildWithProperty ("name", "juce_audio_basics").isValid());
+                expect (change.getChildWithProperty ("name", "juce_gui_basics").hasType ("remove_module"));
+                expect (! change.getChildWithProperty ("name", "juce_events").isValid());
+
+                expectEquals (DirectoryDelta::compute (from, from).getNumChildren(), 0);
+            }
+
+            beginTest ("applying the delta gives the same directory as the full snapshot");
+            {
+                /* As it arrives from a server. */
+                ScopedPointer<XmlElement> xml (DirectoryDelta::compute (from, to).createXml());
+                auto delta = ValueTree::fromXml (*xml);
+
+                auto directory = from.createCopy();
+                expect (DirectoryDelta::apply (directory, delta).wasOk());
+                expectEquals (describe (directory), describe (to));
+                expectEquals (DirectoryDelta::getVersion (directory), 12);
+            }
+
+            beginTest ("a delta against another version is refused and changes nothing");
+            {
+                auto directory = to.createCopy();
+                expect (DirectoryDelta::apply (directory, DirectoryDelta::compute (from, to)).failed());
+                expectEquals (describe (directory), describe (to));
+                expectEquals (DirectoryDelta::getVersion (directory), 12);
+            }
+        }
+
+    private:
+        static ValueTree addRepo (ValueTree directory, const String& shortname, const String& path, const String& source)
+        {
+            ValueTree repo ("repo");
+            repo.setProperty ("shortname", shortname, nullptr);
+            repo.setProperty ("path", path, nullptr);
+            repo.setProperty ("source", source, nullptr);
+            directory.addChild (repo, -1, nullptr);
+            return repo;
+        }
+
+        static void addModule (ValueTree repo, const String& name, const String& description)
+        {
+            ValueTree module ("module");
+            module.setProperty ("name", name, nullptr);
+            module.setProperty ("description", description, nullptr);
+            repo.addChild (module, -1, nullptr);
+        }
+
+        static ValueTree findChange (const ValueTree& delta, const String& shortname, const String& path)
+        {
+            for (auto change : ValueTreeChildrenConnector (delta))
+                if (change["shortname"].toString() == shortname && change["path"].toString() == path)
+                    return change;
+
+            return ValueTree::invalid;
+        }
+
+        /** Every repo and module with its attributes, in an order that doesn't depend on the tree's. */
+        static String describe (const ValueTree& directory)
+        {
+            StringArray lines;
+
+            for (auto repo : ValueTreeChildrenConnector (directory))
+            {
+                auto key = DirectoryDelta::getRepoKey (repo);
+                lines.add (key + " source=" + repo["source"].toString());
+
+                for (auto module : ValueTreeChildrenConnector (repo))
+                    lines.add (key + " " + module["name"].toString() + " " + module["description"].toString());
+            }
+
+            lines.sort (false);
+            return lines.joinIntoString ("\n");
+        }
+    };
+
+    //==============================================================================
+    class DirectoryIndexTest
+        :
+        public UnitTest
+    {
+    public:
+        DirectoryIndexTest() : UnitTest ("DirectoryIndex") {}
+
+        void runTest() override
+        {
+            auto folder = createWorkFolder ("directory-index");
+            auto company = folder.getChildFile ("company.xml");
+            auto upstream = folder.getChildFile ("public.xml");
+
+            Array<DirectoryIndex::Layer> layers;
+            layers.add ({ "https://example.com/company.xml", company });
+            layers.add ({ "https://example.com/public.xml", upstream });
+
+            upstream.replaceWithText (makeDirectory ("<repo shortname=\"juce\" path=\"julianstorer/JUCE\" source=\"GitHub\">"
+                                                     "<module name=\"juce_core\" description=\"core\"/>"
+                                                     "<module name=\"juce_events\" description=\"events\"/>"
+                                                     "</repo>"
+                                                     "<repo shortname=\"other\" path=\"someone/other\" source=\"GitHub\">"
+                                                     "<module name=\"other_module\" description=\"other\"/>"
+                                                     "</repo>"));
+
+            company.replaceWithText (makeDirectory ("<repo shortname=\"juce\" path=\"company/JUCE\" source=\"GitHub\">"
+                                                    "<module name=\"juce_core\" description=\"company fork\"/>"
+                                                    "</repo>"));
+
+            DirectoryIndex index (folder.getChildFile ("index"));
+            folder.getChildFile ("index").createDirectory();
+
+            beginTest ("a higher layer shadows a module of the same name and repo shortname");
+            {
+                index.update (layers);
+                expectEquals (getDescription (index, "juce_core"), String ("company fork"));
+                expectEquals (getDescription (index, "juce_events"), String ("events"));
+                expectEquals (getDescription (index, "other_module"), String ("other"));
+                expectEquals (describe (index), describeRebuilt (folder, layers));
+            }
+
+            beginTest ("unchanged layers leave the index alone");
+            {
+                auto written = index.getFile().getLastModificationTime();
+                Thread::sleep (1100);
+                index.update (layers);
+                expect (index.getFile().getLastModificationTime() == written);
+            }
+
+            beginTest ("removing the shadowing module uncovers the one below");
+            {
+                company.replaceWithText (makeDirectory ("<repo shortname=\"juce\" path=\"company/JUCE\" source=\"GitHub\">"
+                                                        "<module name=\"juce_audio_basics\" description=\"company audio\"/>"
+                                                        "</repo>"));
+                index.update (layers);
+                expectEquals (getDescription (index, "juce_core"), String ("core"));
+                expectEquals (getDescription (index, "juce_audio_basics"), String ("company audio"));
+                expectEquals (describe (index), describeRebuilt (folder, layers));
+            }
+
+            beginTest ("a change below shows through only where nothing shadows it");
+            {
+                upstream.replaceWithText (makeDirectory ("<repo shortname=\"juce\" path=\"julianstorer/JUCE\" source=\"GitHub\">"
+                                                         "<module name=\"juce_core\" description=\"core, but faster\"/>"
+                                                         "<module name=\"juce_events\" description=\"events\"/>"
+                                                         "<module name=\"juce_audio_basics\" description=\"audio\"/>"
+                                                         "</repo>"
+                                                         "<repo shortname=\"other\" path=\"someone/other\" source=\"GitHub\">"
+                                                         "<module name=\"other_module\" description=\"other\"/>"
+                                                         "</repo>"));
+                index.update (layers);
+                expectEquals (getDescription (index, "juce_core"), String ("core, but faster"));
+                expectEquals (getDescription (index, "juce_audio_basics"), String ("company audio"));
+                expectEquals (describe (index), describeRebuilt (folder, layers));
+            }
+
+            beginTest ("a layer that empties takes its repos out of the index");
+            {
+                company.replaceWithText (makeDirectory (String()));
+                index.update (layers);
+                expectEquals (getDescription (index, "juce_audio_basics"), String ("audio"));
+
+                DirectoryModel model;
+                expect (model.loadFile (index.getFile()));
+                expectEquals (model.getNumRepos(), 2);
+                expectEquals (describe (index), describeRebuilt (folder, layers));
+            }
+
+            folder.deleteRecursively();
+        }
+
+    private:
+        static String makeDirectory (const String& repos)
+        {
+            return "<?xml version=\"1.0\"?>\n<jpm_directory version=\"1\">" + repos + "</jpm_directory>\n";
+        }
+
+        /** The description of the one module with this name in the merged directory. */
+        String getDescription (const DirectoryIndex& index, const String& name)
+        {
+            DirectoryModel model;
+            expect (model.loadFile (index.getFile()));
+
+            auto found = model.findModules (name);
+            expectEquals (found.size(), 1);
+            return found.size() == 1 ? model.getModuleDescription (found[0]) : String();
+        }
+
+        /** Every module in the merged directory with its repo, in an order that doesn't depend on the file's. */
+        static String describe (const DirectoryIndex& index)
+        {
+            DirectoryModel model;
+            model.loadFile (index.getFile());
+            StringArray lines;
+
+            for (int m = 0; m < model.getNumModules(); ++m)
+            {
+                const int repo = model.getModuleRepo (m);
+                lines.add (model.getRepoShortname (repo) + " " + model.getRepoPath (repo) + " "
+                           + model.getModuleName (m) + " " + model.getModuleDescription (m));
+            }
+
+            lines.sort (false);
+            return lines.joinIntoString ("\n");
+        }
+
+        /** What a fresh index of the same layers holds, for comparing an incrementally updated one with. */
+        static String describeRebuilt (const File& folder, const Array<DirectoryIndex::Layer>& layers)
+        {
+            auto rebuiltFolder = folder.getChildFile ("rebuilt");
+            rebuiltFolder.deleteRecursively();
+            rebuiltFolder.createDirectory();
+
+            DirectoryIndex rebuilt (rebuiltFolder);
+            rebuilt.update (layers);
+            return describe (rebuilt);
+        }
+    };
+
+    //==============================================================================
+    class ModuleStoreTest
+        :
+        public UnitTest
+    {
+    public:
+        ModuleStoreTest() : UnitTest ("ModuleStore") {}
+
+        void runTest() override
+        {
+            auto modules = createWorkFolder ("module-store");
+            auto link = modules.getChildFile ("foo");
+            ModuleStore store (modules);
+
+            addEntry (store, "1.0");
+            addEntry (store, "2.0");
+
+            /* Left by an earlier adoption, and possibly the only copy of someone's edits. */
+            auto earlier = store.getEntry ("foo", "unversioned");
+            earlier.createDirectory();
+            earlier.getChildFile ("old.txt").replaceWithText ("earlier edits");
+
+            beginTest ("a folder from before the store is adopted, never overwriting an earlier one");
+            {
+                link.createDirectory();
+                link.getChildFile ("edited.txt").replaceWithText ("local edits");
+
+                expect (store.activate ("foo", "1.0"));
+                expect (store.isActive ("foo", "1.0"));
+                expectEquals (link.getChildFile ("version.txt").loadFileAsString(), String ("1.0"));
+                expectEquals (earlier.getChildFile ("old.txt").loadFileAsString(), String ("earlier edits"));
+                expectEquals (store.getEntry ("foo", "unversioned-2").getChildFile ("edited.txt").loadFileAsString(),
+                              String ("local edits"));
+            }
+
+            beginTest ("switching version doesn't adopt the store's own copy");
+            {
+                expect (store.activate ("foo", "2.0"));
+                expect (store.isActive ("foo", "2.0"));
+                expect (! store.isActive ("foo", "1.0"));
+                expectEquals (link.getChildFile ("version.txt").loadFileAsString(), String ("2.0"));
+                expect (! store.getEntry ("foo", "unversioned-3").exists());
+                expect (store.contains ("foo", "1.0"));
+            }
+
+            beginTest ("prune keeps the active version, and adopted folders unless asked");
+            {
+                expect (store.prune (StringArray()) > 0);
+                expect (! store.contains ("foo", "1.0"));
+                expect (store.contains ("foo", "2.0"));
+                expect (earlier.isDirectory());
+                expect (store.getEntry ("foo", "unversioned-2").isDirectory());
+
+                expect (store.prune (StringArray(), true) > 0);
+                expect (! earlier.exists());
+                expect (! store.getEntry ("foo", "unversioned-2").exists());
+                expect (store.isActive ("foo", "2.0"));
+                expectEquals (link.getChildFile ("version.txt").loadFileAsString(), String ("2.0"));
+            }
+
+           #if JUCE_MAC || JUCE_LINUX
+            /* deleteRecursively() can't remove a link to a folder itself. */
+            unlink (link.getFullPathName().toRawUTF8());
+           #endif
+
+            modules.deleteRecursively();
+        }
+
+    private:
+        static void addEntry (const ModuleStore& store, const String& version)
+        {
+            auto entry = store.getEntry ("foo", version);
+            entry.createDirectory();
+            entry.getChildFile ("version.txt").replaceWithText (version);
+        }
+    };
+
+    //==============================================================================
+    /** Sends the runner's log through jpm's own output. */
+    class Runner
+        :
+        public UnitTestRunner
+    {
+    public:
+        void logMessage (const String& message) override
+        {
+            printInfo (message.trim());
+        }
+    };
+
+    /** Runs every test and returns the number of failures. */
+    inline int runAll()
+    {
+        HttpResponseParserTest httpResponseParserTest;
+        TransferEngineTest transferEngineTest;
+        TarExtractorTest tarExtractorTest;
+        ResumableDownloadTest resumableDownloadTest;
+        DownloadCacheTest downloadCacheTest;
+        MirrorsTest mirrorsTest;
+        DirectoryModelTest directoryModelTest;
+        DirectoryDeltaTest directoryDeltaTest;
+        DirectoryIndexTest directoryIndexTest;
+        ModuleStoreTest moduleStoreTest;
+
+        Array<UnitTest*> tests;
+        tests.add (&httpResponseParserTest);
+        tests.add (&transferEngineTest);
+        tests.add (&tarExtractorTest);
+        tests.add (&resumableDownloadTest);
+        tests.add (&downloadCacheTest);
+        tests.add (&mirrorsTest);
+        tests.add (&directoryModelTest);
+        tests.add (&directoryDeltaTest);
+        tests.add (&directoryIndexTest);
+        tests.add (&moduleStoreTest);
+
+        Runner runner;
+        runner.setAssertOnFailure (false);
+        runner.runTests (tests);
+
+        int numFailures = 0;
+
+        for (int i = 0; i < runner.getNumResults(); ++i)
+            numFailures += runner.getResult (i)->failures;
+
+        return numFailures;
+    }
+}
+
+#endif  // SELFTEST_H_INCLUDED
@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    Settings.h
+    Created: 20 Oct 2026 9:05:12am
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef SETTINGS_H_INCLUDED
+#define SETTINGS_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+
+/**
+ * Machine wide jpm settings, as opposed to the per-project jpmfile.xml.
+ *
+ * They live in jpm.settings.xml in the user's application data folder, or
+ * wherever the JPM_SETTINGS environment variable points.  For example:
+ *
+ *   <jpm_settings hedgeDelayMs="500" cacheFolder="/tmp/jpm.modulecache">
+ *     <directory url="/home/me/modules/team_directory.xml"/>
+ *     <directory url="https://git.internal/jpm/company_directory.xml"/>
+ *     <directory url="https://raw.githubusercontent.com/jcredland/jpm/master/jpm_directory.xml"/>
+ *     <mirror prefix="https://www.github.com/" url="http://cache.local:8080/github/"/>
+ *     <mirror prefix="https://www.github.com/jcredland/" url="http://git.internal/mirror/jcredland/"/>
+ *     <install_filter exclude="docs;examples;*.pdf" include=""/>
+ *   </jpm_settings>
+ *
+ * Directories are layered, earlier ones shadowing later ones, and may be URLs
+ * or local files.  Without any the public directory is used.
+ *
+ * A mirror serves everything under its prefix.  Use a whole repository path
+ * as the prefix to mirror one repository, or the directory URL itself to
+ * mirror the directory.  Upstream is still tried when mirrors fail, unless
+ * the mirror is marked exclusive="1", which keeps everything under its
+ * prefix off the public network.
+ *
+ * install_filter sets include and exclude patterns used for every module,
+ * in addition to any on the module itself - see InstallFilter.
+ *
+ * cacheFolder moves the download cache, and the statistics kept with it,
+ * from jpm.modulecache in the user's application data folder.
+ */
+class Settings
+{
+public:
+    struct Mirror
+    {
+        String prefix;
+        String url;
+        bool exclusive { false };
+    };
+
+    Settings()
+    {
+        ScopedPointer<XmlElement> xml = XmlDocument (getFile()).getDocumentElement();
+
+        if (xml != nullptr)
+            settings = ValueTree::fromXml (*xml);
+    }
+
+    static Settings& getInstance()
+    {
+        static Settings instance;
+        return instance;
+    }
+
+    static File getFile()
+    {
+        auto path = SystemStats::getEnvironmentVariable ("JPM_SETTINGS", String());
+
+        if (path.isNotEmpty())
+            return File::getCurrentWorkingDirectory().getChildFile (path);
+
+        return File::getSpecialLocation (File::userApplicationDataDirectory).getChildFile ("jpm.settings.xml");
+    }
+
+    /** Directory locations in priority order, highest first. */
+    StringArray getDirectoryUrls() const
+    {
+        StringArray urls;
+
+        for (auto child : ValueTreeChildrenConnector (settings))
+            if (child.hasType ("directory") && child["url"].toString().isNotEmpty())
+                urls.add (child["url"]);
+
+        if (urls.isEmpty())
+            urls.add (getDefaultDirectoryUrl());
+
+        return urls;
+    }
+
+    /** The public directory, a copy of which is built into jpm. */
+    static String getDefaultDirectoryUrl()
+    {
+        return "https://raw.githubusercontent.com/jcredland/jpm/master/jpm_directory.xml";
+    }
+
+    /** The lowest layer, normally the public directory. */
+    String getDirectoryUrl() const
+    {
+        return getDirectoryUrls()[getDirectoryUrls().size() - 1];
+    }
+
+    /** Mirrors in the order they were listed. */
+    Array<Mirror> getMirrors() const
+    {
+        Array<Mirror> mirrors;
+
+        for (auto child : ValueTreeChildrenConnector (settings))
+        {
+            if (! child.hasType ("mirror"))
+                continue;
+
+            Mirror m;
+            m.prefix = child["prefix"];
+            m.url = child["url"];
+            m.exclusive = child["exclusive"];
+
+            if (m.prefix.isNotEmpty() && m.url.isNotEmpty())
+                mirrors.add (m);
+        }
+
+        return mirrors;
+    }
+
+    /** How long a request may take before a backup goes to the next mirror. */
+    int getHedgeDelayMs() const
+    {
+        return settings.getProperty ("hedgeDelayMs", 500);
+    }
+
+    /** Where downloads, the directory index and their statistics are kept. */
+    File getCacheFolder() const
+    {
+        auto path = settings["cacheFolder"].toString();
+
+        if (path.isNotEmpty())
+            return getFile().getParentDirectory().getChildFile (path);
+
+        return File::getSpecialLocation (File::userApplicationDataDirectory).getChildFile ("jpm.modulecache");
+    }
+
+    /** For tools that need a cache of their own.  Call it before anything uses the cache. */
+    void setCacheFolder (const File& folder)
+    {
+        settings.setProperty ("cacheFolder", folder.getFullPathName(), nullptr);
+    }
+
+    /** Include patterns applied to every module. */
+    String getDefaultIncludes() const
+    {
+        return settings.getChildWithName ("install_filter")["include"];
+    }
+
+    /** Exclude patterns applied to every module. */
+    String getDefaultExcludes() const
+    {
+        return settings.getChildWithName ("install_filter")["exclude"];
+    }
+
+    ValueTree getTree() const
+    {
+        return settings;
+    }
+
+private:
+    ValueTree settings { "jpm_settings" };
+};
+
+#endif  // SETTINGS_H_INCLUDED
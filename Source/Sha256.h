@@ -0,0 +1,281 @@
+/*
+  ==============================================================================
+
+    Sha256.h
+    Created: 21 Oct 2026 8:47:32am
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef SHA256_H_INCLUDED
+#define SHA256_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <cstring>
+
+#if JUCE_INTEL && (defined (__GNUC__) || defined (__clang__))
+ #define JPM_SHA_NI 1
+ #include <cpuid.h>
+ #include <immintrin.h>
+ #define JPM_SHA_NI_TARGET __attribute__ ((target ("sha,sse4.1")))
+#elif JUCE_INTEL && defined (_MSC_VER)
+ #define JPM_SHA_NI 1
+ #include <intrin.h>
+ #include <immintrin.h>
+ #define JPM_SHA_NI_TARGET
+#else
+ #define JPM_SHA_NI 0
+#endif
+
+/**
+ * Incremental SHA-256.
+ *
+ * On x86 processors with the SHA extensions the compression function runs on
+ * those instructions, which is several times faster than the portable code
+ * used everywhere else.  Both give the same digest; which one is used is
+ * decided once, at run time.
+ */
+class Sha256
+{
+public:
+    Sha256()
+    {
+        static const uint32 initial[8] =
+        {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+        };
+
+        memcpy (state, initial, sizeof (state));
+    }
+
+    void update (const void* data, size_t size)
+    {
+        auto* p = static_cast<const uint8*> (data);
+        totalBytes += size;
+
+        if (bufferUsed > 0)
+        {
+            const size_t n = jmin (size, (size_t) 64 - bufferUsed);
+            memcpy (buffer + bufferUsed, p, n);
+            bufferUsed += n;
+            p += n;
+            size -= n;
+
+            if (bufferUsed < 64)
+                return;
+
+            compress (state, buffer, 1);
+            bufferUsed = 0;
+        }
+
+        if (size >= 64)
+        {
+            compress (state, p, size / 64);
+            p += size & ~(size_t) 63;
+            size &= 63;
+        }
+
+        memcpy (buffer, p, size);
+        bufferUsed = size;
+    }
+
+    /** Finishes the hash and returns it as 64 lower case hex digits. */
+    String finishAsHex()
+    {
+        const uint64 bits = totalBytes * 8;
+        const uint8 pad = 0x80;
+        const uint8 zero = 0;
+
+        update (&pad, 1);
+
+        while (bufferUsed != 56)
+            update (&zero, 1);
+
+        uint8 length[8];
+
+        for (int i = 0; i < 8; ++i)
+            length[i] = (uint8) (bits >> (56 - 8 * i));
+
+        update (length, 8);
+
+        uint8 digest[32];
+
+        for (int i = 0; i < 8; ++i)
+            for (int j = 0; j < 4; ++j)
+                digest[i * 4 + j] = (uint8) (state[i] >> (24 - 8 * j));
+
+        return String::toHexString (digest, 32, 0);
+    }
+
+    /** True if the SHA extensions are being used. */
+    static bool isAccelerated()
+    {
+#if JPM_SHA_NI
+        static const bool supported = detectShaExtensions();
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+private:
+    static const uint32* getRoundConstants()
+    {
+        static const uint32 k[64] =
+        {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+
+        return k;
+    }
+
+    static void compress (uint32* s, const uint8* data, size_t numBlocks)
+    {
+#if JPM_SHA_NI
+        if (isAccelerated())
+        {
+            compressWithShaExtensions (s, data, numBlocks);
+            return;
+        }
+#endif
+        compressPortable (s, data, numBlocks);
+    }
+
+    static inline uint32 rotr (uint32 x, int n)
+    {
+        return (x >> n) | (x << (32 - n));
+    }
+
+    static void compressPortable (uint32* s, const uint8* data, size_t numBlocks)
+    {
+        auto* k = getRoundConstants();
+        uint32 w[64];
+
+        for (; numBlocks > 0; --numBlocks, data += 64)
+        {
+            for (int i = 0; i < 16; ++i)
+                w[i] = ((uint32) data[i * 4] << 24) | ((uint32) data[i * 4 + 1] << 16)
+                       | ((uint32) data[i * 4 + 2] << 8) | (uint32) data[i * 4 + 3];
+
+            for (int i = 16; i < 64; ++i)
+            {
+                const uint32 s0 = rotr (w[i - 15], 7) ^ rotr (w[i - 15], 18) ^ (w[i - 15] >> 3);
+                const uint32 s1 = rotr (w[i - 2], 17) ^ rotr (w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            uint32 a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+
+            for (int i = 0; i < 64; ++i)
+            {
+                const uint32 t1 = h + (rotr (e, 6) ^ rotr (e, 11) ^ rotr (e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+                const uint32 t2 = (rotr (a, 2) ^ rotr (a, 13) ^ rotr (a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                h = g; g = f; f = e; e = d + t1;
+                d = c; c = b; b = a; a = t1 + t2;
+            }
+
+            s[0] += a; s[1] += b; s[2] += c; s[3] += d;
+            s[4] += e; s[5] += f; s[6] += g; s[7] += h;
+        }
+    }
+
+#if JPM_SHA_NI
+    static bool detectShaExtensions()
+    {
+       #if defined (_MSC_VER)
+        int info[4];
+        __cpuid (info, 0);
+
+        if (info[0] < 7)
+            return false;
+
+        __cpuid (info, 1);
+        const bool sse41 = (info[2] & (1 << 19)) != 0;
+        __cpuidex (info, 7, 0);
+        return sse41 && (info[1] & (1 << 29)) != 0;
+       #else
+        unsigned int a, b, c, d;
+
+        if (! __get_cpuid (1, &a, &b, &c, &d) || (c & (1u << 19)) == 0)
+            return false;
+
+        if (__get_cpuid_max (0, nullptr) < 7)
+            return false;
+
+        __cpuid_count (7, 0, a, b, c, d);
+        return (b & (1u << 29)) != 0;
+       #endif
+    }
+
+    /**
+     * Four rounds per step.  The state is kept in the ABEF/CDGH order the
+     * instructions expect, and the message schedule for later rounds is
+     * built as the earlier ones run.
+     */
+    JPM_SHA_NI_TARGET static void compressWithShaExtensions (uint32* s, const uint8* data, size_t numBlocks)
+    {
+        auto* k = getRoundConstants();
+        const __m128i byteSwap = _mm_set_epi64x (0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+
+        __m128i tmp = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i*) s), 0xb1);
+        __m128i state1 = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i*) (s + 4)), 0x1b);
+        __m128i state0 = _mm_alignr_epi8 (tmp, state1, 8);
+        state1 = _mm_blend_epi16 (state1, tmp, 0xf0);
+
+        for (; numBlocks > 0; --numBlocks, data += 64)
+        {
+            const __m128i abefSave = state0;
+            const __m128i cdghSave = state1;
+            __m128i w[4];
+
+            for (int i = 0; i < 16; ++i)
+            {
+                if (i < 4)
+                    w[i] = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i*) (data + i * 16)), byteSwap);
+
+                __m128i msg = _mm_add_epi32 (w[i & 3], _mm_loadu_si128 ((const __m128i*) (k + i * 4)));
+                state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+
+                if (i >= 3 && i <= 14)
+                {
+                    auto& next = w[(i + 1) & 3];
+                    next = _mm_add_epi32 (next, _mm_alignr_epi8 (w[i & 3], w[(i + 3) & 3], 4));
+                    next = _mm_sha256msg2_epu32 (next, w[i & 3]);
+                }
+
+                msg = _mm_shuffle_epi32 (msg, 0x0e);
+                state0 = _mm_sha256rnds2_epu32 (state0, state1, msg);
+
+                if (i >= 1 && i <= 12)
+                    w[(i + 3) & 3] = _mm_sha256msg1_epu32 (w[(i + 3) & 3], w[i & 3]);
+            }
+
+            state0 = _mm_add_epi32 (state0, abefSave);
+            state1 = _mm_add_epi32 (state1, cdghSave);
+        }
+
+        tmp = _mm_shuffle_epi32 (state0, 0x1b);
+        state1 = _mm_shuffle_epi32 (state1, 0xb1);
+        state0 = _mm_blend_epi16 (tmp, state1, 0xf0);
+        state1 = _mm_alignr_epi8 (state1, tmp, 8);
+
+        _mm_storeu_si128 ((__m128i*) s, state0);
+        _mm_storeu_si128 ((__m128i*) (s + 4), state1);
+    }
+#endif
+
+    uint32 state[8];
+    uint8 buffer[64];
+    size_t bufferUsed { 0 };
+    uint64 totalBytes { 0 };
+};
+
+#endif  // SHA256_H_INCLUDED
@@ -13,7 +13,11 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "Utilities.h"
+#include "Trace.h"
+#include "RunReport.h"
 #include <iostream>
+#include <map>
+#include <mutex>
 
 class Source
 {
@@ -28,24 +32,30 @@ public:
     };
 };
 
-inline String trimSlashes (String text)
-{
-    if (text.endsWithChar ('/'))
-        text = text.dropLastCharacters (1);
-
-    if (text.startsWithChar ('/'))
-        return text.substring (1);
-
-    return text;
-}
-
 class GitHubSource
     :
     public Source
 {
 public:
+    /** The base URL can point at anything that serves GitHub's archive layout. */
+    GitHubSource (const String& archiveBaseUrl_ = "https://www.github.com/")
+        :
+        archiveBaseUrl (archiveBaseUrl_)
+    {}
+
+    /** The whole archive is cached once per version, whichever module in it is asked for. */
     DownloadInfo download (const String& path, String version, const String& subpath)
     {
+        TraceSpan span ("github download", "download");
+        RunReport::Phase phase ("fetch");
+
+        if (span.isActive())
+        {
+            span.setArg ("path", path);
+            span.setArg ("version", version);
+            span.setArg ("subpath", subpath);
+        }
+
         if (version.isEmpty())
         {
             version = "master";
@@ -54,11 +64,21 @@ public:
 
         DownloadInfo downloadInfo;
 
-        URL url ("https://www.github.com/" + trimSlashes (path) + "/archive/" + version + ".zip");
+        auto archive = archiveBaseUrl + trimSlashes (path) + "/archive/" + version;
+
+        /* Tarballs can be extracted as they arrive, so try those first. */
+        URL url (archive + ".tar.gz");
         printInfo ("url: " + url.toString (true));
 
         DownloadCache cache;
-        auto file = cache.downloadUrlAndUncompress (url);
+        auto file = cache.downloadUrlAndStreamExtract (url);
+
+        if (file == File::nonexistent)
+        {
+            url = URL (archive + ".zip");
+            printWarning ("falling back to " + url.toString (true));
+            file = cache.downloadUrlAndUncompress (url);
+        }
 
         if (file == File::nonexistent)
             return downloadInfo;
@@ -66,6 +86,12 @@ public:
         Array<File> subFolders;
         file.findChildFiles (subFolders, File::findDirectories, false, "*");
 
+        if (subFolders.isEmpty())
+        {
+            printError ("the download of " + path + " is empty; try jpm erasecache");
+            return downloadInfo;
+        }
+
         if (subFolders.size() != 1)
             printError ("warning: download cache contains mutiple subfolders.  either github have change their api or you should clear your cache");
 
@@ -89,16 +115,51 @@ public:
         return downloadInfo;
     }
 
+    /**
+     * Resolves master to a commit.  Answers are remembered for a minute so a
+     * long running process, like the daemon, doesn't ask GitHub on every
+     * install.
+     */
     String getMasterGitCommitReference (const String& path)
     {
+        struct Resolved
+        {
+            String sha;
+            uint32 time;
+        };
+
+        static std::mutex lock;
+        static std::map<String, Resolved> resolved;
+        const uint32 lifetimeMs = 60 * 1000;
+        TraceSpan span ("resolve ref", "download");
+
+        {
+            std::lock_guard<std::mutex> l (lock);
+            auto r = resolved.find (path);
+
+            if (r != resolved.end() && Time::getMillisecondCounter() - r->second.time < lifetimeMs)
+            {
+                span.setArg ("cache", "hit");
+                return r->second.sha;
+            }
+        }
+
+        span.setArg ("cache", "miss");
+
         URL url ("https://api.github.com/repos/" + trimSlashes (path) + "/commits/master");
 
-        auto data = url.readEntireTextStream (false);
+        auto data = Mirrors::getInstance().fetchText (url.toString (true));
         auto json = JSON::fromString (data);
         auto sha1 = json.getProperty ("sha", String::empty).toString();
 
         printInfo ("got master commit at " + sha1);
 
+        if (sha1.isNotEmpty())
+        {
+            std::lock_guard<std::mutex> l (lock);
+            resolved[path] = { sha1, Time::getMillisecondCounter() };
+        }
+
         return sha1;
     }
 
@@ -106,6 +167,9 @@ public:
     {
         return StringArray ("master");
     }
+
+private:
+    String archiveBaseUrl;
 };
 
 
@@ -0,0 +1,702 @@
+/*
+  ==============================================================================
+
+    TarStream.h
+    Created: 19 Oct 2026 11:20:17am
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef TARSTREAM_H_INCLUDED
+#define TARSTREAM_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * Reads one stream to its end and then another, e.g. the part of a file that
+ * is already on disk followed by the rest as it arrives.  Owns the first.
+ */
+class ConcatenatedInputStream
+    :
+    public InputStream
+{
+public:
+    ConcatenatedInputStream (InputStream* first_, InputStream& second_)
+        :
+        first (first_),
+        second (second_)
+    {}
+
+    int read (void* destBuffer, int maxBytesToRead) override
+    {
+        auto* dest = static_cast<char*> (destBuffer);
+        int numRead = first->isExhausted() ? 0 : jmax (0, first->read (dest, maxBytesToRead));
+
+        if (numRead < maxBytesToRead)
+            numRead += jmax (0, second.read (dest + numRead, maxBytesToRead - numRead));
+
+        position += numRead;
+        return numRead;
+    }
+
+    int64 getTotalLength() override
+    {
+        auto secondLength = second.getTotalLength();
+        return secondLength < 0 ? -1 : first->getTotalLength() + secondLength;
+    }
+
+    bool isExhausted() override
+    {
+        return first->isExhausted() && second.isExhausted();
+    }
+
+    int64 getPosition() override
+    {
+        return position;
+    }
+
+    bool setPosition (int64) override
+    {
+        return false;
+    }
+
+private:
+    ScopedPointer<InputStream> first;
+    InputStream& second;
+    int64 position { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (ConcatenatedInputStream)
+};
+
+/**
+ * A bounded in-memory pipe.  One thread writes into it while another reads it
+ * as an ordinary InputStream, so a network read can run ahead of whatever is
+ * consuming the data.
+ */
+class PipeInputStream
+    :
+    public InputStream
+{
+public:
+    PipeInputStream (size_t capacity_ = 4 * 1024 * 1024)
+        :
+        buffer (capacity_),
+        capacity (capacity_)
+    {}
+
+    /**
+     * Called by the producer.  Blocks while the pipe is full, unless
+     * growIfFull is set in which case the buffer is enlarged instead, which
+     * suits producers that mustn't stall.  Returns false if the reader has
+     * gone away.
+     */
+    bool write (const void* data, size_t numBytes, bool growIfFull = false)
+    {
+        auto* src = static_cast<const char*> (data);
+        std::unique_lock<std::mutex> lock (mutex);
+
+        if (growIfFull && capacity - used < numBytes)
+            grow (used + numBytes);
+
+        while (numBytes > 0)
+        {
+            changed.wait (lock, [this] { return closed || used < capacity; });
+
+            if (closed)
+                return false;
+
+            auto chunk = jmin (numBytes, capacity - used, capacity - writePos);
+            memcpy (buffer.data() + writePos, src, chunk);
+            writePos = (writePos + chunk) % capacity;
+            used += chunk;
+            src += chunk;
+            numBytes -= chunk;
+            changed.notify_all();
+        }
+
+        return true;
+    }
+
+    /** Called by the producer once it has nothing more to write. */
+    void finish (bool succeeded)
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        finished = true;
+        failed = ! succeeded;
+        changed.notify_all();
+    }
+
+    /** Called by the reader to release a producer that may be blocked. */
+    void close()
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        closed = true;
+        changed.notify_all();
+    }
+
+    /** True if the producer finished without an error. */
+    bool succeeded() const
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        return finished && ! failed;
+    }
+
+    int read (void* destBuffer, int maxBytesToRead) override
+    {
+        auto* dest = static_cast<char*> (destBuffer);
+        std::unique_lock<std::mutex> lock (mutex);
+        int numRead = 0;
+
+        while (numRead < maxBytesToRead)
+        {
+            changed.wait (lock, [this] { return used > 0 || finished || closed; });
+
+            if (used == 0)
+                break;
+
+            auto chunk = jmin ((size_t) (maxBytesToRead - numRead), used, capacity - readPos);
+            memcpy (dest + numRead, buffer.data() + readPos, chunk);
+            readPos = (readPos + chunk) % capacity;
+            used -= chunk;
+            numRead += (int) chunk;
+            changed.notify_all();
+        }
+
+        position += numRead;
+        return numRead;
+    }
+
+    int64 getTotalLength() override
+    {
+        return -1;
+    }
+
+    bool isExhausted() override
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        return used == 0 && (finished || closed);
+    }
+
+    int64 getPosition() override
+    {
+        return position;
+    }
+
+    bool setPosition (int64) override
+    {
+        return false;
+    }
+
+private:
+    void grow (size_t minimumSize)
+    {
+        std::vector<char> bigger (jmax (capacity * 2, minimumSize));
+
+        for (size_t i = 0; i < used; ++i)
+            bigger[i] = buffer[(readPos + i) % capacity];
+
+        buffer.swap (bigger);
+        capacity = buffer.size();
+        readPos = 0;
+        writePos = used % capacity;
+    }
+
+    std::vector<char> buffer;
+    size_t capacity;
+    size_t readPos { 0 }, writePos { 0 }, used { 0 };
+    int64 position { 0 };
+    bool finished { false }, failed { false }, closed { false };
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+};
+
+/**
+ * The inflated contents of a gzip member whose header has already been read.
+ * JUCE's decompressor stops quietly at the end of whatever data it is given,
+ * so a truncated or corrupt stream looks just like a short one; finish()
+ * checks the CRC-32 and length in the gzip trailer against what was read.
+ */
+class GzipInputStream
+    :
+    public InputStream
+{
+public:
+    GzipInputStream (InputStream& source_)
+        :
+        source (source_),
+        inflater (&source, false, true)
+    {}
+
+    int read (void* destBuffer, int maxBytesToRead) override
+    {
+        const int n = inflater.read (destBuffer, maxBytesToRead);
+
+        if (n > 0)
+        {
+            crc = updateCrc (crc, destBuffer, (size_t) n);
+            length += n;
+        }
+
+        return n;
+    }
+
+    bool isExhausted() override
+    {
+        return inflater.isExhausted();
+    }
+
+    int64 getTotalLength() override
+    {
+        return -1;
+    }
+
+    int64 getPosition() override
+    {
+        return length;
+    }
+
+    bool setPosition (int64) override
+    {
+        return false;
+    }
+
+    /**
+     * Reads anything left, e.g. the padding after a tar archive's end, then
+     * checks the trailer.  The trailer is the last eight bytes of the
+     * stream, which the inflater has usually buffered already, so the source
+     * is drained and its tail kept as it goes by.
+     */
+    Result finish()
+    {
+        HeapBlock<char> scratch (16384);
+
+        while (read (scratch, 16384) > 0) {}
+
+        source.drain();
+
+        const uint8* t = source.tail;
+        const uint32 storedCrc = (uint32) t[0] | ((uint32) t[1] << 8) | ((uint32) t[2] << 16) | ((uint32) t[3] << 24);
+        const uint32 storedLength = (uint32) t[4] | ((uint32) t[5] << 8) | ((uint32) t[6] << 16) | ((uint32) t[7] << 24);
+
+        if (source.total < 8 || storedCrc != (crc ^ 0xffffffffu) || storedLength != (uint32) length)
+            return Result::fail ("corrupt gzip stream (checksum or length doesn't match)");
+
+        return Result::ok();
+    }
+
+private:
+    /** Passes reads through, remembering the last eight bytes. */
+    struct TailKeeper
+        :
+        public InputStream
+    {
+        TailKeeper (InputStream& in_) : in (in_) {}
+
+        int read (void* destBuffer, int maxBytesToRead) override
+        {
+            const int n = in.read (destBuffer, maxBytesToRead);
+            auto* bytes = static_cast<const uint8*> (destBuffer);
+
+            for (int i = jmax (0, n - 8); i < n; ++i)
+            {
+                memmove (tail, tail + 1, 7);
+                tail[7] = bytes[i];
+            }
+
+            total += jmax (0, n);
+            return n;
+        }
+
+        void drain()
+        {
+            char scratch[4096];
+
+            while (read (scratch, sizeof (scratch)) > 0) {}
+        }
+
+        bool isExhausted() override         { return in.isExhausted(); }
+        int64 getTotalLength() override     { return in.getTotalLength(); }
+        int64 getPosition() override        { return total; }
+        bool setPosition (int64) override   { return false; }
+
+        InputStream& in;
+        uint8 tail[8] = { 0 };
+        int64 total { 0 };
+    };
+
+    static uint32 updateCrc (uint32 crc, const void* data, size_t size)
+    {
+        struct Table
+        {
+            Table()
+            {
+                for (uint32 i = 0; i < 256; ++i)
+                {
+                    uint32 c = i;
+
+                    for (int k = 0; k < 8; ++k)
+                        c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+
+                    entries[i] = c;
+                }
+            }
+
+            uint32 entries[256];
+        };
+
+        static const Table table;
+        auto* bytes = static_cast<const uint8*> (data);
+
+        for (size_t i = 0; i < size; ++i)
+            crc = table.entries[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+
+        return crc;
+    }
+
+    TailKeeper source;
+    GZIPDecompressorInputStream inflater;
+    uint32 crc { 0xffffffffu };
+    int64 length { 0 };
+};
+
+/**
+ * Reads a .tar.gz stream entry by entry and writes the entries it is told to
+ * keep, without ever needing the whole archive.  Handles ustar, pax and GNU
+ * long name headers, which covers what GitHub produces.
+ */
+class TarExtractor
+{
+public:
+    /**
+     * Returns the relative path to write an archive entry to, or an empty
+     * string to skip it.
+     */
+    typedef std::function<String (const String& pathInArchive)> PathFilter;
+
+    /** If set, called with each regular file the filter skipped and its size. */
+    std::function<void (const String& pathInArchive, int64 size)> onSkipped;
+
+    /**
+     * Strips the gzip header and returns a stream of the decompressed data.
+     * The JUCE decompressor only understands zlib or raw deflate, so the gzip
+     * framing is handled here.  Returns nullptr if this isn't gzip data.
+     */
+    static GzipInputStream* createGzipDecompressor (InputStream& source)
+    {
+        uint8 header[10];
+
+        if (source.read (header, 10) != 10 || header[0] != 0x1f || header[1] != 0x8b || header[2] != 8)
+            return nullptr;
+
+        const uint8 flags = header[3];
+
+        if (flags & 4) /* FEXTRA */
+        {
+            uint8 len[2];
+            source.read (len, 2);
+            source.skipNextBytes (len[0] | (len[1] << 8));
+        }
+
+        if (flags & 8) /* FNAME */
+            while (! source.isExhausted() && source.readByte() != 0) {}
+
+        if (flags & 16) /* FCOMMENT */
+            while (! source.isExhausted() && source.readByte() != 0) {}
+
+        if (flags & 2) /* FHCRC */
+            source.skipNextBytes (2);
+
+        return new GzipInputStream (source);
+    }
+
+    Result extract (InputStream& tar, const File& targetDirectory, PathFilter filter)
+    {
+        HeapBlock<char> block (blockSize);
+        String longName;
+        String paxPath;
+
+        numFilesWritten = 0;
+        numBytesWritten = 0;
+
+        for (;;)
+        {
+            if (! readBlock (tar, block))
+                return Result::fail ("unexpected end of tar stream");
+
+            if (isZeroBlock (block))
+                return Result::ok();
+
+            if (! checksumMatches (block))
+                return Result::fail ("corrupt tar header");
+
+            const char type = block[156];
+            const int64 size = parseNumber (block + 124, 12);
+            const int mode = (int) parseNumber (block + 100, 8);
+
+            if (type == 'L' || type == 'x' || type == 'g')
+            {
+                MemoryBlock data;
+
+                /* These only ever hold a name or a few records. */
+                if (size > maxMetadataSize)
+                    return Result::fail ("corrupt tar header (" + String (size) + " byte extended header)");
+
+                if (! readData (tar, size, data))
+                    return Result::fail ("unexpected end of tar stream");
+
+                if (type == 'L')
+                    longName = String::fromUTF8 ((const char*) data.getData(), (int) strnlen ((const char*) data.getData(), data.getSize()));
+                else if (type == 'x')
+                    paxPath = parsePaxPath (data);
+
+                continue;
+            }
+
+            String path;
+
+            if (paxPath.isNotEmpty())
+                path = paxPath;
+            else if (longName.isNotEmpty())
+                path = longName;
+            else
+                path = getHeaderName (block);
+
+            paxPath = String();
+            longName = String();
+
+            auto relative = isSafePath (path) ? filter (path) : String();
+
+            /* Links could point anywhere, so they're never created. */
+            if (relative.isNotEmpty() && (type == '1' || type == '2'))
+                printWarning ("skipping " + String (type == '2' ? "symlink " : "hard link ") + path + " -> "
+                              + String::fromUTF8 (block + 157, (int) strnlen (block + 157, 100)));
+
+            if (relative.isEmpty() || (type != '0' && type != '\0' && type != '5'))
+            {
+                if (relative.isEmpty() && (type == '0' || type == '\0') && onSkipped)
+                    onSkipped (path, size);
+
+                if (! skipData (tar, size))
+                    return Result::fail ("unexpected end of tar stream");
+
+                continue;
+            }
+
+            auto target = targetDirectory.getChildFile (relative);
+
+            if (type == '5')
+            {
+                auto result = target.createDirectory();
+
+                if (result.failed())
+                    return result;
+
+                continue;
+            }
+
+            auto result = writeFile (tar, target, size, mode);
+
+            if (result.failed())
+                return result;
+        }
+    }
+
+    int getNumFilesWritten() const
+    {
+        return numFilesWritten;
+    }
+
+    int64 getNumBytesWritten() const
+    {
+        return numBytesWritten;
+    }
+
+private:
+    static const int blockSize = 512;
+    static const int64 maxMetadataSize = 1024 * 1024;
+
+    static bool readBlock (InputStream& in, char* block)
+    {
+        return in.read (block, blockSize) == blockSize;
+    }
+
+    static int64 paddedSize (int64 size)
+    {
+        return (size + blockSize - 1) / blockSize * blockSize;
+    }
+
+    /** Reads in chunks, so a header lying about its size fails before much is allocated. */
+    static bool readData (InputStream& in, int64 size, MemoryBlock& data)
+    {
+        MemoryOutputStream out (data, false);
+        char chunk[4096];
+        int64 remaining = size;
+
+        while (remaining > 0)
+        {
+            auto n = in.read (chunk, (int) jmin (remaining, (int64) sizeof (chunk)));
+
+            if (n <= 0)
+                return false;
+
+            out.write (chunk, (size_t) n);
+            remaining -= n;
+        }
+
+        out.flush();
+        return skipData (in, paddedSize (size) - size);
+    }
+
+    static bool skipData (InputStream& in, int64 numBytes)
+    {
+        char scratch[4096];
+
+        while (numBytes > 0)
+        {
+            auto n = in.read (scratch, (int) jmin (numBytes, (int64) sizeof (scratch)));
+
+            if (n <= 0)
+                return false;
+
+            numBytes -= n;
+        }
+
+        return true;
+    }
+
+    Result writeFile (InputStream& in, const File& target, int64 size, int mode)
+    {
+        target.getParentDirectory().createDirectory();
+        target.deleteFile();
+
+        {
+            FileOutputStream out (target);
+
+            if (out.failedToOpen())
+                return Result::fail ("could not write " + target.getFullPathName());
+
+            HeapBlock<char> buffer (65536);
+            int64 remaining = size;
+
+            while (remaining > 0)
+            {
+                auto n = in.read (buffer, (int) jmin (remaining, (int64) 65536));
+
+                if (n <= 0)
+                    return Result::fail ("unexpected end of tar stream");
+
+                out.write (buffer, (size_t) n);
+                remaining -= n;
+            }
+        }
+
+        if ((mode & 0100) != 0)
+            target.setExecutePermission (true);
+
+        ++numFilesWritten;
+        numBytesWritten += size;
+
+        return skipData (in, paddedSize (size) - size) ? Result::ok()
+                                                       : Result::fail ("unexpected end of tar stream");
+    }
+
+    static bool isZeroBlock (const char* block)
+    {
+        for (int i = 0; i < blockSize; ++i)
+            if (block[i] != 0)
+                return false;
+
+        return true;
+    }
+
+    static bool checksumMatches (const char* block)
+    {
+        int64 sum = 0;
+
+        for (int i = 0; i < blockSize; ++i)
+            sum += (i >= 148 && i < 156) ? ' ' : (uint8) block[i];
+
+        return sum == parseNumber (block + 148, 8);
+    }
+
+    /** Octal, or base-256 when the top bit is set (GNU extension for large files). */
+    static int64 parseNumber (const char* field, int length)
+    {
+        if ((uint8) field[0] & 0x80)
+        {
+            int64 value = field[0] & 0x7f;
+
+            for (int i = 1; i < length; ++i)
+                value = (value << 8) | (uint8) field[i];
+
+            return value;
+        }
+
+        int64 value = 0;
+
+        for (int i = 0; i < length && field[i] != 0; ++i)
+            if (field[i] >= '0' && field[i] <= '7')
+                value = value * 8 + (field[i] - '0');
+
+        return value;
+    }
+
+    static String getHeaderName (const char* block)
+    {
+        auto name = String::fromUTF8 (block, (int) strnlen (block, 100));
+
+        if (memcmp (block + 257, "ustar", 5) == 0 && block[345] != 0)
+            name = String::fromUTF8 (block + 345, (int) strnlen (block + 345, 155)) + "/" + name;
+
+        return name;
+    }
+
+    /** Pax records look like "<length> <key>=<value>\n". */
+    static String parsePaxPath (const MemoryBlock& data)
+    {
+        auto* text = static_cast<const char*> (data.getData());
+        size_t pos = 0;
+
+        while (pos < data.getSize())
+        {
+            size_t length = 0;
+            size_t i = pos;
+
+            while (i < data.getSize() && text[i] >= '0' && text[i] <= '9')
+                length = length * 10 + (size_t) (text[i++] - '0');
+
+            if (length == 0 || pos + length > data.getSize())
+                break;
+
+            auto record = String::fromUTF8 (text + i + 1, (int) (length - (i + 1 - pos) - 1));
+
+            if (record.startsWith ("path="))
+                return record.substring (5);
+
+            pos += length;
+        }
+
+        return String();
+    }
+
+    /** Refuse absolute paths and anything that climbs out of the target. */
+    static bool isSafePath (const String& path)
+    {
+        if (path.startsWithChar ('/') || path.containsChar ('\\') || path.containsChar (':'))
+            return false;
+
+        StringArray parts;
+        parts.addTokens (path, "/", String());
+        return ! parts.contains ("..");
+    }
+
+    int numFilesWritten { 0 };
+    int64 numBytesWritten { 0 };
+};
+
+#endif  // TARSTREAM_H_INCLUDED
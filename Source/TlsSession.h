@@ -0,0 +1,427 @@
+/*
+  ==============================================================================
+
+    TlsSession.h
+    Created: 21 Oct 2026 7:05:12pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef TLSSESSION_H_INCLUDED
+#define TLSSESSION_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#if JUCE_LINUX
+ #define JPM_NATIVE_TLS 1
+ #include <arpa/inet.h>
+ #include <openssl/err.h>
+ #include <openssl/ssl.h>
+ #include <openssl/x509v3.h>
+#elif JUCE_MAC
+ #define JPM_NATIVE_TLS 1
+ #include <errno.h>
+ #include <sys/socket.h>
+ #include <Security/Security.h>
+ #include <Security/SecureTransport.h>
+#else
+ #define JPM_NATIVE_TLS 0
+#endif
+
+#if JPM_NATIVE_TLS
+/**
+ * The client side of TLS over a non-blocking socket that the caller owns and
+ * polls, so https can run on the transfer engine's event loop and share its
+ * connection pool with plain http.  OpenSSL on Linux, Secure Transport on
+ * the Mac; certificates are checked against the system's trust store and the
+ * host name.
+ *
+ * Each call does as much as the socket allows and says what it's waiting
+ * for, like a non-blocking send() or recv().
+ */
+class TlsSession
+{
+public:
+    enum Status
+    {
+        done,
+        wantRead,
+        wantWrite,
+        closed,
+        failed
+    };
+
+    /** False if the TLS library couldn't be set up, in which case https takes the slow path. */
+    static bool isAvailable();
+
+    TlsSession (int fd, const String& host);
+    ~TlsSession();
+
+    Status handshake();
+
+    /** numRead is only set when the result is done. */
+    Status read (void* data, size_t size, size_t& numRead);
+
+    /** numWritten is only set when the result is done. */
+    Status write (const void* data, size_t size, size_t& numWritten);
+
+    /** True while encrypted data is still waiting for the socket, so it needs flush() once writable. */
+    bool hasBufferedOutput() const;
+    Status flush();
+
+    /** Why the last call failed. */
+    String getError() const
+    {
+        return error;
+    }
+
+private:
+    String host;
+    String error;
+
+   #if JUCE_LINUX
+    Status getStatus (int returned);
+
+    SSL* ssl { nullptr };
+   #else
+    Status getStatus (OSStatus status, bool forHandshake);
+    static OSStatus readFromSocket (SSLConnectionRef connection, void* data, size_t* length);
+    static OSStatus writeToSocket (SSLConnectionRef connection, const void* data, size_t* length);
+
+    int fd;
+    SSLContextRef context { nullptr };
+    bool writeBlocked { false };
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE (TlsSession)
+};
+
+#if JUCE_LINUX
+//==============================================================================
+namespace TlsDetail
+{
+    /** One context for the process, with the system's CA certificates loaded. */
+    inline SSL_CTX* getContext()
+    {
+        struct Context
+        {
+            Context()
+            {
+                ctx = SSL_CTX_new (TLS_client_method());
+
+                if (ctx == nullptr)
+                    return;
+
+                SSL_CTX_set_min_proto_version (ctx, TLS1_2_VERSION);
+                SSL_CTX_set_verify (ctx, SSL_VERIFY_PEER, nullptr);
+                SSL_CTX_set_mode (ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+               #ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+                /* Plenty of servers close without a close_notify; the HTTP
+                 * framing already says whether the response was complete. */
+                SSL_CTX_set_options (ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+               #endif
+
+                if (SSL_CTX_set_default_verify_paths (ctx) != 1)
+                {
+                    SSL_CTX_free (ctx);
+                    ctx = nullptr;
+                }
+            }
+
+            ~Context()
+            {
+                if (ctx != nullptr)
+                    SSL_CTX_free (ctx);
+            }
+
+            SSL_CTX* ctx { nullptr };
+        };
+
+        static Context context;
+        return context.ctx;
+    }
+}
+
+inline bool TlsSession::isAvailable()
+{
+    return TlsDetail::getContext() != nullptr;
+}
+
+inline TlsSession::TlsSession (int fd, const String& host_)
+    :
+    host (host_)
+{
+    ssl = SSL_new (TlsDetail::getContext());
+    SSL_set_fd (ssl, fd);
+    SSL_set_connect_state (ssl);
+
+    in6_addr scratch;
+    const bool isAddress = inet_pton (AF_INET, host.toRawUTF8(), &scratch) == 1
+                           || inet_pton (AF_INET6, host.toRawUTF8(), &scratch) == 1;
+
+    /* Names are sent for virtual hosting and checked against the certificate;
+     * an address literal is only checked. */
+    if (isAddress)
+    {
+        X509_VERIFY_PARAM_set1_ip_asc (SSL_get0_param (ssl), host.toRawUTF8());
+    }
+    else
+    {
+        SSL_set_tlsext_host_name (ssl, host.toRawUTF8());
+        SSL_set1_host (ssl, host.toRawUTF8());
+    }
+}
+
+inline TlsSession::~TlsSession()
+{
+    /* The socket belongs to the caller, so SSL_free leaves it open. */
+    SSL_free (ssl);
+}
+
+inline TlsSession::Status TlsSession::handshake()
+{
+    ERR_clear_error();
+    return getStatus (SSL_do_handshake (ssl));
+}
+
+inline TlsSession::Status TlsSession::read (void* data, size_t size, size_t& numRead)
+{
+    ERR_clear_error();
+    const int n = SSL_read (ssl, data, (int) jmin (size, (size_t) 0x7fffffff));
+
+    if (n > 0)
+        numRead = (size_t) n;
+
+    return getStatus (n);
+}
+
+inline TlsSession::Status TlsSession::write (const void* data, size_t size, size_t& numWritten)
+{
+    ERR_clear_error();
+    const int n = SSL_write (ssl, data, (int) jmin (size, (size_t) 0x7fffffff));
+
+    if (n > 0)
+        numWritten = (size_t) n;
+
+    return getStatus (n);
+}
+
+/* OpenSSL writes records straight to the socket, so nothing is held back. */
+inline bool TlsSession::hasBufferedOutput() const
+{
+    return false;
+}
+
+inline TlsSession::Status TlsSession::flush()
+{
+    return done;
+}
+
+inline TlsSession::Status TlsSession::getStatus (int returned)
+{
+    if (returned > 0)
+        return done;
+
+    switch (SSL_get_error (ssl, returned))
+    {
+        case SSL_ERROR_WANT_READ:   return wantRead;
+        case SSL_ERROR_WANT_WRITE:  return wantWrite;
+        case SSL_ERROR_ZERO_RETURN: return closed;
+        default:                    break;
+    }
+
+    const long verification = SSL_get_verify_result (ssl);
+
+    if (verification != X509_V_OK)
+    {
+        error = "certificate for " + host + " rejected: " + X509_verify_cert_error_string (verification);
+        return failed;
+    }
+
+    const unsigned long code = ERR_get_error();
+
+    /* Without an OpenSSL error it was the socket: a plain EOF is the peer
+     * hanging up, which the caller judges like a recv() of zero. */
+    if (code == 0)
+    {
+        if (returned == 0)
+            return closed;
+
+        error = "connection to " + host + " lost";
+        return failed;
+    }
+
+    char text[256];
+    ERR_error_string_n (code, text, sizeof (text));
+    error = "TLS error talking to " + host + ": " + text;
+    return failed;
+}
+
+#else
+//==============================================================================
+/* Secure Transport is deprecated in favour of Network.framework, which
+ * wants to own the socket and its run loop, so it can't share our poller. */
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+
+inline bool TlsSession::isAvailable()
+{
+    return true;
+}
+
+inline TlsSession::TlsSession (int fd_, const String& host_)
+    :
+    host (host_),
+    fd (fd_)
+{
+    context = SSLCreateContext (kCFAllocatorDefault, kSSLClientSide, kSSLStreamType);
+    SSLSetIOFuncs (context, readFromSocket, writeToSocket);
+    SSLSetConnection (context, this);
+    SSLSetProtocolVersionMin (context, kTLSProtocol12);
+    SSLSetPeerDomainName (context, host.toRawUTF8(), host.getNumBytesAsUTF8());
+}
+
+inline TlsSession::~TlsSession()
+{
+    CFRelease (context);
+}
+
+inline TlsSession::Status TlsSession::handshake()
+{
+    return getStatus (SSLHandshake (context), true);
+}
+
+inline TlsSession::Status TlsSession::read (void* data, size_t size, size_t& numRead)
+{
+    size_t processed = 0;
+    const OSStatus status = SSLRead (context, data, size, &processed);
+
+    /* Data that arrived before the socket blocked or closed is still data. */
+    if (processed > 0)
+    {
+        numRead = processed;
+        return done;
+    }
+
+    return getStatus (status, false);
+}
+
+inline TlsSession::Status TlsSession::write (const void* data, size_t size, size_t& numWritten)
+{
+    size_t processed = 0;
+    const OSStatus status = SSLWrite (context, data, size, &processed);
+
+    /* Once accepted the data is Secure Transport's to send; the rest goes
+     * out through flush(). */
+    if (processed > 0)
+    {
+        numWritten = processed;
+        return done;
+    }
+
+    return getStatus (status, false);
+}
+
+inline bool TlsSession::hasBufferedOutput() const
+{
+    return writeBlocked;
+}
+
+/* A zero length write sends whatever is queued first. */
+inline TlsSession::Status TlsSession::flush()
+{
+    size_t processed = 0;
+    const OSStatus status = SSLWrite (context, nullptr, 0, &processed);
+    return writeBlocked ? wantWrite : getStatus (status, false);
+}
+
+inline TlsSession::Status TlsSession::getStatus (OSStatus status, bool forHandshake)
+{
+    switch (status)
+    {
+        case noErr:
+            return done;
+
+        case errSSLWouldBlock:
+            return writeBlocked ? wantWrite : wantRead;
+
+        case errSSLClosedGraceful:
+        case errSSLClosedNoNotify:
+            return closed;
+
+        default:
+            break;
+    }
+
+    error = String (forHandshake ? "TLS handshake with " : "TLS error talking to ") + host
+            + " failed (OSStatus " + String ((int) status) + ")";
+    return failed;
+}
+
+inline OSStatus TlsSession::readFromSocket (SSLConnectionRef connection, void* data, size_t* length)
+{
+    auto& session = *static_cast<TlsSession*> (const_cast<void*> (connection));
+    const size_t wanted = *length;
+    size_t got = 0;
+
+    while (got < wanted)
+    {
+        auto n = recv (session.fd, static_cast<char*> (data) + got, wanted - got, 0);
+
+        if (n > 0)
+        {
+            got += (size_t) n;
+            continue;
+        }
+
+        *length = got;
+
+        if (n == 0)
+            return errSSLClosedGraceful;
+
+        if (errno == EINTR)
+            continue;
+
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? errSSLWouldBlock : errSSLClosedAbort;
+    }
+
+    *length = got;
+    return noErr;
+}
+
+inline OSStatus TlsSession::writeToSocket (SSLConnectionRef connection, const void* data, size_t* length)
+{
+    auto& session = *static_cast<TlsSession*> (const_cast<void*> (connection));
+    const size_t wanted = *length;
+    size_t sent = 0;
+
+    while (sent < wanted)
+    {
+        auto n = send (session.fd, static_cast<const char*> (data) + sent, wanted - sent, 0);
+
+        if (n > 0)
+        {
+            sent += (size_t) n;
+            continue;
+        }
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        *length = sent;
+        session.writeBlocked = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        return session.writeBlocked ? errSSLWouldBlock : errSSLClosedAbort;
+    }
+
+    *length = sent;
+    session.writeBlocked = false;
+    return noErr;
+}
+
+#pragma clang diagnostic pop
+#endif
+
+#endif  // JPM_NATIVE_TLS
+#endif  // TLSSESSION_H_INCLUDED
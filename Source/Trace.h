@@ -0,0 +1,217 @@
+/*
+  ==============================================================================
+
+    Trace.h
+    Created: 21 Oct 2026 3:05:51pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef TRACE_H_INCLUDED
+#define TRACE_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+
+/**
+ * A timeline of what a jpm run spent its time on - `--trace=<file>`.
+ *
+ * Code marks the work it does with TraceSpans.  While tracing, each span is
+ * recorded with its thread, start and duration, and at the end they are
+ * written as Chrome trace event JSON, which chrome://tracing and
+ * ui.perfetto.dev both open.  When not tracing a span only checks one
+ * flag, so they can be left in hot paths.
+ */
+class Trace
+{
+public:
+    static Trace& getInstance()
+    {
+        static Trace trace;
+        return trace;
+    }
+
+    static bool isEnabled()
+    {
+        return getEnabledFlag().load (std::memory_order_relaxed);
+    }
+
+    /**
+     * Starts recording, throwing away anything recorded before.  The calling
+     * thread, which runs the command, is thread 1 and is labelled main.
+     */
+    void start (const File& output_)
+    {
+        std::lock_guard<std::mutex> lock (eventsLock);
+        output = output_;
+        events.clear();
+        threadIds.clear();
+        threadIds[Thread::getCurrentThreadId()] = 1;
+        startTime = Time::getMillisecondCounterHiRes();
+        getEnabledFlag() = true;
+    }
+
+    /** Stops recording and writes the file.  Spans still open are left out. */
+    bool finish()
+    {
+        getEnabledFlag() = false;
+
+        std::lock_guard<std::mutex> lock (eventsLock);
+        Array<var> traceEvents;
+
+        for (auto& t : threadIds)
+        {
+            DynamicObject::Ptr args (new DynamicObject());
+            args->setProperty ("name", t.second == 1 ? String ("main") : "thread " + String (t.second));
+
+            DynamicObject::Ptr e (new DynamicObject());
+            e->setProperty ("name", "thread_name");
+            e->setProperty ("ph", "M");
+            e->setProperty ("pid", 1);
+            e->setProperty ("tid", t.second);
+            e->setProperty ("args", var (args));
+            traceEvents.add (var (e));
+        }
+
+        for (auto& event : events)
+        {
+            DynamicObject::Ptr e (new DynamicObject());
+            e->setProperty ("name", event.name);
+            e->setProperty ("cat", event.category);
+            e->setProperty ("ph", "X");
+            e->setProperty ("ts", event.start);
+            e->setProperty ("dur", event.duration);
+            e->setProperty ("pid", 1);
+            e->setProperty ("tid", event.thread);
+
+            if (event.args.isObject())
+                e->setProperty ("args", event.args);
+
+            traceEvents.add (var (e));
+        }
+
+        events.clear();
+
+        DynamicObject::Ptr root (new DynamicObject());
+        root->setProperty ("traceEvents", traceEvents);
+        root->setProperty ("displayTimeUnit", "ms");
+
+        return output.replaceWithText (JSON::toString (var (root), true));
+    }
+
+    /** Microseconds since recording started. */
+    double now() const
+    {
+        return (Time::getMillisecondCounterHiRes() - startTime) * 1000.0;
+    }
+
+    void add (const char* name, const char* category, double start, double end, const var& args)
+    {
+        std::lock_guard<std::mutex> lock (eventsLock);
+
+        /* It finished after the trace did. */
+        if (! isEnabled())
+            return;
+
+        auto& thread = threadIds[Thread::getCurrentThreadId()];
+
+        if (thread == 0)
+            thread = (int) threadIds.size();
+
+        Event e;
+        e.name = name;
+        e.category = category;
+        e.start = start;
+        e.duration = end - start;
+        e.thread = thread;
+        e.args = args;
+        events.push_back (e);
+    }
+
+private:
+    struct Event
+    {
+        const char* name;
+        const char* category;
+        double start;
+        double duration;
+        int thread;
+        var args;
+    };
+
+    /* Constant initialised, so checking it is just a load. */
+    static std::atomic<bool>& getEnabledFlag()
+    {
+        static std::atomic<bool> enabled (false);
+        return enabled;
+    }
+
+    File output;
+    double startTime { 0.0 };
+    std::mutex eventsLock;
+    std::vector<Event> events;
+    std::map<Thread::ThreadID, int> threadIds;
+};
+
+/**
+ * Records the time from its construction to its destruction as one event on
+ * the trace.  The name and category must be string literals.
+ *
+ *   TraceSpan span ("copy", "install");
+ *   span.setArg ("bytes", stats.numBytes);
+ *
+ * Use isActive() to skip building arguments that aren't cheap.
+ */
+class TraceSpan
+{
+public:
+    TraceSpan (const char* name_, const char* category_ = "jpm")
+        :
+        active (Trace::isEnabled())
+    {
+        if (active)
+        {
+            name = name_;
+            category = category_;
+            start = Trace::getInstance().now();
+        }
+    }
+
+    ~TraceSpan()
+    {
+        if (active)
+            Trace::getInstance().add (name, category, start, Trace::getInstance().now(), args);
+    }
+
+    bool isActive() const
+    {
+        return active;
+    }
+
+    template <typename ValueType>
+    void setArg (const char* argName, const ValueType& value)
+    {
+        if (! active)
+            return;
+
+        if (! args.isObject())
+            args = new DynamicObject();
+
+        args.getDynamicObject()->setProperty (argName, var (value));
+    }
+
+private:
+    bool active;
+    const char* name { nullptr };
+    const char* category { nullptr };
+    double start { 0.0 };
+    var args;
+
+    JUCE_DECLARE_NON_COPYABLE (TraceSpan)
+};
+
+#endif  // TRACE_H_INCLUDED
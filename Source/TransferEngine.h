@@ -0,0 +1,1669 @@
+/*
+  ==============================================================================
+
+    TransferEngine.h
+    Created: 19 Oct 2026 2:27:53pm
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef TRANSFERENGINE_H_INCLUDED
+#define TRANSFERENGINE_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "HttpMessage.h"
+#include "RunReport.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#if JUCE_MAC || JUCE_LINUX
+ #define JPM_NATIVE_HTTP 1
+ #include <errno.h>
+ #include <fcntl.h>
+ #include <netdb.h>
+ #include <netinet/in.h>
+ #include <netinet/tcp.h>
+ #include <poll.h>
+ #include <signal.h>
+ #include <sys/socket.h>
+ #include <unistd.h>
+ #if JUCE_LINUX
+  #include <sys/epoll.h>
+ #endif
+ #include "TlsSession.h"
+#else
+ #define JPM_NATIVE_HTTP 0
+#endif
+
+struct TransferResult
+{
+    int statusCode { 0 };
+    StringPairArray headers;
+    MemoryBlock body;
+    int64 bytesReceived { 0 };
+    double seconds { 0.0 };
+    bool cancelled { false };
+    bool timedOut { false };
+    String error;
+
+    bool succeeded() const
+    {
+        return error.isEmpty() && ! cancelled && ! timedOut && statusCode / 100 == 2;
+    }
+
+    String getBodyAsString() const
+    {
+        return body.toString();
+    }
+
+    /** A one line description of what went wrong, for error messages. */
+    String getFailureReason() const
+    {
+        if (cancelled)
+            return "cancelled";
+
+        if (timedOut)
+            return "timed out";
+
+        if (error.isNotEmpty())
+            return error;
+
+        return "HTTP status " + String (statusCode);
+    }
+};
+
+struct TransferRequest
+{
+    TransferRequest (const URL& url_) : url (url_) {}
+
+    URL url;
+
+    /** "Name: value" lines, as for URL::createInputStream. */
+    String extraHeaders;
+
+    /** The whole transfer is abandoned after this long.  Zero means no limit. */
+    int timeoutMs { 0 };
+
+    /**
+     * If set, the body is written to this file rather than kept in memory.
+     * appendToDestination only takes effect for a 206 Partial Content reply,
+     * so a server that ignores a Range header can't corrupt the file.
+     */
+    File destination;
+    bool appendToDestination { false };
+
+    /**
+     * If set, body data is passed here instead of being stored.  It is called
+     * on the engine's threads so it mustn't block; return false to cancel.
+     */
+    std::function<bool (const void*, size_t)> onData;
+
+    /**
+     * If set, called with the status code and headers just before the first
+     * body data is delivered, on the engine's threads.  Returns how much of
+     * the body to take: -1 for all of it, or a number of bytes after which
+     * the transfer stops and succeeds as if that were the whole body.  Zero
+     * cancels, e.g. when a range was asked for and the whole file is coming
+     * instead.
+     */
+    std::function<int64 (int statusCode, const StringPairArray& headers)> onResponse;
+
+    /** Called on the engine's threads once the transfer has finished. */
+    std::function<void (const TransferResult&)> onComplete;
+
+    /**
+     * Small requests such as API calls can be queued behind others on a
+     * kept-alive connection instead of waiting for one of their own.
+     */
+    bool allowPipelining { false };
+};
+
+class TransferEngine;
+
+/** A transfer in progress.  Hold on to the shared_ptr to wait for or cancel it. */
+class Transfer
+{
+public:
+    Transfer (const TransferRequest& request_, TransferEngine& owner_)
+        :
+        request (request_),
+        owner (owner_),
+        future (promise.get_future().share()),
+        currentUrl (request_.url.toString (true)),
+        startTime (Time::getMillisecondCounterHiRes())
+    {
+        deadline = request.timeoutMs > 0 ? startTime + request.timeoutMs : 0.0;
+    }
+
+    const TransferRequest& getRequest() const
+    {
+        return request;
+    }
+
+    /** Asks the engine to abandon the transfer.  It will complete as cancelled. */
+    void cancel();
+
+    bool isCancelled() const
+    {
+        return cancelled;
+    }
+
+    bool isFinished() const
+    {
+        return finished;
+    }
+
+    /** Returns true if the transfer finished within the time given. */
+    bool waitFor (int milliseconds) const
+    {
+        return future.wait_for (std::chrono::milliseconds (milliseconds)) == std::future_status::ready;
+    }
+
+    /** Blocks until the transfer has finished. */
+    TransferResult wait() const
+    {
+        return future.get();
+    }
+
+    int64 getBytesReceived() const
+    {
+        return bytesReceived;
+    }
+
+    /** The expected size of the body, or -1 if the server didn't say. */
+    int64 getTotalLength() const
+    {
+        return totalLength;
+    }
+
+private:
+    friend class TransferEngine;
+
+    TransferRequest request;
+    TransferEngine& owner;
+
+    std::promise<TransferResult> promise;
+    std::shared_future<TransferResult> future;
+
+    std::atomic<bool> cancelled { false };
+    std::atomic<bool> finished { false };
+    std::atomic<int64> bytesReceived { 0 };
+    std::atomic<int64> totalLength { -1 };
+
+    /* Only touched by whichever engine thread currently owns the transfer. */
+    String currentUrl;
+    int numRedirects { 0 };
+    int numRetries { 0 };
+    double startTime;
+    double deadline { 0.0 };
+    int64 byteLimit { -1 };
+    bool reachedLimit { false };
+    TransferResult result;
+    ScopedPointer<FileOutputStream> output;
+
+    /* On a helper thread the loop thread can complete the transfer while the
+     * helper is blocked in a read, so both hold this to touch the result. */
+    std::mutex helperLock;
+
+    JUCE_DECLARE_NON_COPYABLE (Transfer)
+};
+
+/**
+ * Runs HTTP transfers asynchronously.
+ *
+ * http:// and https:// transfers are driven by a single event loop thread
+ * using non-blocking sockets (epoll on Linux, poll() on the Mac), so any
+ * number can be in flight at once.  https is a TlsSession on top of the same
+ * socket.  Connections are pooled per host and kept alive, so repeated
+ * requests to the same server skip the TCP and TLS handshakes.
+ *
+ * Everything else - all transfers on Windows, and https if no TLS library
+ * could be loaded - goes through URL::createInputStream on a small fixed pool
+ * of helper threads, but completes through the same interface.  None of that
+ * is pooled or pipelined.
+ *
+ * Host names are looked up off the loop thread, and a host's addresses are
+ * tried in the order the system prefers until one connects.
+ *
+ * Every transfer can have a deadline, can be cancelled, and counts the bytes
+ * it receives, both individually and in the engine's totals.
+ */
+class TransferEngine
+{
+public:
+    TransferEngine()
+    {
+        /* complete() reports to the RunReport from the engine's threads, which
+         * run until this is destroyed.  Statics are destroyed in the reverse
+         * order they were made, so making the report first keeps it alive. */
+        RunReport::getInstance();
+
+#if JPM_NATIVE_HTTP
+        if (pipe (wakePipe) == 0)
+        {
+            setNonBlocking (wakePipe[0]);
+            setNonBlocking (wakePipe[1]);
+            poller.add (wakePipe[0], false);
+        }
+#endif
+        loopThread = std::thread ([this] { runLoop(); });
+    }
+
+    ~TransferEngine()
+    {
+        {
+            std::lock_guard<std::mutex> lock (queueLock);
+            shouldExit = true;
+        }
+
+        wakeUp();
+        helperReady.notify_all();
+
+        loopThread.join();
+
+        for (auto& t : helperThreads)
+            t.join();
+
+#if JPM_NATIVE_HTTP
+        for (auto& r : resolvers)
+            r.second.join();
+
+        close (wakePipe[0]);
+        close (wakePipe[1]);
+#endif
+    }
+
+    /** The engine shared by everything in the process. */
+    static TransferEngine& getInstance()
+    {
+        static TransferEngine engine;
+        return engine;
+    }
+
+    /** Starts a transfer and returns immediately. */
+    std::shared_ptr<Transfer> start (const TransferRequest& request)
+    {
+        auto transfer = std::make_shared<Transfer> (request, *this);
+        ++numActive;
+
+        {
+            std::lock_guard<std::mutex> lock (queueLock);
+
+            if (refuseNew)
+                transfer->cancelled = true;
+
+            incoming.push_back (transfer);
+            remember (transfer);
+        }
+
+        wakeUp();
+        return transfer;
+    }
+
+    /**
+     * Cancels every transfer in flight.  Anything started afterwards completes
+     * straight away as cancelled, so this is only for a process on its way
+     * out.  Transfers on helper threads answer straight away too; a thread
+     * still blocked inside URL lets go of it once that returns.
+     */
+    void cancelAll()
+    {
+        std::vector<std::weak_ptr<Transfer>> all;
+
+        {
+            std::lock_guard<std::mutex> lock (queueLock);
+            refuseNew = true;
+            all.swap (started);
+        }
+
+        for (auto& w : all)
+            if (auto t = w.lock())
+                t->cancelled = true;
+
+        wakeUp();
+    }
+
+    /** Starts a transfer and blocks until it's done. */
+    TransferResult fetch (const TransferRequest& request)
+    {
+        return start (request)->wait();
+    }
+
+    /** Convenience for small text documents.  Returns an empty string on failure. */
+    String fetchText (const URL& url, const String& extraHeaders = String(), int timeoutMs = 0)
+    {
+        TransferRequest request (url);
+        request.extraHeaders = extraHeaders;
+        request.timeoutMs = timeoutMs;
+        request.allowPipelining = true;
+
+        auto result = fetch (request);
+        return result.succeeded() ? result.getBodyAsString() : String();
+    }
+
+    int64 getTotalBytesReceived() const
+    {
+        return totalBytesReceived;
+    }
+
+    int getNumActiveTransfers() const
+    {
+        return numActive;
+    }
+
+    /** Requests the event loop made, counting each redirect and retry. */
+    int getNumRequests() const
+    {
+        return numRequests;
+    }
+
+    /** Connections the event loop opened, i.e. TCP handshakes paid for, plus a TLS one for https. */
+    int getNumConnectionsOpened() const
+    {
+        return numConnectionsOpened;
+    }
+
+    /**
+     * Requests made on the helper threads, which is everything on Windows.
+     * These aren't pooled: URL opens and closes its own connection for each
+     * one, out of our sight, so they're counted separately.
+     */
+    int getNumUnpooledRequests() const
+    {
+        return numUnpooledRequests;
+    }
+
+    /**
+     * Lets more transfers run on the helper threads, i.e. more at once on Windows,
+     * for as long as it exists.  For a caller that fires off a burst of small
+     * requests and waits for all of them; the extra threads are only started
+     * if there's work for them.
+     */
+    class ExtraHelpers
+    {
+    public:
+        ExtraHelpers (TransferEngine& engine_, int numExtra_)
+            : engine (engine_), numExtra (jmax (0, numExtra_))
+        {
+            engine.numExtraHelperThreads += numExtra;
+        }
+
+        ~ExtraHelpers()
+        {
+            engine.numExtraHelperThreads -= numExtra;
+        }
+
+    private:
+        TransferEngine& engine;
+        const int numExtra;
+
+        JUCE_DECLARE_NON_COPYABLE (ExtraHelpers)
+    };
+
+    /** Prods the event loop so it notices new work or cancellations. */
+    void wakeUp()
+    {
+#if JPM_NATIVE_HTTP
+        const char c = 0;
+        ignoreUnused (write (wakePipe[1], &c, 1));
+#endif
+        loopWakeup.notify_all();
+    }
+
+private:
+    static const int maxRedirects = 5;
+    static const int numHelperThreads = 8;
+    static const int maxConnectionsPerHost = 6;
+    static const int maxPipelineDepth = 8;
+    static const int idleTimeoutMs = 30000;
+    static const int resolvedLifetimeMs = 60000;
+    static const int connectFallbackMs = 2000;
+
+    /** Keeps track of unfinished transfers for cancelAll().  Called with queueLock held. */
+    void remember (const std::shared_ptr<Transfer>& transfer)
+    {
+        if (started.size() >= startedCapacity)
+        {
+            started.erase (std::remove_if (started.begin(), started.end(), [] (const std::weak_ptr<Transfer>& w)
+            {
+                auto t = w.lock();
+                return t == nullptr || t->isFinished();
+            }), started.end());
+
+            startedCapacity = jmax ((size_t) 64, started.size() * 2);
+        }
+
+        started.push_back (transfer);
+    }
+
+    //==============================================================================
+    static bool usesNativeTransport (const String& url)
+    {
+        ignoreUnused (url);
+#if JPM_NATIVE_HTTP
+        const auto scheme = HttpUrl (url).scheme;
+        return scheme == "http" || (scheme == "https" && TlsSession::isAvailable());
+#else
+        return false;
+#endif
+    }
+
+    void runLoop()
+    {
+#if JPM_NATIVE_HTTP && JUCE_LINUX
+        /* OpenSSL writes to the socket without MSG_NOSIGNAL, so a peer that
+         * hangs up would otherwise kill the process. */
+        sigset_t signals;
+        sigemptyset (&signals);
+        sigaddset (&signals, SIGPIPE);
+        pthread_sigmask (SIG_BLOCK, &signals, nullptr);
+#endif
+
+        while (! shouldExit)
+        {
+            std::deque<std::shared_ptr<Transfer>> newTransfers;
+
+            {
+                std::lock_guard<std::mutex> lock (queueLock);
+                newTransfers.swap (incoming);
+            }
+
+            for (auto& t : newTransfers)
+                dispatch (t);
+
+            abandonOverdueHelperTransfers();
+
+#if JPM_NATIVE_HTTP
+            collectResolved();
+            expireConnections();
+
+            Array<SocketPoller::Event> events;
+            poller.wait (jmin (getPollTimeout(), getHelperTimeout()), events);
+
+            for (auto& e : events)
+            {
+                if (e.fd == wakePipe[0])
+                {
+                    char buffer[64];
+
+                    while (read (wakePipe[0], buffer, sizeof (buffer)) > 0) {}
+
+                    continue;
+                }
+
+                auto it = connections.find (e.fd);
+
+                if (it != connections.end())
+                    handleEvent (*it->second, e);
+            }
+#else
+            const int timeout = getHelperTimeout();
+            std::unique_lock<std::mutex> lock (queueLock);
+            loopWakeup.wait_for (lock, std::chrono::milliseconds (timeout),
+                                 [this] { return shouldExit || ! incoming.empty(); });
+#endif
+        }
+
+#if JPM_NATIVE_HTTP
+        closeAllConnections();
+#endif
+
+        /* Started too late to be looked at; they still get an answer. */
+        std::deque<std::shared_ptr<Transfer>> unstarted;
+
+        {
+            std::lock_guard<std::mutex> lock (queueLock);
+            unstarted.swap (incoming);
+        }
+
+        for (auto& t : unstarted)
+        {
+            t->cancelled = true;
+            complete (*t);
+        }
+    }
+
+    /** Called on the loop thread for new transfers and redirects. */
+    void dispatch (std::shared_ptr<Transfer> transfer)
+    {
+        if (transfer->cancelled)
+        {
+            complete (*transfer);
+            return;
+        }
+
+        if (usesNativeTransport (transfer->currentUrl))
+        {
+#if JPM_NATIVE_HTTP
+            dispatchNative (transfer);
+#endif
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock (queueLock);
+
+        /* A thread stuck in a read the loop has given up on doesn't count. */
+        const size_t maxHelpers = (size_t) (numHelperThreads + numExtraHelperThreads + numAbandonedHelpers);
+
+        while (helperThreads.size() < maxHelpers && helperThreads.size() <= helperQueue.size())
+            helperThreads.push_back (std::thread ([this] { runHelper(); }));
+
+        helperQueue.push_back (transfer);
+        helperReady.notify_one();
+    }
+
+    //==============================================================================
+    /**
+     * Passes body data on, up to any limit onResponse set.  Returns false to
+     * stop the transfer, with reachedLimit set if it stopped at that limit.
+     */
+    bool deliver (Transfer& t, const char* data, int size)
+    {
+        if (size <= 0)
+            return true;
+
+        if (t.bytesReceived == 0 && t.request.onResponse)
+        {
+            t.byteLimit = t.request.onResponse (t.result.statusCode, t.result.headers);
+
+            if (t.byteLimit == 0)
+                return false;
+        }
+
+        if (t.byteLimit < 0)
+            return store (t, data, size);
+
+        size = (int) jmin ((int64) size, t.byteLimit - t.bytesReceived);
+        t.reachedLimit = t.bytesReceived + size >= t.byteLimit;
+
+        return store (t, data, size) && ! t.reachedLimit;
+    }
+
+    /** Passes body data to wherever the request wants it. */
+    bool store (Transfer& t, const char* data, int size)
+    {
+        t.bytesReceived += size;
+        t.result.bytesReceived += size;
+        totalBytesReceived += size;
+
+        if (t.request.onData)
+            return t.request.onData (data, (size_t) size);
+
+        if (t.request.destination != File::nonexistent)
+        {
+            if (t.output == nullptr)
+            {
+                if (! (t.request.appendToDestination && t.result.statusCode == 206))
+                    t.request.destination.deleteFile();
+
+                t.output = new FileOutputStream (t.request.destination);
+
+                if (t.output->failedToOpen())
+                {
+                    t.result.error = "could not write " + t.request.destination.getFullPathName();
+                    return false;
+                }
+            }
+
+            return t.output->write (data, (size_t) size);
+        }
+
+        t.result.body.append (data, (size_t) size);
+        return true;
+    }
+
+    /** Resolves the promise.  Called exactly once per transfer. */
+    void complete (Transfer& t)
+    {
+        t.output = nullptr;
+        t.result.cancelled = t.cancelled;
+        t.result.seconds = (Time::getMillisecondCounterHiRes() - t.startTime) / 1000.0;
+
+        /* A hedge that lost the race was cancelled, not failed. */
+        RunReport::getInstance().addRequest (HttpUrl (t.currentUrl).host, t.result.bytesReceived,
+                                             t.result.succeeded() || t.result.cancelled || t.result.statusCode == 304);
+
+        if (t.request.onComplete)
+            t.request.onComplete (t.result);
+
+        t.finished = true;
+        --numActive;
+        t.promise.set_value (t.result);
+    }
+
+    bool isPastDeadline (const Transfer& t) const
+    {
+        return t.deadline > 0.0 && Time::getMillisecondCounterHiRes() > t.deadline;
+    }
+
+    //==============================================================================
+    /* The blocking path, for anything the event loop can't speak. */
+    void runHelper()
+    {
+        for (;;)
+        {
+            std::shared_ptr<Transfer> transfer;
+
+            {
+                std::unique_lock<std::mutex> lock (queueLock);
+                helperReady.wait (lock, [this] { return shouldExit || ! helperQueue.empty(); });
+
+                if (shouldExit)
+                {
+                    /* Whoever is waiting on these must still hear back. */
+                    std::deque<std::shared_ptr<Transfer>> abandoned;
+                    abandoned.swap (helperQueue);
+                    lock.unlock();
+
+                    for (auto& t : abandoned)
+                    {
+                        t->cancelled = true;
+                        complete (*t);
+                    }
+
+                    return;
+                }
+
+                transfer = helperQueue.front();
+                helperQueue.pop_front();
+            }
+
+            runBlockingTransfer (transfer);
+        }
+    }
+
+    /**
+     * URL blocks, so the helper only holds the transfer's helperLock between
+     * calls into it, and gives up quietly if the loop thread has completed
+     * the transfer meanwhile.  The time left before the deadline is passed to
+     * URL, which bounds the connect and each read by it.
+     */
+    void runBlockingTransfer (std::shared_ptr<Transfer> transfer)
+    {
+        auto& t = *transfer;
+
+        {
+            std::lock_guard<std::mutex> lock (queueLock);
+            helperTransfers.push_back (transfer);
+        }
+
+        ScopedPointer<InputStream> in;
+        StringPairArray headers;
+        int statusCode = 0;
+
+        if (! t.cancelled)
+        {
+            int timeout = 0;
+
+            if (t.deadline > 0.0)
+                timeout = jmax (1, (int) (t.deadline - Time::getMillisecondCounterHiRes()));
+
+            in = URL (t.currentUrl).createInputStream (false, nullptr, nullptr, t.request.extraHeaders,
+                                                       timeout, &headers, &statusCode);
+            ++numUnpooledRequests;
+        }
+
+        std::unique_lock<std::mutex> lock (t.helperLock);
+
+        if (! t.finished)
+        {
+            t.result.headers = headers;
+            t.result.statusCode = statusCode;
+
+            if (in != nullptr)
+                t.totalLength = in->getTotalLength();
+            else if (! t.cancelled)
+                t.result.error = "could not connect to " + HttpUrl (t.currentUrl).host;
+        }
+
+        HeapBlock<char> buffer (65536);
+
+        while (in != nullptr && ! t.finished && ! t.cancelled)
+        {
+            if (isPastDeadline (t))
+            {
+                t.result.timedOut = true;
+                break;
+            }
+
+            lock.unlock();
+            auto n = in->read (buffer, 65536);
+            lock.lock();
+
+            if (t.finished)
+                break;
+
+            /* URL ends a dropped connection the same way as a finished body. */
+            if (n <= 0)
+            {
+                if (! in->isExhausted() || (t.totalLength >= 0 && t.bytesReceived < t.totalLength))
+                    t.result.error = "connection closed early";
+
+                break;
+            }
+
+            if (! deliver (t, buffer, n))
+            {
+                t.cancelled = t.result.error.isEmpty() && ! t.reachedLimit;
+                break;
+            }
+        }
+
+        if (t.finished)
+            --numAbandonedHelpers;
+        else
+            complete (t);
+
+        lock.unlock();
+
+        std::lock_guard<std::mutex> queue (queueLock);
+        helperTransfers.erase (std::remove (helperTransfers.begin(), helperTransfers.end(), transfer),
+                               helperTransfers.end());
+    }
+
+    /**
+     * Completes helper transfers that are cancelled or past their deadline as
+     * such, even though their threads may be blocked in a read, so nobody
+     * waits on URL.  Until a thread comes back, dispatch() can start another
+     * in its place.
+     */
+    void abandonOverdueHelperTransfers()
+    {
+        std::vector<std::shared_ptr<Transfer>> overdue;
+
+        {
+            std::lock_guard<std::mutex> lock (queueLock);
+
+            for (auto& t : helperTransfers)
+                if (! t->isFinished() && (t->cancelled || isPastDeadline (*t)))
+                    overdue.push_back (t);
+        }
+
+        for (auto& t : overdue)
+        {
+            std::lock_guard<std::mutex> lock (t->helperLock);
+
+            if (t->finished)
+                continue;
+
+            t->result.timedOut = ! t->cancelled;
+            ++numAbandonedHelpers;
+            complete (*t);
+        }
+    }
+
+    /** How long the loop can sleep before a helper transfer's deadline, at most half a second. */
+    int getHelperTimeout()
+    {
+        double timeout = 500.0;
+        auto now = Time::getMillisecondCounterHiRes();
+
+        std::lock_guard<std::mutex> lock (queueLock);
+
+        for (auto& t : helperTransfers)
+            if (t->deadline > 0.0 && ! t->isFinished())
+                timeout = jmin (timeout, t->deadline - now);
+
+        return jmax (0, (int) timeout);
+    }
+
+#if JPM_NATIVE_HTTP
+    //==============================================================================
+    /** Thin wrapper so the loop doesn't care whether it has epoll or poll. */
+    class SocketPoller
+    {
+    public:
+        struct Event
+        {
+            int fd;
+            bool readable;
+            bool writable;
+            bool failed;
+        };
+
+       #if JUCE_LINUX
+        SocketPoller() : epollFd (epoll_create1 (EPOLL_CLOEXEC)) {}
+        ~SocketPoller() { close (epollFd); }
+
+        void add (int fd, bool wantWrite)       { control (EPOLL_CTL_ADD, fd, wantWrite); }
+        void modify (int fd, bool wantWrite)    { control (EPOLL_CTL_MOD, fd, wantWrite); }
+        void remove (int fd)                    { control (EPOLL_CTL_DEL, fd, false); }
+
+        void wait (int timeoutMs, Array<Event>& events)
+        {
+            epoll_event ready[64];
+            const int n = epoll_wait (epollFd, ready, 64, timeoutMs);
+
+            for (int i = 0; i < n; ++i)
+            {
+                Event e = { ready[i].data.fd,
+                            (ready[i].events & (EPOLLIN | EPOLLHUP)) != 0,
+                            (ready[i].events & EPOLLOUT) != 0,
+                            (ready[i].events & EPOLLERR) != 0 };
+                events.add (e);
+            }
+        }
+
+    private:
+        void control (int operation, int fd, bool wantWrite)
+        {
+            epoll_event e;
+            zerostruct (e);
+            e.events = EPOLLIN | (wantWrite ? EPOLLOUT : 0);
+            e.data.fd = fd;
+            epoll_ctl (epollFd, operation, fd, &e);
+        }
+
+        int epollFd;
+       #else
+        void add (int fd, bool wantWrite)       { interest[fd] = wantWrite; }
+        void modify (int fd, bool wantWrite)    { interest[fd] = wantWrite; }
+        void remove (int fd)                    { interest.erase (fd); }
+
+        void wait (int timeoutMs, Array<Event>& events)
+        {
+            std::vector<pollfd> fds;
+
+            for (auto& i : interest)
+            {
+                pollfd p = { i.first, (short) (POLLIN | (i.second ? POLLOUT : 0)), 0 };
+                fds.push_back (p);
+            }
+
+            if (poll (fds.data(), (nfds_t) fds.size(), timeoutMs) <= 0)
+                return;
+
+            for (auto& p : fds)
+            {
+                if (p.revents == 0)
+                    continue;
+
+                Event e = { p.fd,
+                            (p.revents & (POLLIN | POLLHUP)) != 0,
+                            (p.revents & POLLOUT) != 0,
+                            (p.revents & (POLLERR | POLLNVAL)) != 0 };
+                events.add (e);
+            }
+        }
+
+    private:
+        std::map<int, bool> interest;
+       #endif
+    };
+
+    //==============================================================================
+    /** A host's addresses, as getaddrinfo gave them. */
+    struct Address
+    {
+        sockaddr_storage storage;
+        socklen_t length;
+        int family;
+    };
+
+    typedef std::vector<Address> Addresses;
+
+    struct Resolved
+    {
+        std::shared_ptr<const Addresses> addresses;
+        double time;
+    };
+
+    /*
+     * The connection pool.  Connections stay open after a response and are
+     * shared by every transfer going to the same host and port, up to
+     * maxConnectionsPerHost.  Requests that allow it are pipelined onto a
+     * connection that has already proven it supports keep-alive, and anything
+     * that can't be placed waits for a connection to come free.
+     */
+    struct Connection
+    {
+        int fd { -1 };
+        String key;
+        bool connected { false };
+        bool hasCompletedResponse { false };
+        bool headHasReceivedData { false };
+        MemoryBlock output;
+        size_t numSent { 0 };
+        HttpResponseParser parser;
+        std::deque<std::shared_ptr<Transfer>> inFlight;
+        double idleSince { 0.0 };
+        std::shared_ptr<const Addresses> addresses;
+        size_t nextAddress { 0 };
+        double connectStarted { 0.0 };
+        bool watchingForWrite { false };
+
+        /* For https: the session starts once TCP has connected, and requests
+         * wait in output until its handshake is done. */
+        bool secure { false };
+        bool secured { false };
+        String host;
+        std::unique_ptr<TlsSession> tls;
+    };
+
+    static void setNonBlocking (int fd)
+    {
+        fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK);
+        fcntl (fd, F_SETFD, FD_CLOEXEC);
+    }
+
+    void dispatchNative (std::shared_ptr<Transfer> transfer)
+    {
+        HttpUrl url (transfer->currentUrl);
+        auto key = url.getConnectionKey();
+
+        Connection* idle = nullptr;
+        Connection* pipeline = nullptr;
+        int numForHost = 0;
+
+        for (auto& i : connections)
+        {
+            auto& c = *i.second;
+
+            if (c.key != key)
+                continue;
+
+            ++numForHost;
+
+            if (c.inFlight.empty())
+            {
+                idle = &c;
+                break;
+            }
+
+            if (canPipelineOnto (c, *transfer) && (pipeline == nullptr || c.inFlight.size() < pipeline->inFlight.size()))
+                pipeline = &c;
+        }
+
+        if (idle != nullptr)
+            return sendRequest (*idle, transfer);
+
+        if (pipeline != nullptr)
+            return sendRequest (*pipeline, transfer);
+
+        if (numForHost < maxConnectionsPerHost)
+        {
+            auto addresses = lookUp (url, transfer);
+
+            if (addresses != nullptr)
+                if (auto* c = openConnection (url, addresses, *transfer))
+                    sendRequest (*c, transfer);
+
+            return;
+        }
+
+        waiting[key].push_back (transfer);
+    }
+
+    static bool canPipelineOnto (const Connection& c, const Transfer& t)
+    {
+        if (! t.request.allowPipelining || ! c.hasCompletedResponse || (int) c.inFlight.size() >= maxPipelineDepth)
+            return false;
+
+        for (auto& other : c.inFlight)
+            if (! other->request.allowPipelining)
+                return false;
+
+        return true;
+    }
+
+    /**
+     * Looks up the host on a thread of its own, as getaddrinfo blocks.  The
+     * answer is cached for a minute, and transfers that arrive meanwhile wait
+     * for it.  Returns nullptr if the transfer is waiting or has failed.
+     */
+    std::shared_ptr<const Addresses> lookUp (const HttpUrl& url, std::shared_ptr<Transfer> transfer)
+    {
+        const auto key = url.getConnectionKey();
+        auto known = resolved.find (key);
+
+        if (known != resolved.end() && Time::getMillisecondCounterHiRes() - known->second.time < resolvedLifetimeMs)
+            return known->second.addresses;
+
+        if (! url.isValid())
+        {
+            transfer->result.error = "could not resolve " + url.host;
+            complete (*transfer);
+            return nullptr;
+        }
+
+        waiting[key].push_back (transfer);
+
+        if (resolvers.count (key) == 0)
+        {
+            const auto host = url.host;
+            const auto port = String (url.port);
+
+            resolvers[key] = std::thread ([this, key, host, port]
+            {
+                auto addresses = resolve (host, port);
+
+                std::lock_guard<std::mutex> lock (queueLock);
+                justResolved.push_back (std::make_pair (key, addresses));
+                wakeUp();
+            });
+        }
+
+        return nullptr;
+    }
+
+    static std::shared_ptr<const Addresses> resolve (const String& host, const String& port)
+    {
+        addrinfo hints;
+        zerostruct (hints);
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo* info = nullptr;
+        auto addresses = std::make_shared<Addresses>();
+
+        if (getaddrinfo (host.toRawUTF8(), port.toRawUTF8(), &hints, &info) != 0)
+            return addresses;
+
+        /* Already in the order the system prefers, per RFC 6724. */
+        for (auto* i = info; i != nullptr; i = i->ai_next)
+        {
+            Address a;
+            zerostruct (a.storage);
+            memcpy (&a.storage, i->ai_addr, i->ai_addrlen);
+            a.length = i->ai_addrlen;
+            a.family = i->ai_family;
+            addresses->push_back (a);
+        }
+
+        freeaddrinfo (info);
+        return addresses;
+    }
+
+    /** Picks up finished lookups and lets the transfers waiting on them go. */
+    void collectResolved()
+    {
+        std::vector<std::pair<String, std::shared_ptr<const Addresses>>> results;
+
+        {
+            std::lock_guard<std::mutex> lock (queueLock);
+            results.swap (justResolved);
+        }
+
+        for (auto& r : results)
+        {
+            auto thread = resolvers.find (r.first);
+            thread->second.join();
+            resolvers.erase (thread);
+
+            if (r.second->empty())
+            {
+                auto queue = waiting[r.first];
+                waiting.erase (r.first);
+
+                for (auto& t : queue)
+                {
+                    t->result.error = "could not resolve " + HttpUrl (t->currentUrl).host;
+                    complete (*t);
+                }
+
+                continue;
+            }
+
+            Resolved entry = { r.second, Time::getMillisecondCounterHiRes() };
+            resolved[r.first] = entry;
+            serviceWaiting (r.first);
+        }
+    }
+
+    Connection* openConnection (const HttpUrl& url, const std::shared_ptr<const Addresses>& addresses, Transfer& transfer)
+    {
+        std::unique_ptr<Connection> c (new Connection());
+        c->key = url.getConnectionKey();
+        c->addresses = addresses;
+        c->secure = url.scheme == "https";
+        c->host = url.host;
+
+        if (! connectToNextAddress (*c))
+        {
+            transfer.result.error = "could not connect to " + url.host;
+            complete (transfer);
+            return nullptr;
+        }
+
+        auto* raw = c.get();
+        connections[c->fd] = std::move (c);
+        ++numConnectionsOpened;
+
+        return raw;
+    }
+
+    /**
+     * Starts connecting to the next address the host has.  A later attempt
+     * reuses the connection's fd number, so the connection keeps its place in
+     * the pool along with anything already queued on it.  Returns false once
+     * every address has been tried.
+     */
+    bool connectToNextAddress (Connection& c)
+    {
+        while (c.nextAddress < c.addresses->size())
+        {
+            const auto& a = (*c.addresses)[c.nextAddress++];
+            const int fd = socket (a.family, SOCK_STREAM, 0);
+
+            if (fd < 0)
+                continue;
+
+            setNonBlocking (fd);
+
+            int one = 1;
+            setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one));
+           #ifdef SO_NOSIGPIPE
+            setsockopt (fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof (one));
+           #endif
+
+            if (connect (fd, reinterpret_cast<const sockaddr*> (&a.storage), a.length) != 0 && errno != EINPROGRESS)
+            {
+                close (fd);
+                continue;
+            }
+
+            if (c.fd < 0)
+            {
+                c.fd = fd;
+            }
+            else
+            {
+                poller.remove (c.fd);
+                dup2 (fd, c.fd);
+                close (fd);
+                setNonBlocking (c.fd);
+            }
+
+            poller.add (c.fd, true);
+            c.watchingForWrite = true;
+            c.numSent = 0;
+            c.connectStarted = Time::getMillisecondCounterHiRes();
+            return true;
+        }
+
+        return false;
+    }
+
+    void sendRequest (Connection& c, std::shared_ptr<Transfer> transfer)
+    {
+        auto head = formatHttpRequest ("GET", HttpUrl (transfer->currentUrl), transfer->request.extraHeaders, true);
+        c.output.append (head.toRawUTF8(), head.getNumBytesAsUTF8());
+
+        if (c.inFlight.empty())
+        {
+            c.parser.reset();
+            c.headHasReceivedData = false;
+        }
+
+        c.inFlight.push_back (transfer);
+        ++numRequests;
+
+        watchForWrite (c, true);
+    }
+
+    void watchForWrite (Connection& c, bool shouldWatch)
+    {
+        if (c.watchingForWrite != shouldWatch)
+        {
+            c.watchingForWrite = shouldWatch;
+            poller.modify (c.fd, shouldWatch);
+        }
+    }
+
+    void handleEvent (Connection& c, const SocketPoller::Event& e)
+    {
+        if (! c.connected && (e.writable || e.failed))
+        {
+            int error = 0;
+            socklen_t length = sizeof (error);
+            getsockopt (c.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+
+            if (error != 0)
+            {
+                if (connectToNextAddress (c))
+                    return;
+
+                return closeConnection (c, "could not connect to " + c.key);
+            }
+
+            c.connected = true;
+
+            if (c.secure)
+                c.tls.reset (new TlsSession (c.fd, c.host));
+        }
+
+        if (c.tls != nullptr && ! c.secured)
+        {
+            const auto status = c.tls->handshake();
+
+            if (status == TlsSession::failed)
+                return closeConnection (c, c.tls->getError());
+
+            if (status == TlsSession::closed)
+                return closeConnection (c, "TLS handshake with " + c.host + " failed: connection closed");
+
+            if (status != TlsSession::done)
+                return watchForWrite (c, status == TlsSession::wantWrite);
+
+            c.secured = true;
+        }
+
+        /* TLS can want to read in order to write and the other way round, so
+         * a secure connection tries both on any event. */
+        if (c.connected && (c.tls != nullptr || e.writable) && ! sendOutput (c))
+            return;
+
+        if (e.readable || e.failed || c.tls != nullptr)
+            readFromConnection (c);
+    }
+
+    /** Sends as much of the queued requests as the socket takes.  Returns false if that closed the connection. */
+    bool sendOutput (Connection& c)
+    {
+        auto status = c.tls != nullptr && c.tls->hasBufferedOutput() ? c.tls->flush() : TlsSession::done;
+
+        while (status == TlsSession::done && c.numSent < c.output.getSize())
+        {
+            size_t n = 0;
+            status = sendSome (c, static_cast<const char*> (c.output.getData()) + c.numSent,
+                               c.output.getSize() - c.numSent, n);
+
+            if (status == TlsSession::done)
+                c.numSent += n;
+        }
+
+        if (status == TlsSession::failed || status == TlsSession::closed)
+        {
+            closeConnection (c, c.tls != nullptr && c.tls->getError().isNotEmpty() ? c.tls->getError()
+                                                                                    : String ("connection lost"));
+            return false;
+        }
+
+        if (c.numSent == c.output.getSize())
+        {
+            c.output.setSize (0);
+            c.numSent = 0;
+        }
+
+        watchForWrite (c, status == TlsSession::wantWrite || c.numSent < c.output.getSize());
+        return true;
+    }
+
+    /** send(), through TLS for https, with the result in TlsSession's terms. */
+    static TlsSession::Status sendSome (Connection& c, const char* data, size_t size, size_t& numSent)
+    {
+        if (c.tls != nullptr)
+            return c.tls->write (data, size, numSent);
+
+       #ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+       #else
+        const int flags = 0;
+       #endif
+
+        auto n = send (c.fd, data, size, flags);
+
+        if (n > 0)
+        {
+            numSent = (size_t) n;
+            return TlsSession::done;
+        }
+
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? TlsSession::wantWrite
+                                                                                   : TlsSession::failed;
+    }
+
+    /** recv(), through TLS for https, with the result in TlsSession's terms. */
+    static TlsSession::Status receiveSome (Connection& c, char* data, size_t size, size_t& numReceived)
+    {
+        if (c.tls != nullptr)
+            return c.tls->read (data, size, numReceived);
+
+        auto n = recv (c.fd, data, size, 0);
+
+        if (n > 0)
+        {
+            numReceived = (size_t) n;
+            return TlsSession::done;
+        }
+
+        if (n == 0)
+            return TlsSession::closed;
+
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? TlsSession::wantRead
+                                                                         : TlsSession::failed;
+    }
+
+    /** Reads everything available.  Responses arrive in request order, so a
+     * buffer can finish one pipelined response and start the next. */
+    void readFromConnection (Connection& c)
+    {
+        char buffer[65536];
+
+        for (;;)
+        {
+            size_t received = 0;
+            const auto status = receiveSome (c, buffer, sizeof (buffer), received);
+
+            if (status == TlsSession::wantRead)
+                return;
+
+            if (status == TlsSession::wantWrite)
+                return watchForWrite (c, true);
+
+            if (status == TlsSession::failed)
+                return closeConnection (c, c.tls != nullptr ? c.tls->getError() : String ("connection lost"));
+
+            if (status == TlsSession::closed)
+            {
+                c.parser.connectionClosed();
+
+                if (! c.inFlight.empty() && c.parser.isComplete() && ! finishHeadResponse (c))
+                    return;
+
+                return closeConnection (c, "connection closed early");
+            }
+
+            const int n = (int) received;
+            int pos = 0;
+
+            while (pos < n)
+            {
+                if (c.inFlight.empty())
+                    return closeConnection (c, String()); /* Nothing asked for this. */
+
+                auto& t = *c.inFlight.front();
+                bool keepGoing = true;
+
+                pos += c.parser.feed (buffer + pos, n - pos, [&] (const char* data, int size)
+                {
+                    if (keepGoing && ! isRedirect (c.parser.getStatusCode(), c.parser.getHeaders()))
+                    {
+                        if (t.bytesReceived == 0)
+                            t.result.headers = c.parser.getHeaders();
+
+                        t.result.statusCode = c.parser.getStatusCode();
+                        keepGoing = deliver (t, data, size);
+                    }
+                });
+
+                c.headHasReceivedData = true;
+
+                if (c.parser.hasHeaders() && t.totalLength < 0)
+                    t.totalLength = c.parser.getContentLength();
+
+                if (! keepGoing)
+                {
+                    t.cancelled = t.result.error.isEmpty() && ! t.reachedLimit;
+                    return closeConnection (c, t.result.error);
+                }
+
+                if (c.parser.hasError())
+                    return closeConnection (c, "malformed HTTP response");
+
+                if (c.parser.isComplete() && ! finishHeadResponse (c))
+                    return;
+            }
+        }
+    }
+
+    static bool isRedirect (int status, const StringPairArray& headers)
+    {
+        return (status == 301 || status == 302 || status == 303 || status == 307 || status == 308)
+               && headers["Location"].isNotEmpty();
+    }
+
+    /** Completes the transfer at the front of the connection, or follows its redirect. */
+    void completeResponse (std::shared_ptr<Transfer> transfer, int status, const StringPairArray& headers)
+    {
+        auto& t = *transfer;
+
+        if (isRedirect (status, headers) && ! t.cancelled && t.numRedirects < maxRedirects)
+        {
+            t.currentUrl = HttpUrl (t.currentUrl).resolve (headers["Location"]);
+            ++t.numRedirects;
+            dispatch (transfer);
+            return;
+        }
+
+        t.result.statusCode = status;
+        t.result.headers = headers;
+        complete (t);
+    }
+
+    /**
+     * Called when the response at the front of the connection is complete.
+     * Returns false if that closed the connection, in which case it has been
+     * deleted.
+     */
+    bool finishHeadResponse (Connection& c)
+    {
+        const int fd = c.fd;
+        auto transfer = c.inFlight.front();
+        c.inFlight.pop_front();
+
+        const bool reusable = c.parser.canReuseConnection();
+        const int status = c.parser.getStatusCode();
+        const StringPairArray headers (c.parser.getHeaders());
+
+        c.hasCompletedResponse = true;
+        c.parser.reset();
+        c.headHasReceivedData = false;
+
+        if (! reusable)
+        {
+            closeConnection (c, String());
+            completeResponse (transfer, status, headers);
+            return false;
+        }
+
+        if (c.inFlight.empty())
+            c.idleSince = Time::getMillisecondCounterHiRes();
+
+        completeResponse (transfer, status, headers);
+
+        if (connections.count (fd) == 0)
+            return false;
+
+        if (c.inFlight.empty())
+            serviceWaiting (c.key);
+
+        return connections.count (fd) != 0;
+    }
+
+    /**
+     * Closes a connection.  The transfer at the front fails with the error
+     * given, unless it was a request on a reused connection that the server
+     * had already dropped, which is retried once.  Anything pipelined behind
+     * it never got an answer and is retried.
+     */
+    void closeConnection (Connection& c, const String& error)
+    {
+        const int fd = c.fd;
+        const auto key = c.key;
+        const bool staleReuse = c.hasCompletedResponse && ! c.headHasReceivedData;
+        const int status = c.parser.getStatusCode();
+        const StringPairArray headers (c.parser.getHeaders());
+        auto pending = c.inFlight;
+
+        poller.remove (fd);
+        close (fd);
+        connections.erase (fd); /* c is gone after this. */
+
+        for (size_t i = 0; i < pending.size(); ++i)
+        {
+            auto& t = *pending[i];
+
+            if (i == 0 && status != 0)
+            {
+                t.result.statusCode = status;
+                t.result.headers = headers;
+            }
+
+            if (t.cancelled || t.result.timedOut || t.reachedLimit)
+            {
+                complete (t);
+            }
+            else if (i > 0 || (staleReuse && t.numRetries++ == 0))
+            {
+                dispatch (pending[i]);
+            }
+            else
+            {
+                t.result.error = error.isNotEmpty() ? error : String ("connection closed");
+                complete (t);
+            }
+        }
+
+        serviceWaiting (key);
+    }
+
+    /** Gives parked transfers another chance at a connection. */
+    void serviceWaiting (const String& key)
+    {
+        auto it = waiting.find (key);
+
+        if (it == waiting.end())
+            return;
+
+        auto queue = it->second;
+        waiting.erase (it);
+
+        for (auto& t : queue)
+            dispatch (t);
+    }
+
+    /** Enforces cancellation, deadlines and the idle timeout. */
+    void expireConnections()
+    {
+        const double now = Time::getMillisecondCounterHiRes();
+        Array<int> expired;
+
+        for (auto& i : connections)
+        {
+            auto& c = *i.second;
+
+            /* An address that doesn't answer, like IPv6 on a network that
+             * drops it, shouldn't hold up the ones after it. */
+            if (! c.connected && c.nextAddress < c.addresses->size() && now - c.connectStarted > connectFallbackMs)
+                connectToNextAddress (c);
+            bool expire = c.inFlight.empty() && now - c.idleSince > idleTimeoutMs;
+
+            for (auto& t : c.inFlight)
+            {
+                if (! t->cancelled && isPastDeadline (*t))
+                    t->result.timedOut = true;
+
+                expire = expire || t->cancelled || t->result.timedOut;
+            }
+
+            if (expire)
+                expired.add (i.first);
+        }
+
+        for (auto fd : expired)
+            if (connections.count (fd) != 0)
+                closeConnection (*connections[fd], String());
+
+        for (auto& w : waiting)
+        {
+            std::deque<std::shared_ptr<Transfer>> stillWaiting;
+
+            for (auto& t : w.second)
+            {
+                if (! t->cancelled && isPastDeadline (*t))
+                    t->result.timedOut = true;
+
+                if (t->cancelled || t->result.timedOut)
+                    complete (*t);
+                else
+                    stillWaiting.push_back (t);
+            }
+
+            w.second.swap (stillWaiting);
+        }
+    }
+
+    int getPollTimeout() const
+    {
+        double timeout = 500.0;
+        auto now = Time::getMillisecondCounterHiRes();
+
+        for (auto& c : connections)
+            for (auto& t : c.second->inFlight)
+                if (t->deadline > 0.0)
+                    timeout = jmin (timeout, t->deadline - now);
+
+        for (auto& w : waiting)
+            for (auto& t : w.second)
+                if (t->deadline > 0.0)
+                    timeout = jmin (timeout, t->deadline - now);
+
+        return jmax (0, (int) timeout);
+    }
+
+    void closeAllConnections()
+    {
+        for (auto& w : waiting)
+            for (auto& t : w.second)
+                t->cancelled = true;
+
+        for (auto& c : connections)
+            for (auto& t : c.second->inFlight)
+                t->cancelled = true;
+
+        expireConnections();
+
+        while (! connections.empty())
+            closeConnection (*connections.begin()->second, String());
+    }
+
+    SocketPoller poller;
+    int wakePipe[2] { -1, -1 };
+    std::map<int, std::unique_ptr<Connection>> connections;
+    std::map<String, std::deque<std::shared_ptr<Transfer>>> waiting;
+    std::map<String, Resolved> resolved;
+    std::map<String, std::thread> resolvers;
+    std::vector<std::pair<String, std::shared_ptr<const Addresses>>> justResolved;
+#endif
+
+    //==============================================================================
+    std::mutex queueLock;
+    std::condition_variable loopWakeup;
+    std::condition_variable helperReady;
+    std::deque<std::shared_ptr<Transfer>> incoming;
+    std::deque<std::shared_ptr<Transfer>> helperQueue;
+    std::vector<std::shared_ptr<Transfer>> helperTransfers;
+    std::vector<std::weak_ptr<Transfer>> started;
+    size_t startedCapacity { 64 };
+    bool refuseNew { false };
+
+    std::thread loopThread;
+    std::vector<std::thread> helperThreads;
+    std::atomic<bool> shouldExit { false };
+
+    std::atomic<int64> totalBytesReceived { 0 };
+    std::atomic<int> numActive { 0 };
+    std::atomic<int> numRequests { 0 };
+    std::atomic<int> numConnectionsOpened { 0 };
+    std::atomic<int> numUnpooledRequests { 0 };
+    std::atomic<int> numExtraHelperThreads { 0 };
+    std::atomic<int> numAbandonedHelpers { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (TransferEngine)
+};
+
+inline void Transfer::cancel()
+{
+    cancelled = true;
+    owner.wakeUp();
+}
+
+#endif  // TRANSFERENGINE_H_INCLUDED
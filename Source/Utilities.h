@@ -12,6 +12,12 @@
 #define UTILITIES_H_INCLUDED
 
 #include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 class JpmFatalExcepton
 {
@@ -25,26 +31,125 @@ public:
     String debugInfo;
 };
 
+/**
+ * Where the print functions write.  Commands that produce machine readable
+ * output on stdout point this at std::cerr so the two don't mix.
+ */
+inline std::ostream*& messageStream()
+{
+    static std::ostream* stream = &std::cout;
+    return stream;
+}
+
+/**
+ * The width of the progress line on the terminal, or 0 when there isn't
+ * one.  Messages blank it out before printing and Progress draws it again.
+ */
+inline std::atomic<int>& progressLineWidth()
+{
+    static std::atomic<int> width (0);
+    return width;
+}
+
+/**
+ * Held while writing a line of output, so a message and the progress line
+ * being redrawn on another thread don't end up interleaved.  It's recursive
+ * so the print functions can clear the progress line while holding it.
+ */
+inline std::recursive_mutex& outputLock()
+{
+    static std::recursive_mutex lock;
+    return lock;
+}
+
+inline void clearProgressLine()
+{
+    std::lock_guard<std::recursive_mutex> lock (outputLock());
+    const int width = progressLineWidth().exchange (0);
+
+    if (width > 0)
+        *messageStream() << '\r' << std::string ((size_t) width, ' ') << '\r';
+}
+
 inline void printHeading (const String& s)
 {
-    std::cout << "jpm ****** " << s << std::endl;
+    std::lock_guard<std::recursive_mutex> lock (outputLock());
+    clearProgressLine();
+    *messageStream() << "jpm ****** " << s << std::endl;
 }
 
 inline void printWarning (const String& s)
 {
-    std::cout << "jpm -    : " << s << std::endl;
+    std::lock_guard<std::recursive_mutex> lock (outputLock());
+    clearProgressLine();
+    *messageStream() << "jpm -    : " << s << std::endl;
 }
 
 inline void printInfo (const String& s)
 {
-    std::cout << "jpm      : " << s << std::endl;
+    std::lock_guard<std::recursive_mutex> lock (outputLock());
+    clearProgressLine();
+    *messageStream() << "jpm      : " << s << std::endl;
 }
 
 inline void printError (const String& s)
 {
-    std::cout << "jpm error: " << s << std::endl;
+    std::lock_guard<std::recursive_mutex> lock (outputLock());
+    clearProgressLine();
+    *messageStream() << "jpm error: " << s << std::endl;
+}
+
+inline String formatBytes (int64 bytes)
+{
+    if (bytes < 1024 * 1024)
+        return String (bytes / 1024.0, 1) + "KB";
+
+    return String (bytes / (1024.0 * 1024.0), 1) + "MB";
+}
+
+inline String trimSlashes (String text)
+{
+    if (text.endsWithChar ('/'))
+        text = text.dropLastCharacters (1);
+
+    if (text.startsWithChar ('/'))
+        return text.substring (1);
+
+    return text;
 }
 
+/**
+ * Runs function (i) for every i in [0, numItems) spread across up to
+ * numThreads threads.  Items are handed out in index order, so callers that
+ * sort their work largest-first get reasonable load balancing for free.
+ */
+inline void parallelFor (int numItems, int numThreads, std::function<void (int)> function)
+{
+    numThreads = jlimit (1, jmax (1, numItems), numThreads);
+
+    if (numThreads == 1)
+    {
+        for (int i = 0; i < numItems; ++i)
+            function (i);
+
+        return;
+    }
+
+    std::atomic<int> next (0);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < numThreads; ++t)
+    {
+        threads.push_back (std::thread ([&]()
+        {
+            for (int i = next++; i < numItems; i = next++)
+                function (i);
+        }));
+    }
+
+    for (auto& t : threads)
+        t.join();
+}
 
 /** Provides an STL compatible iterator for the children of ValueTree. */
 class ValueTreeChildrenConnector
@@ -0,0 +1,221 @@
+/*
+  ==============================================================================
+
+    Workspace.h
+    Created: 21 Oct 2026 11:48:26am
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef WORKSPACE_H_INCLUDED
+#define WORKSPACE_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "Project.h"
+#include <map>
+#include <mutex>
+#include <vector>
+
+/**
+ * Installs many projects at once - `jpm install --workspace`.
+ *
+ * The projects are listed in jpm.workspace.xml at the workspace root:
+ *
+ *   <jpm_workspace>
+ *     <project path="apps/synth"/>
+ *     <project path="plugins/delay"/>
+ *   </jpm_workspace>
+ *
+ * or, without one, are every folder below the root with a jpmfile.xml.
+ *
+ * Everything runs in one process, sharing the directory, the download cache
+ * and the transfer engine.  All the projects are resolved first; then each
+ * distinct module version that any of them is missing is fetched once, all
+ * in parallel; then every project installs from those fetches and has its
+ * jucer and config rewritten, again in parallel.
+ */
+class Workspace
+{
+public:
+    Workspace (const File& root_)
+        :
+        root (root_)
+    {}
+
+    Array<File> findProjects() const
+    {
+        Array<File> projects;
+        auto workspaceFile = root.getChildFile ("jpm.workspace.xml");
+
+        if (workspaceFile.existsAsFile())
+        {
+            ScopedPointer<XmlElement> xml = XmlDocument (workspaceFile).getDocumentElement();
+
+            if (xml == nullptr)
+                throw JpmFatalExcepton ("cannot parse " + workspaceFile.getFullPathName(), String());
+
+            forEachXmlChildElementWithTagName (*xml, e, "project")
+                projects.add (root.getChildFile (e->getStringAttribute ("path")));
+
+            return projects;
+        }
+
+        findProjectsBelow (root, 0, projects);
+        return projects;
+    }
+
+    void install (DependencyResolver::Lookup lookup)
+    {
+        auto folders = findProjects();
+        printHeading ("workspace: " + String (folders.size()) + " projects in " + root.getFullPathName());
+
+        /* The directory is shared, so lookups from different projects take turns. */
+        std::mutex lookupLock;
+
+        auto sharedLookup = [&lookupLock, lookup] (const String& name)
+        {
+            std::lock_guard<std::mutex> lock (lookupLock);
+            return lookup (name);
+        };
+
+        OwnedArray<Project> projects;
+        OwnedArray<DependencyResolver> resolvers;
+        StringArray errors;
+
+        for (auto& f : folders)
+        {
+            projects.add (new Project (f));
+            resolvers.add (new DependencyResolver (f.getChildFile ("jpm_modules"), sharedLookup));
+            errors.add (String());
+        }
+
+        /* Anything a lock doesn't cover is fetched while resolving; the download
+         * cache makes a second fetch of the same archive wait for the first. */
+        parallelFor (projects.size(), maxParallelProjects, [&] (int i)
+        {
+            auto result = projects[i]->resolve (*resolvers[i]);
+
+            if (result.failed())
+                errors.set (i, result.getErrorMessage());
+        });
+
+        fetchMissing (resolvers, errors);
+
+        parallelFor (projects.size(), maxParallelProjects, [&] (int i)
+        {
+            if (errors[i].isEmpty())
+            {
+                auto result = resolvers[i]->install();
+
+                if (result.failed())
+                    errors.set (i, result.getErrorMessage());
+            }
+
+            projects[i]->rebuildJucerModuleList();
+        });
+
+        resolvers.clear();
+
+        /* Each project saves its jucer and config as it's deleted. */
+        parallelFor (projects.size(), maxParallelProjects, [&] (int i)
+        {
+            delete projects.getUnchecked (i);
+        });
+
+        projects.clear (false);
+
+        int numFailed = 0;
+
+        for (int i = 0; i < folders.size(); ++i)
+        {
+            if (errors[i].isNotEmpty())
+            {
+                printError (folders[i].getRelativePathFrom (root) + ": " + errors[i]);
+                ++numFailed;
+            }
+        }
+
+        printInfo ("installed " + String (folders.size() - numFailed) + " of " + String (folders.size()) + " projects");
+    }
+
+    static const int maxParallelProjects = 4;
+    static const int maxParallelFetches = 16;
+
+private:
+    /** Fetches the union of what the projects are missing, each distinct module version once. */
+    void fetchMissing (OwnedArray<DependencyResolver>& resolvers, const StringArray& errors)
+    {
+        std::map<String, Array<DependencyResolver::Node*>> byVersion;
+        int numWanted = 0;
+
+        for (int i = 0; i < resolvers.size(); ++i)
+        {
+            if (errors[i].isNotEmpty())
+                continue;
+
+            for (auto* n : resolvers[i]->getNodesToFetch())
+            {
+                auto& m = n->module;
+                byVersion[m.getSource() + " " + m.getPath() + " " + m.getVersion() + " " + m.getSubPath()].add (n);
+                ++numWanted;
+            }
+        }
+
+        if (byVersion.empty())
+            return;
+
+        printInfo ("fetching " + String ((int) byVersion.size()) + " distinct module versions for "
+                   + String (numWanted) + " installs");
+
+        std::vector<Array<DependencyResolver::Node*>*> groups;
+
+        for (auto& entry : byVersion)
+            groups.push_back (&entry.second);
+
+        parallelFor ((int) groups.size(), maxParallelFetches, [&groups] (int i)
+        {
+            auto& group = *groups[(size_t) i];
+            auto* first = group[0];
+            auto source = first->module.fetch();
+
+            for (auto* n : group)
+            {
+                n->source = source;
+                n->module.setVersion (first->module.getVersion());
+            }
+        });
+    }
+
+    static void findProjectsBelow (const File& folder, int depth, Array<File>& projects)
+    {
+        if (folder.getChildFile ("jpmfile.xml").existsAsFile())
+            projects.add (folder);
+
+        if (depth >= maxSearchDepth)
+            return;
+
+        Array<File> children;
+        folder.findChildFiles (children, File::findDirectories, false, "*");
+        children.sort();
+
+        for (auto& c : children)
+        {
+            auto name = c.getFileName();
+
+            /* Nothing in these holds a project, and jpm_modules can be huge. */
+            if (name.startsWithChar ('.') || name == "jpm_modules" || name == "Builds"
+                || name == "JuceLibraryCode" || name == "node_modules" || c.isSymbolicLink())
+                continue;
+
+            findProjectsBelow (c, depth + 1, projects);
+        }
+    }
+
+    static const int maxSearchDepth = 6;
+
+    File root;
+};
+
+#endif  // WORKSPACE_H_INCLUDED
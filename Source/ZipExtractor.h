@@ -0,0 +1,167 @@
+/*
+  ==============================================================================
+
+    ZipExtractor.h
+    Created: 19 Oct 2026 10:03:41am
+    Author:  Jim Credland
+
+  ==============================================================================
+*/
+
+#ifndef ZIPEXTRACTOR_H_INCLUDED
+#define ZIPEXTRACTOR_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Utilities.h"
+#include "Trace.h"
+#include "RunReport.h"
+#include <algorithm>
+
+/**
+ * Lets every worker open its own stream onto an archive that is already in
+ * memory, which is what allows ZipFile to inflate entries concurrently.
+ */
+class MemoryBlockInputSource
+    :
+    public InputSource
+{
+public:
+    MemoryBlockInputSource (const MemoryBlock& data_) : data (data_) {}
+
+    InputStream* createInputStream() override
+    {
+        return new MemoryInputStream (data, false);
+    }
+
+    InputStream* createInputStreamFor (const String&) override
+    {
+        return nullptr;
+    }
+
+    int64 hashCode() const override
+    {
+        return (int64) data.getSize();
+    }
+
+private:
+    const MemoryBlock& data;
+};
+
+/**
+ * Parallel replacement for ZipFile::uncompressTo().
+ *
+ * The central directory is read once, every folder the archive needs is
+ * created up front in depth order, and then the entries are inflated on a
+ * thread per core, largest first.
+ */
+class ZipExtractor
+{
+public:
+    ZipExtractor (int numThreads_ = SystemStats::getNumCpus())
+        :
+        numThreads (jmax (1, numThreads_))
+    {}
+
+    /** The MemoryBlock must stay alive until this returns. */
+    Result extract (const MemoryBlock& archive, const File& targetDirectory)
+    {
+        return extract (new MemoryBlockInputSource (archive), targetDirectory);
+    }
+
+    Result extract (const File& archive, const File& targetDirectory)
+    {
+        return extract (new FileInputSource (archive), targetDirectory);
+    }
+
+    /** Takes ownership of the source. */
+    Result extract (InputSource* source, const File& targetDirectory)
+    {
+        TraceSpan span ("unzip", "extract");
+        RunReport::Phase phase ("extract");
+        ZipFile zip (source);
+
+        if (zip.getNumEntries() == 0)
+            return Result::fail ("archive is empty or not a zip file");
+
+        /* Folders first and shallowest first, so no two workers ever race to
+         * create the same parent. */
+        StringArray folders;
+        Array<Entry> files;
+
+        for (int i = 0; i < zip.getNumEntries(); ++i)
+        {
+            auto* entry = zip.getEntry (i);
+            auto name = entry->filename;
+
+            if (name.endsWithChar ('/'))
+            {
+                folders.addIfNotAlreadyThere (name.dropLastCharacters (1));
+                continue;
+            }
+
+            if (name.containsChar ('/'))
+                folders.addIfNotAlreadyThere (name.upToLastOccurrenceOf ("/", false, false));
+
+            Entry e;
+            e.index = i;
+            e.size = entry->uncompressedSize;
+            files.add (e);
+        }
+
+        std::sort (folders.begin(), folders.end(), [] (const String & a, const String & b)
+        {
+            return a.length() < b.length();
+        });
+
+        for (auto& f : folders)
+        {
+            auto result = targetDirectory.getChildFile (f).createDirectory();
+
+            if (result.failed())
+                return result;
+        }
+
+        std::sort (files.begin(), files.end(),
+                   [] (const Entry & a, const Entry & b) { return a.size > b.size; });
+
+        int64 numBytes = 0;
+
+        for (auto& f : files)
+            numBytes += f.size;
+
+        span.setArg ("files", files.size());
+        span.setArg ("bytes", numBytes);
+
+        CriticalSection errorLock;
+        Result firstError (Result::ok());
+
+        parallelFor (files.size(), numThreads, [&] (int i)
+        {
+            auto result = zip.uncompressEntry (files.getReference (i).index, targetDirectory, true);
+
+            if (result.failed())
+            {
+                const ScopedLock sl (errorLock);
+
+                if (firstError.wasOk())
+                    firstError = result;
+            }
+        });
+
+        if (firstError.wasOk())
+            RunReport::getInstance().addExtracted (files.size(), numBytes);
+
+        return firstError;
+    }
+
+private:
+    struct Entry
+    {
+        int index;
+        int64 size;
+    };
+
+    int numThreads;
+};
+
+#endif  // ZIPEXTRACTOR_H_INCLUDED